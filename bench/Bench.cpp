@@ -0,0 +1,252 @@
+// ------------------------------------------------------------------
+// bench::Bench.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "Bench.hpp"
+#include "math/Algorithm.hpp"
+
+#include <cstdio>
+#include <thread>
+
+namespace stardazed {
+namespace bench {
+
+
+namespace {
+
+	constexpr uint64 maxIterations = 1000000000;
+
+
+	void appendJSONString(std::string& json, const std::string& str) {
+		json += '"';
+		for (auto c : str) {
+			if (c == '"' || c == '\\') {
+				json += '\\';
+			}
+			json += c;
+		}
+		json += '"';
+	}
+
+
+	void appendJSONNumber(std::string& json, double value) {
+		char buf[48];
+		snprintf(buf, sizeof(buf), "%.6g", value);
+		json += buf;
+	}
+
+
+	std::string resultsJSON(const std::vector<Result>& results, const Options& options) {
+		std::string json = "{\n\"context\":{";
+		json += "\"compiler\":";
+		appendJSONString(json, __VERSION__);
+#ifdef NDEBUG
+		json += ",\"build\":\"release\"";
+#else
+		json += ",\"build\":\"debug\"";
+#endif
+		json += ",\"hardwareThreads\":";
+		appendJSONNumber(json, std::thread::hardware_concurrency());
+		json += ",\"minTimeSeconds\":";
+		appendJSONNumber(json, options.minTime);
+		json += "},\n\"benchmarks\":[";
+
+		for (uint r = 0; r < results.size(); ++r) {
+			const auto& result = results[r];
+			if (r > 0) {
+				json += ',';
+			}
+			json += "\n{\"name\":";
+			appendJSONString(json, result.name);
+			json += ",\"iterations\":";
+			appendJSONNumber(json, result.iterations);
+			json += ",\"totalSeconds\":";
+			appendJSONNumber(json, time::asSeconds(result.totalTime));
+			json += ",\"nsPerIteration\":";
+			appendJSONNumber(json, result.nsPerIteration);
+			json += ",\"itemsPerSecond\":";
+			appendJSONNumber(json, result.itemsPerSecond);
+			json += ",\"bytesPerSecond\":";
+			appendJSONNumber(json, result.bytesPerSecond);
+			if (! result.counters.empty()) {
+				json += ",\"counters\":{";
+				for (uint c = 0; c < result.counters.size(); ++c) {
+					if (c > 0) {
+						json += ',';
+					}
+					appendJSONString(json, result.counters[c].first);
+					json += ':';
+					appendJSONNumber(json, result.counters[c].second);
+				}
+				json += '}';
+			}
+			json += '}';
+		}
+
+		json += "\n]}\n";
+		return json;
+	}
+
+} // anonymous namespace
+
+
+State::State(uint64 iterations, uint64 arg)
+: iterations_(iterations)
+, remaining_(iterations)
+, arg_(arg)
+{}
+
+
+void State::start() {
+	running_ = true;
+	startTime_ = time::now();
+}
+
+
+void State::stop() {
+	if (running_) {
+		elapsed_ += time::now() - startTime_;
+		running_ = false;
+	}
+}
+
+
+void State::pauseTiming() {
+	assert(running_);
+	elapsed_ += time::now() - startTime_;
+}
+
+
+void State::resumeTiming() {
+	assert(running_);
+	startTime_ = time::now();
+}
+
+
+void State::setCounter(const std::string& name, double value) {
+	for (auto& counter : counters_) {
+		if (counter.first == name) {
+			counter.second = value;
+			return;
+		}
+	}
+	counters_.emplace_back(name, value);
+}
+
+
+void Registry::add(const std::string& name, const BenchmarkFn& fn) {
+	benchmarks_.push_back({ name, 0, fn });
+}
+
+
+void Registry::add(const std::string& name, std::initializer_list<uint64> args, const BenchmarkFn& fn) {
+	for (auto arg : args) {
+		benchmarks_.push_back({ name + '/' + std::to_string(arg), arg, fn });
+	}
+}
+
+
+void Registry::addCheck(const std::string& name, const CheckFn& fn) {
+	checks_.push_back({ name, fn });
+}
+
+
+Result Registry::run(const Benchmark& benchmark, Time minTime) const {
+	uint64 iterations = 1;
+
+	for (;;) {
+		State state { iterations, benchmark.arg };
+		benchmark.fn(state);
+		assert(state.elapsed() > 0 && "benchmark did not run its keepRunning() loop");
+
+		if (state.elapsed() >= minTime || iterations >= maxIterations) {
+			auto ns = time::asNanoseconds(state.elapsed());
+			auto seconds = time::asSeconds(state.elapsed());
+			return {
+				benchmark.name,
+				iterations,
+				state.elapsed(),
+				ns / iterations,
+				(iterations * state.itemsPerIteration()) / seconds,
+				(iterations * state.bytesPerIteration()) / seconds,
+				state.counters()
+			};
+		}
+
+		// aim a bit past the minimum time, but grow at most 100x per round as
+		// short runs give poor estimates
+		auto scale = (minTime * 1.4) / math::max(state.elapsed(), time::fromNanoseconds(1));
+		auto next = static_cast<uint64>(iterations * math::clamp(scale, 2.0, 100.0));
+		iterations = math::min(next, maxIterations);
+	}
+}
+
+
+int Registry::runAll(const Options& options) const {
+	std::vector<Result> results;
+
+	for (const auto& benchmark : benchmarks_) {
+		if (! options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos) {
+			continue;
+		}
+		if (options.list) {
+			printf("%s\n", benchmark.name.c_str());
+			continue;
+		}
+
+		auto result = run(benchmark, options.minTime);
+		fprintf(stderr, "%-52s %14.1f ns %12llu iterations", result.name.c_str(), result.nsPerIteration, static_cast<unsigned long long>(result.iterations));
+		for (const auto& counter : result.counters) {
+			fprintf(stderr, "  %s %.3g", counter.first.c_str(), counter.second);
+		}
+		fprintf(stderr, "\n");
+		results.push_back(result);
+	}
+
+	if (options.list) {
+		return 0;
+	}
+
+	auto json = resultsJSON(results, options);
+	if (options.outPath.empty()) {
+		fwrite(json.data(), 1, json.size(), stdout);
+		return 0;
+	}
+
+	auto file = fopen(options.outPath.c_str(), "w");
+	if (! file) {
+		fprintf(stderr, "Could not open %s to write the results\n", options.outPath.c_str());
+		return 1;
+	}
+	auto written = fwrite(json.data(), 1, json.size(), file);
+	fclose(file);
+	return written == json.size() ? 0 : 1;
+}
+
+
+int Registry::runChecks(const Options& options) const {
+	uint32 failed = 0;
+
+	for (const auto& check : checks_) {
+		if (! options.filter.empty() && check.name.find(options.filter) == std::string::npos) {
+			continue;
+		}
+		if (options.list) {
+			printf("%s\n", check.name.c_str());
+			continue;
+		}
+
+		auto passed = check.fn();
+		fprintf(stderr, "%-52s %s\n", check.name.c_str(), passed ? "ok" : "FAILED");
+		if (! passed) {
+			++failed;
+		}
+	}
+
+	return failed == 0 ? 0 : 1;
+}
+
+
+} // ns bench
+} // ns stardazed
@@ -0,0 +1,169 @@
+// ------------------------------------------------------------------
+// bench::Bench - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_BENCH_BENCH_H
+#define SD_BENCH_BENCH_H
+
+#include "system/Config.hpp"
+#include "system/Time.hpp"
+#include "util/ConceptTraits.hpp"
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace stardazed {
+namespace bench {
+
+
+// Passed to a benchmark function, which does its setup and then runs the
+// timed part in a keepRunning() loop:
+//
+//   Array<float> values;
+//   while (state.keepRunning()) {
+//       values.append(1.f);
+//   }
+//
+// The harness calls the function with increasing iteration counts until the
+// timed loop runs for at least the minimum time, so setup code runs more than
+// once. Untimed work inside the loop goes between pauseTiming/resumeTiming.
+
+class State {
+	uint64 iterations_, remaining_;
+	uint64 arg_;
+	uint64 itemsPerIteration_ = 1;
+	uint64 bytesPerIteration_ = 0;
+	Time startTime_ = 0, elapsed_ = 0;
+	bool running_ = false;
+	std::vector<std::pair<std::string, double>> counters_;
+
+	void start();
+	void stop();
+
+public:
+	State(uint64 iterations, uint64 arg);
+	SD_NOCOPYORMOVE_CLASS(State)
+
+	bool keepRunning() {
+		if (__builtin_expect(remaining_ > 0, 1)) {
+			if (__builtin_expect(! running_, 0)) {
+				start();
+			}
+			--remaining_;
+			return true;
+		}
+		stop();
+		return false;
+	}
+
+	void pauseTiming();
+	void resumeTiming();
+
+	uint64 iterations() const { return iterations_; }
+	// the scale the benchmark was registered with, 0 if it has none
+	uint64 arg() const { return arg_; }
+	Time elapsed() const { return elapsed_; }
+
+	// counts reported as items and bytes per second, items default to 1
+	uint64 itemsPerIteration() const { return itemsPerIteration_; }
+	void setItemsPerIteration(uint64 items) { itemsPerIteration_ = items; }
+	uint64 bytesPerIteration() const { return bytesPerIteration_; }
+	void setBytesPerIteration(uint64 bytes) { bytesPerIteration_ = bytes; }
+
+	// extra named measurements reported alongside the timing, e.g. probe lengths
+	const std::vector<std::pair<std::string, double>>& counters() const { return counters_; }
+	void setCounter(const std::string& name, double value);
+};
+
+
+using BenchmarkFn = std::function<void(State&)>;
+
+// A correctness check run by --check instead of the benchmarks. It prints
+// what it compared and returns false if any result was out of tolerance.
+using CheckFn = std::function<bool()>;
+
+
+struct Result {
+	std::string name;
+	uint64 iterations;
+	Time totalTime;
+	double nsPerIteration, itemsPerSecond, bytesPerSecond;
+	std::vector<std::pair<std::string, double>> counters;
+};
+
+
+struct Options {
+	std::string filter;     // run only benchmarks whose name contains this
+	std::string outPath;    // JSON results go to stdout if empty
+	std::string dataPath = "stardazed-bench-data"; // generated asset files
+	Time minTime = 0.25;
+	bool list = false;
+	bool check = false;     // run the checks instead of the benchmarks
+};
+
+
+class Registry {
+	struct Benchmark {
+		std::string name;
+		uint64 arg;
+		BenchmarkFn fn;
+	};
+
+	struct Check {
+		std::string name;
+		CheckFn fn;
+	};
+
+	std::vector<Benchmark> benchmarks_;
+	std::vector<Check> checks_;
+	std::string dataPath_;
+
+	Result run(const Benchmark&, Time minTime) const;
+
+public:
+	// a benchmark named "group/name", registered once per arg as "group/name/arg"
+	void add(const std::string& name, const BenchmarkFn& fn);
+	void add(const std::string& name, std::initializer_list<uint64> args, const BenchmarkFn& fn);
+
+	// directory benchmarks can write their input files to, set before registration
+	const std::string& dataPath() const { return dataPath_; }
+	void setDataPath(const std::string& path) { dataPath_ = path; }
+
+	// a check named "group/name", filtered like the benchmarks
+	void addCheck(const std::string& name, const CheckFn& fn);
+
+	int runAll(const Options&) const;
+	int runChecks(const Options&) const;
+};
+
+
+// -- keep the compiler from discarding benchmarked values and stores
+
+template <typename T>
+inline void doNotOptimize(const T& value) {
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobberMemory() {
+	asm volatile("" : : : "memory");
+}
+
+
+// -- benchmark groups, each in their own file
+void registerContainerBenchmarks(Registry&);
+void registerMemoryBenchmarks(Registry&);
+void registerMathBenchmarks(Registry&);
+void registerSceneBenchmarks(Registry&);
+void registerPhysicsBenchmarks(Registry&);
+void registerRuntimeBenchmarks(Registry&);
+void registerModelBenchmarks(Registry&);
+void registerImageBenchmarks(Registry&);
+
+
+} // ns bench
+} // ns stardazed
+
+#endif
@@ -0,0 +1,333 @@
+// ------------------------------------------------------------------
+// bench::ContainerBench.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "Bench.hpp"
+#include "container/Array.hpp"
+#include "container/Deque.hpp"
+#include "container/RingBuffer.hpp"
+#include "container/HashMap.hpp"
+#include "container/FlatHashMap.hpp"
+#include "container/SparseSet.hpp"
+#include "math/Matrix.hpp"
+
+#include <utility>
+
+namespace stardazed {
+namespace bench {
+
+
+namespace {
+
+	// entity-index-like keys 0..count-1 in a fixed shuffled order
+	Array<uint32> shuffledKeys(uint32 count) {
+		Array<uint32> keys;
+		keys.resizeUninitialized(count);
+		for (uint32 k = 0; k < count; ++k) {
+			keys[k] = k;
+		}
+
+		uint32 seed = 0x2545F491;
+		for (uint32 k = count - 1; k > 0; --k) {
+			seed = seed * 1664525 + 1013904223;
+			std::swap(keys[k], keys[seed % (k + 1)]);
+		}
+		return keys;
+	}
+
+
+	// HashMap, FlatHashMap and SparseSet share insert/find/remove
+	template <typename Map>
+	void addMapBenchmarks(Registry& registry, const std::string& name, std::initializer_list<uint64> sizes) {
+		registry.add(name + "/insert", sizes, [](State& state) {
+			auto keys = shuffledKeys(static_cast<uint32>(state.arg()));
+			while (state.keepRunning()) {
+				Map map;
+				for (auto key : keys) {
+					map.insert(key, key);
+				}
+				doNotOptimize(map.count());
+			}
+			state.setItemsPerIteration(keys.count());
+		});
+
+		registry.add(name + "/findHit", sizes, [](State& state) {
+			auto keys = shuffledKeys(static_cast<uint32>(state.arg()));
+			Map map;
+			for (auto key : keys) {
+				map.insert(key, key);
+			}
+
+			while (state.keepRunning()) {
+				uint64 sum = 0;
+				for (auto key : keys) {
+					sum += *map.find(key);
+				}
+				doNotOptimize(sum);
+			}
+			state.setItemsPerIteration(keys.count());
+		});
+
+		registry.add(name + "/findMiss", sizes, [](State& state) {
+			auto keys = shuffledKeys(static_cast<uint32>(state.arg()));
+			auto missOffset = keys.count();
+			Map map;
+			for (auto key : keys) {
+				map.insert(key, key);
+			}
+
+			while (state.keepRunning()) {
+				uint32 found = 0;
+				for (auto key : keys) {
+					found += map.find(key + missOffset) != nullptr;
+				}
+				doNotOptimize(found);
+			}
+			state.setItemsPerIteration(keys.count());
+		});
+
+		registry.add(name + "/remove", sizes, [](State& state) {
+			auto keys = shuffledKeys(static_cast<uint32>(state.arg()));
+			while (state.keepRunning()) {
+				state.pauseTiming();
+				Map map;
+				for (auto key : keys) {
+					map.insert(key, key);
+				}
+				state.resumeTiming();
+
+				for (auto key : keys) {
+					map.remove(key);
+				}
+				doNotOptimize(map.count());
+			}
+			state.setItemsPerIteration(keys.count());
+		});
+	}
+
+
+
+	// FlatHashMap filled to exactly its growth limit for a max load factor given
+	// in percent, so every run measures the table at the load it is allowed to reach
+	constexpr uint32 loadFactorBucketCount = 128 * 1024;
+
+	void fillToMaxLoad(FlatHashMap<uint32, uint32>& map, const Array<uint32>& keys) {
+		for (auto key : keys) {
+			map.insert(key, key);
+		}
+		assert(map.bucketCount() == loadFactorBucketCount);
+	}
+
+	Array<uint32> maxLoadKeys(State& state) {
+		auto maxLoad = static_cast<float>(state.arg()) / 100.f;
+		return shuffledKeys(static_cast<uint32>(loadFactorBucketCount * maxLoad));
+	}
+
+	void reportProbeStats(State& state, const FlatHashMap<uint32, uint32>& map) {
+		auto probes = map.probeStats();
+		state.setCounter("loadFactor", probes.loadFactor);
+		state.setCounter("avgProbeLength", probes.averageProbeLength);
+		state.setCounter("maxProbeLength", probes.maxProbeLength);
+	}
+
+
+	void addFlatHashMapLoadBenchmarks(Registry& registry, std::initializer_list<uint64> maxLoadPercents) {
+		registry.add("container/FlatHashMap/maxLoad/insert", maxLoadPercents, [](State& state) {
+			auto keys = maxLoadKeys(state);
+			while (state.keepRunning()) {
+				state.pauseTiming();
+				FlatHashMap<uint32, uint32> map;
+				map.setMaxLoadFactor(state.arg() / 100.f);
+				map.rehash(loadFactorBucketCount);
+				state.resumeTiming();
+
+				fillToMaxLoad(map, keys);
+				doNotOptimize(map.count());
+
+				state.pauseTiming();
+				reportProbeStats(state, map);
+				state.resumeTiming();
+			}
+			state.setItemsPerIteration(keys.count());
+		});
+
+		registry.add("container/FlatHashMap/maxLoad/findHit", maxLoadPercents, [](State& state) {
+			auto keys = maxLoadKeys(state);
+			FlatHashMap<uint32, uint32> map;
+			map.setMaxLoadFactor(state.arg() / 100.f);
+			map.rehash(loadFactorBucketCount);
+			fillToMaxLoad(map, keys);
+			reportProbeStats(state, map);
+
+			while (state.keepRunning()) {
+				uint64 sum = 0;
+				for (auto key : keys) {
+					sum += *map.find(key);
+				}
+				doNotOptimize(sum);
+			}
+			state.setItemsPerIteration(keys.count());
+		});
+
+		registry.add("container/FlatHashMap/maxLoad/findMiss", maxLoadPercents, [](State& state) {
+			auto keys = maxLoadKeys(state);
+			auto missOffset = loadFactorBucketCount;
+			FlatHashMap<uint32, uint32> map;
+			map.setMaxLoadFactor(state.arg() / 100.f);
+			map.rehash(loadFactorBucketCount);
+			fillToMaxLoad(map, keys);
+			reportProbeStats(state, map);
+
+			while (state.keepRunning()) {
+				uint32 found = 0;
+				for (auto key : keys) {
+					found += map.find(key + missOffset) != nullptr;
+				}
+				doNotOptimize(found);
+			}
+			state.setItemsPerIteration(keys.count());
+		});
+	}
+
+} // anonymous namespace
+
+
+void registerContainerBenchmarks(Registry& registry) {
+	// -- Array
+
+	registry.add("container/Array/append", { 1000, 100000 }, [](State& state) {
+		auto count = static_cast<uint32>(state.arg());
+		while (state.keepRunning()) {
+			Array<math::Vec3> items;
+			for (uint32 i = 0; i < count; ++i) {
+				items.append({ float(i), 0, 1 });
+			}
+			doNotOptimize(items.elementsBasePtr());
+		}
+		state.setItemsPerIteration(count);
+	});
+
+	registry.add("container/Array/appendReserved", { 1000, 100000 }, [](State& state) {
+		auto count = static_cast<uint32>(state.arg());
+		while (state.keepRunning()) {
+			Array<math::Vec3> items;
+			items.reserve(count);
+			for (uint32 i = 0; i < count; ++i) {
+				items.append({ float(i), 0, 1 });
+			}
+			doNotOptimize(items.elementsBasePtr());
+		}
+		state.setItemsPerIteration(count);
+	});
+
+	// the resize benchmarks use float arrays as resizeUninitialized requires trivial types
+	registry.add("container/Array/resize", { 10000, 100000, 1000000 }, [](State& state) {
+		auto count = static_cast<uint32>(state.arg());
+		Array<float> items;
+		while (state.keepRunning()) {
+			items.resize(count);
+			doNotOptimize(items.elementsBasePtr());
+			items.clear();
+		}
+		state.setItemsPerIteration(count);
+	});
+
+	registry.add("container/Array/resizeUninitialized", { 10000, 100000, 1000000 }, [](State& state) {
+		auto count = static_cast<uint32>(state.arg());
+		Array<float> items;
+		while (state.keepRunning()) {
+			items.resizeUninitialized(count);
+			doNotOptimize(items.elementsBasePtr());
+			items.clear();
+		}
+		state.setItemsPerIteration(count);
+	});
+
+	registry.add("container/Array/iterate", { 1000, 100000 }, [](State& state) {
+		auto count = static_cast<uint32>(state.arg());
+		Array<float> items;
+		for (uint32 i = 0; i < count; ++i) {
+			items.append(float(i & 255));
+		}
+
+		while (state.keepRunning()) {
+			float sum = 0;
+			for (auto f : items) {
+				sum += f;
+			}
+			doNotOptimize(sum);
+		}
+		state.setItemsPerIteration(count);
+		state.setBytesPerIteration(count * sizeof(float));
+	});
+
+
+	// -- Deque
+
+	registry.add("container/Deque/appendPopFront", { 1000, 100000 }, [](State& state) {
+		auto count = static_cast<uint32>(state.arg());
+		Deque<uint64> queue;
+		while (state.keepRunning()) {
+			for (uint32 i = 0; i < count; ++i) {
+				queue.append(i);
+			}
+			uint64 sum = 0;
+			while (! queue.empty()) {
+				sum += queue.front();
+				queue.popFront();
+			}
+			doNotOptimize(sum);
+		}
+		state.setItemsPerIteration(count);
+	});
+
+	registry.add("container/Deque/prependPopBack", { 1000, 100000 }, [](State& state) {
+		auto count = static_cast<uint32>(state.arg());
+		Deque<uint64> queue;
+		while (state.keepRunning()) {
+			for (uint32 i = 0; i < count; ++i) {
+				queue.prepend(i);
+			}
+			uint64 sum = 0;
+			while (! queue.empty()) {
+				sum += queue.back();
+				queue.popBack();
+			}
+			doNotOptimize(sum);
+		}
+		state.setItemsPerIteration(count);
+	});
+
+
+	// -- RingBuffer, a queue that stays at about half capacity
+
+	registry.add("container/RingBuffer/appendPopFront", { 1024, 65536 }, [](State& state) {
+		auto capacity = static_cast<uint32>(state.arg());
+		container::RingBuffer<uint64> ring { memory::SystemAllocator::sharedInstance(), capacity };
+		for (uint32 i = 0; i < capacity / 2; ++i) {
+			ring.append(i);
+		}
+
+		while (state.keepRunning()) {
+			for (uint32 i = 0; i < capacity; ++i) {
+				ring.append(i);
+				doNotOptimize(ring.front());
+				ring.popFront();
+			}
+		}
+		state.setItemsPerIteration(capacity);
+	});
+
+
+	// -- maps with uint32 keys
+
+	addMapBenchmarks<HashMap<uint32, uint32>>(registry, "container/HashMap", { 1000, 100000 });
+	addMapBenchmarks<FlatHashMap<uint32, uint32>>(registry, "container/FlatHashMap", { 1000, 100000 });
+	addFlatHashMapLoadBenchmarks(registry, { 25, 50, 75, 87, 95 });
+	addMapBenchmarks<SparseSet<uint32, uint32>>(registry, "container/SparseSet", { 1000, 100000 });
+}
+
+
+} // ns bench
+} // ns stardazed
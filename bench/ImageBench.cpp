@@ -0,0 +1,111 @@
+// ------------------------------------------------------------------
+// bench::ImageBench.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "Bench.hpp"
+#include "render/common/PixelBuffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace stardazed {
+namespace bench {
+
+
+namespace {
+
+	// smooth gradients with some detail, written as an uncompressed 24-bit
+	// truecolor TGA, top row first
+	bool writeTestTGA(const std::string& path, uint32 dimension) {
+		std::vector<uint8> tga;
+		tga.reserve(18 + dimension * dimension * 3);
+
+		const uint8 header[18] = {
+			0, 0, 2,                   // no ident, no palette, uncompressed truecolor
+			0, 0, 0, 0, 0,             // no palette spec
+			0, 0, 0, 0,                // origin
+			uint8(dimension), uint8(dimension >> 8),
+			uint8(dimension), uint8(dimension >> 8),
+			24, 0x20                   // BGR, top-left origin
+		};
+		tga.insert(tga.end(), header, header + 18);
+
+		for (uint32 y = 0; y < dimension; ++y) {
+			for (uint32 x = 0; x < dimension; ++x) {
+				auto wave = std::sin(x * .05f) * std::cos(y * .07f);
+				auto grain = ((x * 7 + y * 13) ^ (x * y)) & 15;
+				tga.push_back(static_cast<uint8>(120 + wave * 100 + grain));
+				tga.push_back(static_cast<uint8>((y * 255) / dimension));
+				tga.push_back(static_cast<uint8>((x * 255) / dimension));
+			}
+		}
+
+		auto file = std::fopen(path.c_str(), "wb");
+		if (! file) {
+			return false;
+		}
+		auto written = std::fwrite(tga.data(), 1, tga.size(), file);
+		return (std::fclose(file) == 0) && written == tga.size();
+	}
+
+
+	// writes the input file once per run, the first time a benchmark needs it
+	std::string tgaInputFile(const std::string& dataPath, uint32 dimension) {
+		static std::vector<std::string> written_s;
+
+		auto path = dataPath + "/test-" + std::to_string(dimension) + ".tga";
+		if (std::find(written_s.begin(), written_s.end(), path) == written_s.end()) {
+			if (! writeTestTGA(path, dimension)) {
+				std::abort();
+			}
+			written_s.push_back(path);
+		}
+		return path;
+	}
+
+
+	// the PNG and JPG inputs are the same image as the TGA, checked in under
+	// bench/data as the engine has no encoders for compressed formats
+	std::string fixtureFile(const char* extension, uint32 dimension) {
+		return std::string(SD_BENCH_FIXTURE_PATH) + "/test-" + std::to_string(dimension) + '.' + extension;
+	}
+
+
+	template <typename Provider>
+	void decode(State& state, const std::string& path) {
+		auto dimension = static_cast<uint32>(state.arg());
+
+		while (state.keepRunning()) {
+			Provider provider { path };
+			doNotOptimize(provider.pixelBufferForLevel(0).data);
+		}
+		state.setItemsPerIteration(dimension * dimension);
+		state.setBytesPerIteration(dimension * dimension * 3);
+	}
+
+} // anonymous namespace
+
+
+// items are decoded pixels, bytes the size of the decoded RGB data
+void registerImageBenchmarks(Registry& registry) {
+	auto dataPath = registry.dataPath();
+
+	registry.add("image/decode/tga", { 256, 1024 }, [dataPath](State& state) {
+		decode<render::TGADataProvider>(state, tgaInputFile(dataPath, static_cast<uint32>(state.arg())));
+	});
+
+	registry.add("image/decode/png", { 256 }, [](State& state) {
+		decode<render::PNGDataProvider>(state, fixtureFile("png", static_cast<uint32>(state.arg())));
+	});
+
+	registry.add("image/decode/jpg", { 256 }, [](State& state) {
+		decode<render::JPGDataProvider>(state, fixtureFile("jpg", static_cast<uint32>(state.arg())));
+	});
+}
+
+
+} // ns bench
+} // ns stardazed
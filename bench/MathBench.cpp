@@ -0,0 +1,469 @@
+// ------------------------------------------------------------------
+// bench::MathBench.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "Bench.hpp"
+#include "math/Vector.hpp"
+#include "math/Matrix.hpp"
+#include "math/Quaternion.hpp"
+#include "math/TransformKernels.hpp"
+#include "math/Stream.hpp"
+#include "container/Array.hpp"
+#include "system/CPU.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+namespace stardazed {
+namespace bench {
+
+
+namespace {
+
+	using namespace math;
+
+	constexpr uint32 valuesPerRound = 1024;
+
+
+	// deterministic, varied inputs so results are not constant-folded
+	struct MathInputs {
+		Array<Vec3> positions, scales;
+		Array<Quat> rotations;
+		Array<Mat4> matrices;
+		Array<Vec4> vectors;
+
+		explicit MathInputs(uint32 count) {
+			positions.reserve(count);
+			scales.reserve(count);
+			rotations.reserve(count);
+			matrices.reserve(count);
+			vectors.reserve(count);
+
+			for (uint32 i = 0; i < count; ++i) {
+				auto f = float(i);
+				positions.append({ f * .25f, -f * .5f, f });
+				scales.append({ 1.f + (i % 3), 1.f, 1.f + (i % 5) * .1f });
+				rotations.append(Quat::fromEuler(Degrees{ f }, Degrees{ f * .3f }, Degrees{ f * .7f }));
+				Mat4 m;
+				composeTRS(positions.back(), rotations.back(), scales.back(), m);
+				matrices.append(m);
+				vectors.append({ f, 1.f, -f, 1.f });
+			}
+		}
+	};
+
+
+	using TRSKernel = void(*)(const Vec3*, const Quat*, const Vec3*, Mat4*, uint32);
+
+	void composeTRSBatch(State& state, TRSKernel kernel) {
+		auto count = static_cast<uint32>(state.arg());
+		MathInputs in { count };
+		Array<Mat4> out;
+		out.resize(count);
+
+		while (state.keepRunning()) {
+			kernel(in.positions.elementsBasePtr(), in.rotations.elementsBasePtr(), in.scales.elementsBasePtr(), out.elementsBasePtr(), count);
+			doNotOptimize(out.elementsBasePtr());
+		}
+		state.setItemsPerIteration(count);
+	}
+
+
+	// the Stream kernels, each run with a kernel pointer so scalar and AVX2 compare directly
+	using Vec3BinaryKernel = void(*)(const Vec3*, const Vec3*, Vec3*, uint32);
+	using AddScaledKernel = void(*)(const Vec3*, const Vec3*, float, Vec3*, uint32);
+	using NormalizeKernel = void(*)(const Vec3*, Vec3*, uint32);
+	using SlerpKernel = void(*)(const Quat*, const Quat*, float, Quat*, uint32);
+	using TransformPointsKernel = void(*)(const Mat4&, const Vec3*, Vec3*, uint32);
+
+	void addStreamBenchmarks(Registry& registry, const std::string& suffix,
+		Vec3BinaryKernel cross, AddScaledKernel addScaled, NormalizeKernel normalize, SlerpKernel slerp, TransformPointsKernel transformPoints)
+	{
+		registry.add("math/Stream/cross" + suffix, { 1000, 100000 }, [cross](State& state) {
+			auto count = static_cast<uint32>(state.arg());
+			MathInputs in { count };
+			Array<Vec3> out;
+			out.resize(count);
+
+			while (state.keepRunning()) {
+				cross(in.positions.elementsBasePtr(), in.scales.elementsBasePtr(), out.elementsBasePtr(), count);
+				doNotOptimize(out.elementsBasePtr());
+			}
+			state.setItemsPerIteration(count);
+		});
+
+		registry.add("math/Stream/addScaled" + suffix, { 1000, 100000 }, [addScaled](State& state) {
+			auto count = static_cast<uint32>(state.arg());
+			MathInputs in { count };
+			Array<Vec3> out;
+			out.resize(count);
+
+			while (state.keepRunning()) {
+				addScaled(in.positions.elementsBasePtr(), in.scales.elementsBasePtr(), 1.f / 60.f, out.elementsBasePtr(), count);
+				doNotOptimize(out.elementsBasePtr());
+			}
+			state.setItemsPerIteration(count);
+		});
+
+		registry.add("math/Stream/normalize" + suffix, { 1000, 100000 }, [normalize](State& state) {
+			auto count = static_cast<uint32>(state.arg());
+			MathInputs in { count };
+			Array<Vec3> out;
+			out.resize(count);
+
+			while (state.keepRunning()) {
+				normalize(in.scales.elementsBasePtr(), out.elementsBasePtr(), count);
+				doNotOptimize(out.elementsBasePtr());
+			}
+			state.setItemsPerIteration(count);
+		});
+
+		registry.add("math/Stream/slerp" + suffix, { 1000, 100000 }, [slerp](State& state) {
+			auto count = static_cast<uint32>(state.arg());
+			MathInputs in { count + 1 };
+			Array<Quat> out;
+			out.resize(count);
+
+			while (state.keepRunning()) {
+				slerp(in.rotations.elementsBasePtr(), in.rotations.elementsBasePtr() + 1, .3f, out.elementsBasePtr(), count);
+				doNotOptimize(out.elementsBasePtr());
+			}
+			state.setItemsPerIteration(count);
+		});
+
+		registry.add("math/Stream/transformPoints" + suffix, { 1000, 100000 }, [transformPoints](State& state) {
+			auto count = static_cast<uint32>(state.arg());
+			MathInputs in { count };
+			Array<Vec3> out;
+			out.resize(count);
+
+			while (state.keepRunning()) {
+				transformPoints(in.matrices[count / 2], in.positions.elementsBasePtr(), out.elementsBasePtr(), count);
+				doNotOptimize(out.elementsBasePtr());
+			}
+			state.setItemsPerIteration(count);
+		});
+	}
+
+
+
+	// -- SIMD overloads versus the scalar templates, which are selected by
+	// naming the template arguments explicitly
+
+#if SD_MATH_SIMD
+	// largest difference of a result component, relative to the scalar
+	// result but at least 1 so values near 0 are compared absolutely
+	class MaxError {
+		const char* name_;
+		float tolerance_;
+		float worst_ = 0;
+
+	public:
+		MaxError(const char* name, float tolerance)
+		: name_(name)
+		, tolerance_(tolerance)
+		{}
+
+		void compare(const float* simd, const float* scalar, uint32 count) {
+			for (uint32 i = 0; i < count; ++i) {
+				auto error = std::abs(simd[i] - scalar[i]) / max(std::abs(scalar[i]), 1.f);
+				// NaN compares false, report it as an infinite error
+				worst_ = (error <= worst_) ? worst_ : (error == error ? error : INFINITY);
+			}
+		}
+
+		bool report() const {
+			auto passed = worst_ <= tolerance_;
+			fprintf(stderr, "  %-24s max error %.3g, tolerance %.3g%s\n", name_, worst_, tolerance_, passed ? "" : "  <--");
+			return passed;
+		}
+	};
+
+
+	// general matrices with entries in [-8, 8] in addition to the TRS ones
+	// in MathInputs, with a fixed seed so failures reproduce
+	Array<Mat4> checkMatrices(const MathInputs& in) {
+		Array<Mat4> matrices;
+		matrices.reserve(in.matrices.count() * 2);
+		uint32 seed = 0x5eed;
+
+		for (const auto& m : in.matrices) {
+			matrices.append(m);
+			Mat4 general;
+			for (auto& f : general.data) {
+				seed = seed * 1664525 + 1013904223;
+				f = float(seed >> 8) / float(1 << 24) * 16.f - 8.f;
+			}
+			matrices.append(general);
+		}
+		return matrices;
+	}
+
+
+	bool checkSIMD() {
+		MathInputs in { valuesPerRound };
+		auto matrices = checkMatrices(in);
+		auto count = matrices.count();
+
+		// these are formed in the same order as the scalar templates, so must match exactly
+		MaxError multiply { "Mat4 * Mat4", 0 }, transform { "Mat4 * Vec4", 0 }, transposed { "transpose(Mat4)", 0 };
+		MaxError vecOps { "Vec4 + - * /", 0 };
+		// pairwise lane sums and reordered products round differently in the last bits
+		MaxError dots { "dot(Vec4)", 1e-6f }, quatMul { "Quat * Quat", 1e-6f }, toMatrix { "Quat::toMatrix4", 1e-6f };
+		// the block-wise inverse takes a different path than the cofactor expansion
+		MaxError inverted { "inverse(Mat4)", 2e-4f };
+
+		for (uint32 i = 0; i < count; ++i) {
+			const auto& a = matrices[i];
+			const auto& b = matrices[(i + 1) % count];
+			const auto& v = in.vectors[i % in.vectors.count()];
+			const auto& w = in.vectors[(i + 7) % in.vectors.count()] + Vec4{ .5f };
+
+			auto product = a * b, productScalar = operator *<float>(a, b);
+			multiply.compare(product.data, productScalar.data, 16);
+
+			auto av = a * v, avScalar = operator *<float>(a, v);
+			transform.compare(av.data, avScalar.data, 4);
+
+			auto t = transpose(a), tScalar = transpose<4, 4, float>(a);
+			transposed.compare(t.data, tScalar.data, 16);
+
+			auto inv = inverse(a), invScalar = inverse<float>(a);
+			inverted.compare(inv.data, invScalar.data, 16);
+
+			Vec4 ops[] = { v + w, v - w, v * w, v / w, v * 3.f, v / 3.f };
+			Vec4 opsScalar[] = {
+				operator +<4, float>(v, w), operator -<4, float>(v, w), operator *<4, float>(v, w), operator /<4, float>(v, w),
+				operator *<4, float>(v, 3.f), operator /<4, float>(v, 3.f)
+			};
+			vecOps.compare(ops[0].data, opsScalar[0].data, 4 * 6);
+
+			auto d = dot(v, w), dScalar = dot<4, float>(v, w);
+			dots.compare(&d, &dScalar, 1);
+		}
+
+		for (uint32 i = 0; i < in.rotations.count(); ++i) {
+			const auto& p = in.rotations[i];
+			const auto& q = in.rotations[(i + 1) % in.rotations.count()];
+
+			auto pq = p * q, pqScalar = operator *<float>(p, q);
+			quatMul.compare(pq.data, pqScalar.data, 4);
+
+			// the float toMatrix4 is replaced by its specialization, compare with the double template
+			auto m = p.toMatrix4();
+			auto mDouble = Quaternion<double>{ p.x, p.y, p.z, p.w }.toMatrix4();
+			float mScalar[16];
+			for (uint32 e = 0; e < 16; ++e) {
+				mScalar[e] = float(mDouble.data[e]);
+			}
+			toMatrix.compare(m.data, mScalar, 16);
+		}
+
+		// report all before failing
+		bool passed = true;
+		for (auto check : { &multiply, &transform, &transposed, &vecOps, &dots, &quatMul, &toMatrix, &inverted }) {
+			passed = check->report() && passed;
+		}
+		return passed;
+	}
+#else
+	bool checkSIMD() {
+		fprintf(stderr, "  SD_MATH_SIMD is 0, only the scalar templates are in use\n");
+		return true;
+	}
+#endif
+
+} // anonymous namespace
+
+
+void registerMathBenchmarks(Registry& registry) {
+	// -- Mat4
+
+	registry.add("math/Mat4/multiply", [](State& state) {
+		MathInputs in { valuesPerRound };
+		Array<Mat4> out;
+		out.resize(valuesPerRound);
+
+		while (state.keepRunning()) {
+			for (uint32 i = 0; i < valuesPerRound; ++i) {
+				out[i] = in.matrices[i] * in.matrices[(i + 1) & (valuesPerRound - 1)];
+			}
+			doNotOptimize(out.elementsBasePtr());
+		}
+		state.setItemsPerIteration(valuesPerRound);
+	});
+
+	registry.add("math/Mat4/inverse", [](State& state) {
+		MathInputs in { valuesPerRound };
+		Array<Mat4> out;
+		out.resize(valuesPerRound);
+
+		while (state.keepRunning()) {
+			for (uint32 i = 0; i < valuesPerRound; ++i) {
+				out[i] = inverse(in.matrices[i]);
+			}
+			doNotOptimize(out.elementsBasePtr());
+		}
+		state.setItemsPerIteration(valuesPerRound);
+	});
+
+	registry.add("math/Mat4/transpose", [](State& state) {
+		MathInputs in { valuesPerRound };
+		Array<Mat4> out;
+		out.resize(valuesPerRound);
+
+		while (state.keepRunning()) {
+			for (uint32 i = 0; i < valuesPerRound; ++i) {
+				out[i] = transpose(in.matrices[i]);
+			}
+			doNotOptimize(out.elementsBasePtr());
+		}
+		state.setItemsPerIteration(valuesPerRound);
+	});
+
+	registry.add("math/Mat4/transformVec4", [](State& state) {
+		MathInputs in { valuesPerRound };
+		Array<Vec4> out;
+		out.resize(valuesPerRound);
+
+		while (state.keepRunning()) {
+			for (uint32 i = 0; i < valuesPerRound; ++i) {
+				out[i] = in.matrices[i] * in.vectors[i];
+			}
+			doNotOptimize(out.elementsBasePtr());
+		}
+		state.setItemsPerIteration(valuesPerRound);
+	});
+
+
+	// -- Quat
+
+	registry.add("math/Quat/multiply", [](State& state) {
+		MathInputs in { valuesPerRound };
+		Array<Quat> out;
+		out.resize(valuesPerRound);
+
+		while (state.keepRunning()) {
+			for (uint32 i = 0; i < valuesPerRound; ++i) {
+				out[i] = in.rotations[i] * in.rotations[(i + 1) & (valuesPerRound - 1)];
+			}
+			doNotOptimize(out.elementsBasePtr());
+		}
+		state.setItemsPerIteration(valuesPerRound);
+	});
+
+	registry.add("math/Quat/rotateVec3", [](State& state) {
+		MathInputs in { valuesPerRound };
+		Array<Vec3> out;
+		out.resize(valuesPerRound);
+
+		while (state.keepRunning()) {
+			for (uint32 i = 0; i < valuesPerRound; ++i) {
+				out[i] = in.rotations[i] * in.positions[i];
+			}
+			doNotOptimize(out.elementsBasePtr());
+		}
+		state.setItemsPerIteration(valuesPerRound);
+	});
+
+	registry.add("math/Quat/slerp", [](State& state) {
+		MathInputs in { valuesPerRound };
+		Array<Quat> out;
+		out.resize(valuesPerRound);
+
+		while (state.keepRunning()) {
+			for (uint32 i = 0; i < valuesPerRound; ++i) {
+				out[i] = slerp(in.rotations[i], in.rotations[(i + 1) & (valuesPerRound - 1)], .3f);
+			}
+			doNotOptimize(out.elementsBasePtr());
+		}
+		state.setItemsPerIteration(valuesPerRound);
+	});
+
+	registry.add("math/Quat/nlerp", [](State& state) {
+		MathInputs in { valuesPerRound };
+		Array<Quat> out;
+		out.resize(valuesPerRound);
+
+		while (state.keepRunning()) {
+			for (uint32 i = 0; i < valuesPerRound; ++i) {
+				out[i] = nlerp(in.rotations[i], in.rotations[(i + 1) & (valuesPerRound - 1)], .3f);
+			}
+			doNotOptimize(out.elementsBasePtr());
+		}
+		state.setItemsPerIteration(valuesPerRound);
+	});
+
+	registry.add("math/Quat/toMatrix4", [](State& state) {
+		MathInputs in { valuesPerRound };
+		Array<Mat4> out;
+		out.resize(valuesPerRound);
+
+		while (state.keepRunning()) {
+			for (uint32 i = 0; i < valuesPerRound; ++i) {
+				out[i] = in.rotations[i].toMatrix4();
+			}
+			doNotOptimize(out.elementsBasePtr());
+		}
+		state.setItemsPerIteration(valuesPerRound);
+	});
+
+
+	// -- TRS composition, the unfused form versus the kernels
+
+	registry.add("math/TRS/multiplyMatrices", { 1000, 100000 }, [](State& state) {
+		auto count = static_cast<uint32>(state.arg());
+		MathInputs in { count };
+		Array<Mat4> out;
+		out.resize(count);
+
+		while (state.keepRunning()) {
+			for (uint32 i = 0; i < count; ++i) {
+				out[i] = translationMatrix(in.positions[i]) * in.rotations[i].toMatrix4() * scaleMatrix(in.scales[i]);
+			}
+			doNotOptimize(out.elementsBasePtr());
+		}
+		state.setItemsPerIteration(count);
+	});
+
+	registry.add("math/TRS/composeTRS", { 1000, 100000 }, [](State& state) {
+		composeTRSBatch(state, static_cast<TRSKernel>(&composeTRS));
+	});
+
+	registry.add("math/TRS/composeTRSScalar", { 1000, 100000 }, [](State& state) {
+		composeTRSBatch(state, &detail::composeTRSScalar);
+	});
+
+#if SD_ARCH_X86_64
+	registry.add("math/TRS/composeTRSSSE", { 1000, 100000 }, [](State& state) {
+		composeTRSBatch(state, &detail::composeTRSSSE);
+	});
+
+	if (cpu::features().avx2) {
+		registry.add("math/TRS/composeTRSAVX2", { 1000, 100000 }, [](State& state) {
+			composeTRSBatch(state, &detail::composeTRSAVX2);
+		});
+	}
+#endif
+
+
+	// -- Stream batch kernels
+
+	addStreamBenchmarks(registry, "Scalar", detail::crossScalar, detail::addScaledScalar, detail::normalizeScalar, detail::slerpScalar, detail::transformPointsScalar);
+
+#if SD_ARCH_X86_64
+	if (cpu::features().avx2) {
+		addStreamBenchmarks(registry, "AVX2", detail::crossAVX2, detail::addScaledAVX2, detail::normalizeAVX2, detail::slerpAVX2, detail::transformPointsAVX2);
+	}
+#endif
+
+
+	// -- checks
+
+	registry.addCheck("math/SIMD", checkSIMD);
+}
+
+
+} // ns bench
+} // ns stardazed
@@ -0,0 +1,235 @@
+// ------------------------------------------------------------------
+// bench::MemoryBench.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "Bench.hpp"
+#include "memory/Allocator.hpp"
+#include "memory/PoolAllocator.hpp"
+#include "memory/FrameAllocator.hpp"
+#include "memory/Block.hpp"
+#include "container/Array.hpp"
+#include "container/MultiArrayBuffer.hpp"
+#include "math/Vector.hpp"
+#include "math/Quaternion.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace stardazed {
+namespace bench {
+
+
+namespace {
+
+	constexpr uint32 allocationsPerRound = 1024;
+
+
+	// Forwards to the SystemAllocator but keeps the default Allocator::realloc,
+	// so every growth is an alloc+copy+free. The baseline for the realloc paths.
+	struct CopyingAllocator final : memory::Allocator {
+		void* alloc(uint64 sizeBytes) final { return memory::SystemAllocator::sharedInstance().alloc(sizeBytes); }
+		void free(void* ptr) final { memory::SystemAllocator::sharedInstance().free(ptr); }
+
+		bool allocZeroesMemory() const final { return true; }
+		uint guaranteedAlignment() const final { return memory::SystemAllocator::sharedInstance().guaranteedAlignment(); }
+
+		static CopyingAllocator& sharedInstance() {
+			static CopyingAllocator ca_s;
+			return ca_s;
+		}
+	};
+
+
+	// allocate a round of small blocks of mixed sizes, then free them all
+	void allocFreeRound(State& state, memory::Allocator& allocator) {
+		void* blocks[allocationsPerRound];
+		auto maxSize = static_cast<uint32>(state.arg());
+
+		while (state.keepRunning()) {
+			for (uint32 b = 0; b < allocationsPerRound; ++b) {
+				blocks[b] = allocator.alloc(16 + ((b * 97) % maxSize));
+			}
+			clobberMemory();
+			for (uint32 b = 0; b < allocationsPerRound; ++b) {
+				allocator.free(blocks[b]);
+			}
+		}
+		state.setItemsPerIteration(allocationsPerRound);
+	}
+
+
+	// grow an array one element at a time, each growth is a realloc
+	void arrayGrowth(State& state, memory::Allocator& allocator) {
+		auto count = static_cast<uint32>(state.arg());
+
+		while (state.keepRunning()) {
+			Array<uint32> items { allocator, 4 };
+			for (uint32 i = 0; i < count; ++i) {
+				items.append(i);
+			}
+			doNotOptimize(items.elementsBasePtr());
+		}
+		state.setItemsPerIteration(count);
+	}
+
+
+	// grow a 3-column MAB one element at a time, each growth reallocs the
+	// block and moves the columns inside it
+	void mabGrowth(State& state, memory::Allocator& allocator) {
+		auto count = static_cast<uint32>(state.arg());
+
+		while (state.keepRunning()) {
+			container::MultiArrayBuffer<math::Vec3, math::Quat, float> items { allocator, 4 };
+			for (uint32 i = 0; i < count; ++i) {
+				items.extend();
+			}
+			doNotOptimize(items.elementsBasePtr<0>());
+		}
+		state.setItemsPerIteration(count);
+	}
+
+
+	// -- checks, VirtualArena growth, clear and trim
+
+	struct ArenaBlock {
+		uint8* data;
+		uint32 size;
+		uint8 fill;
+	};
+
+
+	// Allocates blocks of mixed sizes and alignments until the arena has
+	// committed many times its initial capacity, writing a pattern into each.
+	// Returns false if a block is misaligned, overlaps the previous one or the
+	// arena moved.
+	bool fillArena(memory::VirtualArena& arena, Array<ArenaBlock>& blocks, uint32 targetBytes) {
+		auto base = arena.basePointer();
+		uint8* previousEnd = static_cast<uint8*>(base);
+		blocks.clear();
+
+		for (uint32 b = 0; arena.usedBytes() < targetBytes; ++b) {
+			auto size = 1 + ((b * 7919) % 20000);
+			auto alignment = 1u << (b % 7);
+			auto block = static_cast<uint8*>(arena.alloc(size, alignment));
+			if (! block || (reinterpret_cast<uintptr_t>(block) & (alignment - 1)) || block < previousEnd || arena.basePointer() != base) {
+				return false;
+			}
+			auto fill = static_cast<uint8>(b * 31 + 1);
+			memset(block, fill, size);
+			blocks.append({ block, size, fill });
+			previousEnd = block + size;
+		}
+		return true;
+	}
+
+
+	bool arenaContentsIntact(const Array<ArenaBlock>& blocks) {
+		for (const auto& block : blocks) {
+			for (uint32 i = 0; i < block.size; ++i) {
+				if (block.data[i] != block.fill) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+
+	bool checkVirtualArena() {
+		constexpr uint32 initialCapacity = 64 * 1024;
+		constexpr uint32 targetBytes = 8 * 1024 * 1024;
+
+		memory::VirtualArena arena { initialCapacity, 64 * 1024 * 1024 };
+		auto base = arena.basePointer();
+		Array<ArenaBlock> blocks;
+
+		// growth, earlier blocks keep their address and contents
+		auto grew = fillArena(arena, blocks, targetBytes) && arenaContentsIntact(blocks);
+		auto grownCapacity = arena.capacity();
+		grew = grew && grownCapacity >= arena.usedBytes() && grownCapacity > initialCapacity;
+		fprintf(stderr, "  %-24s %u blocks, %u bytes used, %u committed%s\n", "growth", blocks.count(), arena.usedBytes(), grownCapacity, grew ? "" : "  <--");
+
+		// clear keeps the committed pages, allocation restarts at the base
+		arena.clear();
+		auto cleared = arena.usedBytes() == 0 && arena.capacity() == grownCapacity;
+		cleared = cleared && fillArena(arena, blocks, targetBytes) && blocks[0].data == base && arenaContentsIntact(blocks);
+		cleared = cleared && arena.capacity() == grownCapacity;
+		fprintf(stderr, "  %-24s refilled without committing more%s\n", "clear", cleared ? "" : "  <--");
+
+		// trim after clear returns all pages, the arena commits again on demand
+		arena.clear();
+		arena.trim();
+		auto trimmed = arena.capacity() == 0;
+		trimmed = trimmed && fillArena(arena, blocks, targetBytes / 4) && blocks[0].data == base && arenaContentsIntact(blocks);
+		fprintf(stderr, "  %-24s %u committed after refill%s\n", "trim", arena.capacity(), trimmed ? "" : "  <--");
+
+		return grew && cleared && trimmed;
+	}
+
+} // anonymous namespace
+
+
+void registerMemoryBenchmarks(Registry& registry) {
+	registry.add("memory/SystemAllocator/allocFree", { 64, 1024 }, [](State& state) {
+		allocFreeRound(state, memory::SystemAllocator::sharedInstance());
+	});
+
+	registry.add("memory/PoolAllocator/allocFree", { 64, 1024 }, [](State& state) {
+		allocFreeRound(state, memory::PoolAllocator::sharedInstance());
+	});
+
+	// realloc (SystemAllocator, PoolAllocator) vs alloc+copy+free (CopyingAllocator) growth
+	registry.add("memory/SystemAllocator/arrayGrowth", { 10000, 100000, 1000000 }, [](State& state) {
+		arrayGrowth(state, memory::SystemAllocator::sharedInstance());
+	});
+
+	registry.add("memory/PoolAllocator/arrayGrowth", { 10000, 100000, 1000000 }, [](State& state) {
+		arrayGrowth(state, memory::PoolAllocator::sharedInstance());
+	});
+
+	registry.add("memory/CopyingAllocator/arrayGrowth", { 10000, 100000, 1000000 }, [](State& state) {
+		arrayGrowth(state, CopyingAllocator::sharedInstance());
+	});
+
+	registry.add("memory/SystemAllocator/mabGrowth", { 10000, 100000, 1000000 }, [](State& state) {
+		mabGrowth(state, memory::SystemAllocator::sharedInstance());
+	});
+
+	registry.add("memory/CopyingAllocator/mabGrowth", { 10000, 100000, 1000000 }, [](State& state) {
+		mabGrowth(state, CopyingAllocator::sharedInstance());
+	});
+
+	// per-frame scratch allocations that are all released by nextFrame
+	registry.add("memory/FrameAllocator/allocNextFrame", [](State& state) {
+		memory::FrameAllocator frame { memory::SystemAllocator::sharedInstance(), 1024 * 1024 };
+
+		while (state.keepRunning()) {
+			for (uint32 b = 0; b < allocationsPerRound; ++b) {
+				doNotOptimize(frame.alloc(16 + ((b * 97) % 512), 16));
+			}
+			frame.nextFrame();
+		}
+		state.setItemsPerIteration(allocationsPerRound);
+	});
+
+	// the same with a VirtualArena, cleared each round, after the first round
+	// the committed pages are reused
+	registry.add("memory/VirtualArena/allocClear", [](State& state) {
+		memory::VirtualArena arena { 64 * 1024 };
+
+		while (state.keepRunning()) {
+			for (uint32 b = 0; b < allocationsPerRound; ++b) {
+				doNotOptimize(arena.alloc(16 + ((b * 97) % 512), 16));
+			}
+			arena.clear();
+		}
+		state.setItemsPerIteration(allocationsPerRound);
+	});
+
+	registry.addCheck("memory/VirtualArena/growClearTrim", checkVirtualArena);
+}
+
+
+} // ns bench
+} // ns stardazed
@@ -0,0 +1,57 @@
+// ------------------------------------------------------------------
+// bench::ModelBench.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "Bench.hpp"
+#include "model/Generators.hpp"
+
+namespace stardazed {
+namespace bench {
+
+
+namespace {
+
+	// items are generated vertexes, the mesh includes generated normals
+	template <typename MakeMesh>
+	void generateMesh(State& state, MakeMesh&& makeMesh) {
+		uint32 vertexCount = 0;
+		while (state.keepRunning()) {
+			auto mesh = makeMesh();
+			auto& vertexBuffer = mesh.primaryVertexBuffer();
+			vertexCount = vertexBuffer.itemCount();
+			doNotOptimize(vertexBuffer.basePointer());
+		}
+		state.setItemsPerIteration(vertexCount);
+	}
+
+} // anonymous namespace
+
+
+void registerModelBenchmarks(Registry& registry) {
+	// arg tiles along each side
+	registry.add("model/gen/plane", { 16, 128, 512 }, [](State& state) {
+		auto side = float(state.arg());
+		generateMesh(state, [side] { return model::gen::plane(side, side, 1.f); });
+	});
+
+	// arg rows, 1.5 * arg segments
+	registry.add("model/gen/sphere", { 16, 64, 256 }, [](State& state) {
+		auto rows = static_cast<int>(state.arg());
+		generateMesh(state, [rows] { return model::gen::sphere(1.f, rows, rows * 3 / 2); });
+	});
+
+	// arg radius and angle steps
+	registry.add("model/gen/arc", { 16, 128, 512 }, [](State& state) {
+		auto steps = static_cast<int>(state.arg());
+		generateMesh(state, [steps] { return model::gen::arc(.5f, 1.f, steps, math::Degrees{ 0 }, math::Degrees{ 270 }, steps); });
+	});
+
+	registry.add("model/gen/box", [](State& state) {
+		generateMesh(state, [] { return model::gen::box(1.f); });
+	});
+}
+
+
+} // ns bench
+} // ns stardazed
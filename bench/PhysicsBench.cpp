@@ -0,0 +1,401 @@
+// ------------------------------------------------------------------
+// bench::PhysicsBench.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "Bench.hpp"
+#include "scene/Scene.hpp"
+#include "physics/RigidBody.hpp"
+#include "physics/Collider.hpp"
+#include "physics/Broadphase.hpp"
+#include "runtime/Jobs.hpp"
+#include "container/Array.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+namespace stardazed {
+namespace bench {
+
+
+namespace {
+
+	using namespace physics;
+
+	constexpr Time stepTime = 1. / 60.;
+	constexpr uint32 reverseInterval = 64; // steps between momentum reversals
+
+
+	// deterministic pseudo-random value in [-1, 1)
+	float noise(uint32 seed) {
+		seed = (seed ^ 61) ^ (seed >> 16);
+		seed *= 9;
+		seed ^= seed >> 4;
+		seed *= 0x27d4eb2d;
+		seed ^= seed >> 15;
+		return float(seed & 0xffff) / 32768.f - 1.f;
+	}
+
+
+	// unit boxes on a cubic lattice, about half of them overlap a neighbour
+	math::Vec3 latticePosition(uint32 index, uint32 count) {
+		auto side = math::max(1u, static_cast<uint32>(std::cbrt(float(count))));
+		auto spacing = 1.25f;
+		return {
+			(index % side) * spacing + noise(index) * .2f,
+			((index / side) % side) * spacing + noise(index + count) * .2f,
+			(index / (side * side)) * spacing + noise(index + 2 * count) * .2f
+		};
+	}
+
+
+	// rigid bodies with colliders drifting around the lattice; the drift is
+	// reversed every so often so the density stays about the same however
+	// many steps the harness runs
+	struct PhysicsWorld {
+		scene::Scene scene;
+		RigidBodyManager rigidBodies;
+		ColliderManager colliders;
+		Array<RigidBodyManager::Instance> bodies;
+		uint32 steps = 0;
+
+		PhysicsWorld(uint32 count, BroadphaseType broadphase)
+		: rigidBodies(memory::SystemAllocator::sharedInstance(), scene.transform())
+		, colliders(memory::SystemAllocator::sharedInstance(), scene.transform(), rigidBodies, broadphase)
+		{
+			bodies.reserve(count);
+			for (uint32 i = 0; i < count; ++i) {
+				auto ent = scene.makeEntity(latticePosition(i, count));
+				auto body = rigidBodies.create(ent, { 1, 0.01f, 0.01f, false });
+				rigidBodies.setMomentum(body, { noise(i * 3), noise(i * 3 + 1), noise(i * 3 + 2) });
+				colliders.create(ent, ColliderType::Box, math::Vec3::zero(), math::Vec3::one());
+				bodies.append(body);
+			}
+		}
+
+		void step() {
+			rigidBodies.integrateAll(stepTime);
+			if (++steps % reverseInterval == 0) {
+				for (auto body : bodies) {
+					rigidBodies.setMomentum(body, -rigidBodies.momentum(body));
+				}
+			}
+		}
+	};
+
+
+	void integrateAll(State& state, jobs::JobSystem* jobSystem) {
+		PhysicsWorld world { static_cast<uint32>(state.arg()), BroadphaseType::SweepAndPrune };
+		world.rigidBodies.setJobSystem(jobSystem);
+
+		while (state.keepRunning()) {
+			world.rigidBodies.integrateAll(stepTime);
+		}
+		state.setItemsPerIteration(world.bodies.count());
+	}
+
+
+	void resolveAll(State& state, BroadphaseType broadphase) {
+		PhysicsWorld world { static_cast<uint32>(state.arg()), broadphase };
+		world.colliders.resolveAll();
+
+		while (state.keepRunning()) {
+			state.pauseTiming();
+			world.step();
+			state.resumeTiming();
+
+			world.colliders.resolveAll();
+		}
+		state.setItemsPerIteration(world.bodies.count());
+	}
+
+
+	// moves all proxies a little, then finds the pairs, as a frame does
+	void findPairs(State& state, BroadphaseType type) {
+		auto count = static_cast<uint32>(state.arg());
+		auto broadphase = makeBroadphase(type, memory::SystemAllocator::sharedInstance());
+
+		Array<math::Vec3> centers;
+		Array<BroadphaseProxy> proxies;
+		for (uint32 i = 0; i < count; ++i) {
+			centers.append(latticePosition(i, count));
+			proxies.append(broadphase->createProxy(math::Bounds::fromCenterAndSize(centers.back(), math::Vec3::one()), i));
+		}
+
+		Array<BroadphasePair> pairs;
+		broadphase->findPairs(pairs);
+
+		uint32 frame = 0;
+		while (state.keepRunning()) {
+			auto offset = ((frame++ / reverseInterval) & 1) ? -.01f : .01f;
+			for (uint32 i = 0; i < count; ++i) {
+				centers[i].x += offset * noise(i);
+				broadphase->moveProxy(proxies[i], math::Bounds::fromCenterAndSize(centers[i], math::Vec3::one()));
+			}
+			broadphase->findPairs(pairs);
+			doNotOptimize(pairs.count());
+		}
+		state.setItemsPerIteration(count);
+	}
+
+
+	const char* broadphaseName(BroadphaseType type) {
+		switch (type) {
+			case BroadphaseType::SweepAndPrune: return "sweepAndPrune";
+			case BroadphaseType::AABBTree: return "aabbTree";
+			case BroadphaseType::SpatialHashGrid: return "spatialHashGrid";
+		}
+		return "unknown";
+	}
+
+
+	// -- checks, the broadphases against a brute-force overlap test
+
+	// fixed-seed generator so failures reproduce
+	class CheckRandom {
+		uint32 seed_;
+
+	public:
+		explicit CheckRandom(uint32 seed) : seed_(seed) {}
+
+		uint32 next() {
+			seed_ = seed_ * 1664525 + 1013904223;
+			return seed_ >> 8;
+		}
+
+		// in [from, to)
+		float range(float from, float to) {
+			return from + float(next()) / float(1 << 24) * (to - from);
+		}
+	};
+
+
+	struct CheckProxy {
+		BroadphaseProxy proxy;
+		math::Bounds bounds;
+		uint32 userValue;
+		bool alive;
+	};
+
+
+	uint64 pairKey(uint32 userA, uint32 userB) {
+		return (uint64(userA) << 32) | userB;
+	}
+
+
+	// Runs a few hundred frames of moves, creates and destroys over a small
+	// volume, with bursts of creates, bounds that only touch, proxies covering
+	// many grid cells and a few far outside of any grid. Every frame the pairs
+	// must be exactly the brute-force pairs, the grid queries are checked the same way.
+	bool checkBroadphase(BroadphaseType type) {
+		auto broadphase = makeBroadphase(type, memory::SystemAllocator::sharedInstance());
+		auto grid = type == BroadphaseType::SpatialHashGrid ? static_cast<SpatialHashGrid*>(broadphase.get()) : nullptr;
+		CheckRandom rnd { 0x5eed };
+
+		Array<CheckProxy> proxies;
+		auto addProxy = [&]() {
+			auto kind = rnd.next() % 64;
+			math::Vec3 center, size;
+			if (kind == 0) {
+				center = { rnd.range(-1e12f, 1e12f), rnd.range(-1e12f, 1e12f), rnd.range(-1e12f, 1e12f) };
+				size = math::Vec3::one();
+			}
+			else {
+				// whole x centers and unit x sizes give many endpoints with equal values
+				center = { std::round(rnd.range(0, 30)), rnd.range(0, 30), rnd.range(0, 30) };
+				size = kind == 1 ? math::Vec3{ 12 } : math::Vec3{ 1, rnd.range(.2f, 3), rnd.range(.2f, 3) };
+			}
+			auto bounds = math::Bounds::fromCenterAndSize(center, size);
+			auto userValue = proxies.count();
+			proxies.append({ broadphase->createProxy(bounds, userValue), bounds, userValue, true });
+		};
+
+		for (uint32 i = 0; i < 600; ++i) {
+			addProxy();
+		}
+
+		constexpr uint32 frameCount = 300;
+		Array<BroadphasePair> pairs;
+		Array<uint64> found, expected;
+		Array<uint32> hits, expectedHits;
+		uint32 totalPairs = 0;
+		const char* failure = nullptr;
+		uint32 frame = 0;
+
+		for (; frame < frameCount && ! failure; ++frame) {
+			for (auto& p : proxies) {
+				if (p.alive && rnd.next() % 3 == 0) {
+					math::Vec3 delta { rnd.range(-.6f, .6f), rnd.range(-.6f, .6f), rnd.range(-.6f, .6f) };
+					if (rnd.next() % 4 == 0) {
+						delta.x = std::round(delta.x);
+					}
+					p.bounds = math::Bounds::fromMinAndMax(p.bounds.min() + delta, p.bounds.max() + delta);
+					broadphase->moveProxy(p.proxy, p.bounds);
+				}
+			}
+			for (auto k = rnd.next() % 6; k > 0; --k) {
+				auto& p = proxies[rnd.next() % proxies.count()];
+				if (p.alive) {
+					broadphase->destroyProxy(p.proxy);
+					p.alive = false;
+				}
+			}
+			for (auto k = rnd.next() % 6; k > 0; --k) {
+				addProxy();
+			}
+			if (frame % 97 == 0) {
+				for (uint32 i = 0; i < 200; ++i) {
+					addProxy();
+				}
+			}
+
+			broadphase->findPairs(pairs);
+			found.clear();
+			for (const auto& pair : pairs) {
+				if (pair.userA >= pair.userB) {
+					failure = "pair not ordered userA < userB";
+				}
+				found.append(pairKey(pair.userA, pair.userB));
+			}
+			std::sort(begin(found), end(found));
+
+			expected.clear();
+			for (uint32 a = 0; a < proxies.count(); ++a) {
+				if (! proxies[a].alive) continue;
+				for (uint32 b = a + 1; b < proxies.count(); ++b) {
+					if (proxies[b].alive && proxies[a].bounds.intersects(proxies[b].bounds)) {
+						expected.append(pairKey(a, b));
+					}
+				}
+			}
+
+			if (found.count() != expected.count() || ! std::equal(begin(found), end(found), begin(expected))) {
+				failure = "pairs differ from brute force";
+			}
+			totalPairs += found.count();
+
+			auto liveCount = std::count_if(begin(proxies), end(proxies), [](const CheckProxy& p) { return p.alive; });
+			if (broadphase->proxyCount() != uint32(liveCount)) {
+				failure = "proxyCount differs from the live proxies";
+			}
+
+			// findPairs rebuilt the grid, so the queries see the current bounds
+			for (uint32 q = 0; grid && q < 20 && ! failure; ++q) {
+				math::Vec3 center { rnd.range(0, 30), rnd.range(0, 30), rnd.range(0, 30) };
+				auto radius = rnd.range(.4f, 6);
+				auto area = math::Bounds::fromCenterAndSize(center, math::Vec3{ radius });
+
+				grid->queryBounds(area, hits);
+				expectedHits.clear();
+				for (const auto& p : proxies) {
+					if (p.alive && p.bounds.intersects(area)) {
+						expectedHits.append(p.userValue);
+					}
+				}
+				std::sort(begin(hits), end(hits));
+				if (hits.count() != expectedHits.count() || ! std::equal(begin(hits), end(hits), begin(expectedHits))) {
+					failure = "queryBounds differs from brute force";
+				}
+
+				grid->queryRadius(center, radius, hits);
+				expectedHits.clear();
+				for (const auto& p : proxies) {
+					if (p.alive && math::lengthSquared(p.bounds.closestPoint(center) - center) <= radius * radius) {
+						expectedHits.append(p.userValue);
+					}
+				}
+				std::sort(begin(hits), end(hits));
+				if (hits.count() != expectedHits.count() || ! std::equal(begin(hits), end(hits), begin(expectedHits))) {
+					failure = "queryRadius differs from brute force";
+				}
+			}
+		}
+
+		if (failure) {
+			fprintf(stderr, "  %s in frame %u  <--\n", failure, frame - 1);
+			return false;
+		}
+		fprintf(stderr, "  %u frames, %u proxies created, %u pairs\n", frameCount, proxies.count(), totalPairs);
+		return true;
+	}
+
+} // anonymous namespace
+
+
+void registerPhysicsBenchmarks(Registry& registry) {
+	registry.add("physics/RigidBody/integrateAll/serial", { 1000, 10000, 100000 }, [](State& state) {
+		integrateAll(state, nullptr);
+	});
+
+	registry.add("physics/RigidBody/integrateAll/parallel", { 1000, 10000, 100000 }, [](State& state) {
+		integrateAll(state, &jobs::defaultJobSystem());
+	});
+
+	for (auto type : { BroadphaseType::SweepAndPrune, BroadphaseType::AABBTree, BroadphaseType::SpatialHashGrid }) {
+		auto name = std::string(broadphaseName(type));
+
+		registry.add("physics/Collider/resolveAll/" + name, { 100, 1000, 10000, 100000 }, [type](State& state) {
+			resolveAll(state, type);
+		});
+
+		registry.add("physics/Broadphase/findPairs/" + name, { 100, 1000, 10000, 100000 }, [type](State& state) {
+			findPairs(state, type);
+		});
+	}
+
+
+	for (auto type : { BroadphaseType::SweepAndPrune, BroadphaseType::AABBTree, BroadphaseType::SpatialHashGrid }) {
+		registry.addCheck("physics/Broadphase/" + std::string(broadphaseName(type)), [type] {
+			return checkBroadphase(type);
+		});
+	}
+
+	// gameplay queries against a rebuilt grid
+	registry.add("physics/SpatialHashGrid/queryRadius", { 1000, 100000 }, [](State& state) {
+		auto count = static_cast<uint32>(state.arg());
+		SpatialHashGrid grid { memory::SystemAllocator::sharedInstance() };
+		Array<math::Vec3> centers;
+		for (uint32 i = 0; i < count; ++i) {
+			centers.append(latticePosition(i, count));
+			grid.createProxy(math::Bounds::fromCenterAndSize(centers.back(), math::Vec3::one()), i);
+		}
+		grid.rebuild();
+
+		constexpr uint32 queriesPerRound = 256;
+		Array<uint32> found;
+		while (state.keepRunning()) {
+			for (uint32 q = 0; q < queriesPerRound; ++q) {
+				grid.queryRadius(centers[(q * 7919) % count], 3.f, found);
+				doNotOptimize(found.count());
+			}
+		}
+		state.setItemsPerIteration(queriesPerRound);
+	});
+
+	registry.add("physics/SpatialHashGrid/queryBounds", { 1000, 100000 }, [](State& state) {
+		auto count = static_cast<uint32>(state.arg());
+		SpatialHashGrid grid { memory::SystemAllocator::sharedInstance() };
+		Array<math::Vec3> centers;
+		for (uint32 i = 0; i < count; ++i) {
+			centers.append(latticePosition(i, count));
+			grid.createProxy(math::Bounds::fromCenterAndSize(centers.back(), math::Vec3::one()), i);
+		}
+		grid.rebuild();
+
+		constexpr uint32 queriesPerRound = 256;
+		Array<uint32> found;
+		while (state.keepRunning()) {
+			for (uint32 q = 0; q < queriesPerRound; ++q) {
+				grid.queryBounds(math::Bounds::fromCenterAndSize(centers[(q * 7919) % count], { 6, 6, 6 }), found);
+				doNotOptimize(found.count());
+			}
+		}
+		state.setItemsPerIteration(queriesPerRound);
+	});
+}
+
+
+} // ns bench
+} // ns stardazed
@@ -0,0 +1,178 @@
+// ------------------------------------------------------------------
+// bench::RuntimeBench.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "Bench.hpp"
+#include "runtime/Jobs.hpp"
+#include "runtime/Profiler.hpp"
+#include "container/Array.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+namespace stardazed {
+namespace bench {
+
+
+namespace {
+
+	void scaleValues(float* values, uint32 first, uint32 last) {
+		for (auto i = first; i < last; ++i) {
+			values[i] = values[i] * 1.0001f + .5f;
+		}
+	}
+
+
+	void parallelScale(State& state, jobs::JobSystem* jobSystem) {
+		auto count = static_cast<uint32>(state.arg());
+		Array<float> values;
+		values.resize(count);
+		auto base = values.elementsBasePtr();
+
+		while (state.keepRunning()) {
+			jobs::parallelFor(jobSystem, 0, count, 1024, [base](uint32 first, uint32 last) {
+				scaleValues(base, first, last);
+			});
+			clobberMemory();
+		}
+		state.setItemsPerIteration(count);
+	}
+
+
+	// -- checks, nested parallelFor over two job systems
+
+	using HitCounts = std::unique_ptr<std::atomic<uint32>[]>;
+
+	// outer chunks on one system run parallelFors on the other, which nest
+	// back into the first, every index is counted once per call
+	void nestedParallelFor(jobs::JobSystem& outer, jobs::JobSystem& inner, uint32 count, std::atomic<uint32>* hits, const std::thread::id* inlineThread, std::atomic<uint32>& foreignChunks) {
+		auto visit = [&] {
+			if (inlineThread && std::this_thread::get_id() != *inlineThread) {
+				foreignChunks.fetch_add(1, std::memory_order_relaxed);
+			}
+		};
+
+		jobs::parallelFor(&outer, 0, count, 4096, [&](uint32 first, uint32 last) {
+			visit();
+			jobs::parallelFor(&inner, first, last, 512, [&](uint32 innerFirst, uint32 innerLast) {
+				visit();
+				jobs::parallelFor(&outer, innerFirst, innerLast, 64, [&](uint32 f, uint32 l) {
+					visit();
+					for (auto i = f; i < l; ++i) {
+						hits[i].fetch_add(1, std::memory_order_relaxed);
+					}
+				});
+			});
+		});
+	}
+
+
+	uint32 countMisses(const HitCounts& hits, uint32 count, uint32 expected) {
+		uint32 misses = 0;
+		for (uint32 i = 0; i < count; ++i) {
+			if (hits[i].load() != expected) {
+				++misses;
+			}
+		}
+		return misses;
+	}
+
+
+	// The calling thread is worker 0 of both systems while a second thread,
+	// a worker of neither, runs the same nesting at the same time. Its jobs
+	// must all run inline on that thread.
+	bool checkNestedJobSystems() {
+		constexpr uint32 count = 1 << 18;
+		constexpr uint32 rounds = 10;
+
+		jobs::JobSystem first { 4 };
+		jobs::JobSystem second { 3 };
+
+		HitCounts workerHits { new std::atomic<uint32>[count] };
+		HitCounts outsiderHits { new std::atomic<uint32>[count] };
+		for (uint32 i = 0; i < count; ++i) {
+			workerHits[i] = 0;
+			outsiderHits[i] = 0;
+		}
+
+		std::atomic<uint32> foreignChunks { 0 };
+		std::thread outsider([&] {
+			auto self = std::this_thread::get_id();
+			for (uint32 round = 0; round < rounds; ++round) {
+				nestedParallelFor(round & 1 ? second : first, round & 1 ? first : second, count, outsiderHits.get(), &self, foreignChunks);
+			}
+		});
+
+		for (uint32 round = 0; round < rounds; ++round) {
+			nestedParallelFor(round & 1 ? second : first, round & 1 ? first : second, count, workerHits.get(), nullptr, foreignChunks);
+		}
+		outsider.join();
+
+		auto workerMisses = countMisses(workerHits, count, rounds);
+		auto outsiderMisses = countMisses(outsiderHits, count, rounds);
+		auto ok = workerMisses == 0 && outsiderMisses == 0 && foreignChunks == 0;
+
+		fprintf(stderr, "  %-24s %u of %u indexes not visited %u times%s\n", "worker 0", workerMisses, count, rounds, workerMisses ? "  <--" : "");
+		fprintf(stderr, "  %-24s %u of %u indexes not visited %u times%s\n", "outside thread", outsiderMisses, count, rounds, outsiderMisses ? "  <--" : "");
+		fprintf(stderr, "  %-24s %u chunks run on another thread%s\n", "outside thread inline", foreignChunks.load(), foreignChunks ? "  <--" : "");
+		return ok;
+	}
+
+} // anonymous namespace
+
+
+void registerRuntimeBenchmarks(Registry& registry) {
+	// the serial run is the baseline for the job system's overhead and speedup
+	registry.add("runtime/Jobs/parallelFor/serial", { 4096, 1048576 }, [](State& state) {
+		parallelScale(state, nullptr);
+	});
+
+	registry.add("runtime/Jobs/parallelFor/jobSystem", { 4096, 1048576 }, [](State& state) {
+		parallelScale(state, &jobs::defaultJobSystem());
+	});
+
+	registry.addCheck("runtime/Jobs/nestedParallelFor", checkNestedJobSystems);
+
+	// cost of an SD_PROFILE_SCOPE with the profiler off and on
+	registry.add("runtime/Profiler/scope/disabled", [](State& state) {
+		auto& profiler = profile::Profiler::sharedInstance();
+		profiler.setEnabled(false);
+
+		while (state.keepRunning()) {
+			SD_PROFILE_SCOPE("bench");
+			clobberMemory();
+		}
+	});
+
+	registry.add("runtime/Profiler/scope/enabled", [](State& state) {
+		auto& profiler = profile::Profiler::sharedInstance();
+		profiler.setEnabled(true);
+
+		uint32 scopes = 0;
+		while (state.keepRunning()) {
+			{
+				SD_PROFILE_SCOPE("bench");
+				clobberMemory();
+			}
+
+			// collect well before the per-thread event buffer fills up
+			if (++scopes == profile::Profiler::maxEventsPerThread / 4) {
+				state.pauseTiming();
+				profiler.endFrame();
+				profiler.clear();
+				scopes = 0;
+				state.resumeTiming();
+			}
+		}
+
+		profiler.setEnabled(false);
+		profiler.clear();
+	});
+}
+
+
+} // ns bench
+} // ns stardazed
@@ -0,0 +1,133 @@
+// ------------------------------------------------------------------
+// bench::SceneBench.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "Bench.hpp"
+#include "scene/Scene.hpp"
+#include "scene/Transform.hpp"
+#include "scene/RenderSnapshot.hpp"
+#include "runtime/Jobs.hpp"
+#include "container/Array.hpp"
+
+namespace stardazed {
+namespace bench {
+
+
+namespace {
+
+	using namespace scene;
+
+	// every chainLength-th transform is a root, the ones after it form a
+	// parent chain below it; a chainLength of 1 gives a flat scene
+	Array<TransformManager::Instance> makeTransforms(Scene& scene, uint32 count, uint32 chainLength) {
+		auto& tm = scene.transform();
+		Array<TransformManager::Instance> instances;
+		instances.reserve(count);
+
+		for (uint32 i = 0; i < count; ++i) {
+			auto f = float(i);
+			auto ent = scene.makeEntity({ f * .1f, 0, -f * .1f }, math::Quat::fromEuler(math::Degrees{ f }, math::Degrees{ 0 }, math::Degrees{ 0 }));
+			auto h = tm.forEntity(ent);
+			if (i % chainLength != 0) {
+				tm.setParent(h, instances.back());
+			}
+			instances.append(h);
+		}
+
+		tm.updateMatrices();
+		return instances;
+	}
+
+
+	// moves every transform, then brings the matrices up to date
+	void moveAll(State& state, MatrixUpdateMode mode, uint32 chainLength, jobs::JobSystem* jobSystem) {
+		Scene scene;
+		auto& tm = scene.transform();
+		tm.setMatrixUpdateMode(mode);
+		tm.setJobSystem(jobSystem);
+		auto instances = makeTransforms(scene, static_cast<uint32>(state.arg()), chainLength);
+
+		float step = 0;
+		while (state.keepRunning()) {
+			step += .01f;
+			for (auto h : instances) {
+				tm.translate(h, step, 0, 0);
+			}
+			tm.updateMatrices();
+		}
+		state.setItemsPerIteration(instances.count());
+	}
+
+} // anonymous namespace
+
+
+void registerSceneBenchmarks(Registry& registry) {
+	registry.add("scene/Transform/moveAll/immediate", { 1000, 100000 }, [](State& state) {
+		moveAll(state, MatrixUpdateMode::Immediate, 1, nullptr);
+	});
+
+	registry.add("scene/Transform/moveAll/deferred", { 1000, 100000 }, [](State& state) {
+		moveAll(state, MatrixUpdateMode::Deferred, 1, nullptr);
+	});
+
+	registry.add("scene/Transform/moveAll/deferredParallel", { 1000, 100000 }, [](State& state) {
+		moveAll(state, MatrixUpdateMode::Deferred, 1, &jobs::defaultJobSystem());
+	});
+
+	registry.add("scene/Transform/moveAll/deferredHierarchy", { 1000, 100000 }, [](State& state) {
+		moveAll(state, MatrixUpdateMode::Deferred, 8, nullptr);
+	});
+
+	// moving only the roots dirties every child through the world matrix sweep
+	registry.add("scene/Transform/moveRoots/deferredHierarchy", { 1000, 100000 }, [](State& state) {
+		Scene scene;
+		auto& tm = scene.transform();
+		tm.setMatrixUpdateMode(MatrixUpdateMode::Deferred);
+		auto instances = makeTransforms(scene, static_cast<uint32>(state.arg()), 8);
+
+		while (state.keepRunning()) {
+			for (uint32 i = 0; i < instances.count(); i += 8) {
+				tm.translate(instances[i], 0, .01f, 0);
+			}
+			tm.updateMatrices();
+		}
+		state.setItemsPerIteration(instances.count());
+	});
+
+	registry.add("scene/Transform/setPositions", { 1000, 100000 }, [](State& state) {
+		Scene scene;
+		auto& tm = scene.transform();
+		tm.setMatrixUpdateMode(MatrixUpdateMode::Deferred);
+		auto instances = makeTransforms(scene, static_cast<uint32>(state.arg()), 1);
+
+		Array<uint32> indexes;
+		Array<math::Vec3> positions;
+		for (auto h : instances) {
+			indexes.append(tm.denseIndex(h));
+			positions.append(tm.position(h) + math::Vec3{ 0, 1, 0 });
+		}
+
+		while (state.keepRunning()) {
+			tm.setPositions(indexes.elementsBasePtr(), positions.elementsBasePtr(), indexes.count());
+			tm.updateMatrices();
+		}
+		state.setItemsPerIteration(instances.count());
+	});
+
+	registry.add("scene/RenderSnapshot/captureTransforms", { 1000, 100000 }, [](State& state) {
+		Scene scene;
+		auto instances = makeTransforms(scene, static_cast<uint32>(state.arg()), 1);
+		RenderSnapshot snapshot { memory::SystemAllocator::sharedInstance() };
+
+		while (state.keepRunning()) {
+			snapshot.captureTransforms(scene.transform());
+			doNotOptimize(snapshot.modelMatrix(instances.back()));
+		}
+		state.setItemsPerIteration(instances.count());
+	});
+}
+
+
+} // ns bench
+} // ns stardazed
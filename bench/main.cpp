@@ -0,0 +1,82 @@
+// ------------------------------------------------------------------
+// bench::main - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "Bench.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/stat.h>
+
+using namespace stardazed;
+
+
+namespace {
+
+	void printUsage(const char* program) {
+		fprintf(stderr,
+			"usage: %s [options]\n"
+			"  --filter <text>    run only benchmarks whose name contains text\n"
+			"  --out <path>       write the JSON results to path instead of stdout\n"
+			"  --min-time <sec>   minimum timed duration per benchmark (default 0.25)\n"
+			"  --data <dir>       directory for generated input files (default stardazed-bench-data)\n"
+			"  --list             print the benchmark names and exit\n"
+			"  --check            run the correctness checks instead of the benchmarks\n",
+			program);
+	}
+
+} // anonymous namespace
+
+
+int main(int argc, const char* argv[]) {
+	bench::Options options;
+
+	for (int a = 1; a < argc; ++a) {
+		auto arg = argv[a];
+		auto hasValue = a + 1 < argc;
+
+		if (std::strcmp(arg, "--filter") == 0 && hasValue) {
+			options.filter = argv[++a];
+		}
+		else if (std::strcmp(arg, "--out") == 0 && hasValue) {
+			options.outPath = argv[++a];
+		}
+		else if (std::strcmp(arg, "--min-time") == 0 && hasValue) {
+			options.minTime = time::fromSeconds(std::atof(argv[++a]));
+		}
+		else if (std::strcmp(arg, "--data") == 0 && hasValue) {
+			options.dataPath = argv[++a];
+		}
+		else if (std::strcmp(arg, "--list") == 0) {
+			options.list = true;
+		}
+		else if (std::strcmp(arg, "--check") == 0) {
+			options.check = true;
+		}
+		else {
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (! options.list && ! options.check) {
+		mkdir(options.dataPath.c_str(), 0755);
+	}
+
+	bench::Registry registry;
+	registry.setDataPath(options.dataPath);
+
+	bench::registerContainerBenchmarks(registry);
+	bench::registerMemoryBenchmarks(registry);
+	bench::registerMathBenchmarks(registry);
+	bench::registerSceneBenchmarks(registry);
+	bench::registerPhysicsBenchmarks(registry);
+	bench::registerRuntimeBenchmarks(registry);
+	bench::registerModelBenchmarks(registry);
+	bench::registerImageBenchmarks(registry);
+
+	return options.check ? registry.runChecks(options) : registry.runAll(options);
+}
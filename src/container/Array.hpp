@@ -13,6 +13,8 @@
 
 #include <type_traits>
 #include <initializer_list>
+#include <new>
+#include <utility>
 
 namespace stardazed {
 namespace container {
@@ -24,6 +26,7 @@ template <typename T>
 class Array {
 	static constexpr bool canSkipElementConstructor() { return std::is_trivially_default_constructible<T>::value; }
 	static constexpr bool canSkipElementDestructor() { return std::is_trivially_destructible<T>::value; }
+	static constexpr bool canRelocateElements() { return std::is_trivially_move_constructible<T>::value && canSkipElementDestructor(); }
 	
 	static constexpr float growthFactor_s = 1.5;
 
@@ -53,6 +56,74 @@ class Array {
 	}
 
 
+	// Grows the storage to newCapacity elements. For trivial Ts the elements
+	// from zeroFromIndex up to the new capacity are guaranteed to be zero.
+	void reserveImpl(uint newCapacity, uint zeroFromIndex) {
+		assert(newCapacity > 0);
+
+		if (newCapacity <= capacity()) {
+			return;
+		}
+		
+		auto newSizeBytes = newCapacity * elementSizeBytes();
+
+		if (data_ && canRelocateElements()) {
+			// Trivially relocatable elements can be moved by the allocator, which may
+			// be able to grow the block in place or remap it instead of copying.
+			// The part of the old block after count() is already zeroed.
+			auto oldCapacity = capacity();
+			auto newData = static_cast<T*>(allocator_.realloc(data_, oldCapacity * elementSizeBytes(), newSizeBytes));
+			assert(newData);
+
+			if (canSkipElementConstructor()) {
+				auto firstClearIndex = math::max(zeroFromIndex, oldCapacity);
+				if (firstClearIndex < newCapacity) {
+					memset(newData + firstClearIndex, 0, (newCapacity - firstClearIndex) * elementSizeBytes());
+				}
+			}
+
+			data_ = newData;
+			capacity_ = newCapacity;
+			return;
+		}
+		
+		auto newData = static_cast<T*>(allocator_.alloc(newSizeBytes));
+		assert(newData);
+		
+		// Not all Allocators return zero-filled memory but this container guarantees
+		// zeroed elements for default constructed values so we pre-clear the memory
+		if (canSkipElementConstructor() && ! allocator_.allocZeroesMemory() && zeroFromIndex < newCapacity) {
+			memset(newData + zeroFromIndex, 0, (newCapacity - zeroFromIndex) * elementSizeBytes());
+		}
+
+		if (data_) {
+			if (count() > 0) {
+				// Copy over the data to the new buffer and free the old one
+				if (std::is_trivially_move_constructible<T>::value) {
+					memcpy(newData, data_, count() * elementSizeBytes());
+				}
+				else {
+					auto elementsToCopy = count();
+					T* src = data_;
+					T* dst = newData;
+
+					while (elementsToCopy--) {
+						new (dst) T(std::move(*src)); // move-construct element in new array
+						src->~T();                    // still need to destroy element after move
+						++src;
+						++dst;
+					}
+				}
+			}
+
+			allocator_.free(data_);
+		}
+		
+		data_ = newData;
+		capacity_ = newCapacity;
+	}
+
+
 public:
 	Array(memory::Allocator& allocator, uint initialCapacity)
 	: allocator_(allocator)
@@ -193,48 +264,7 @@ public:
 	// -- storage sizing and object lifetime
 
 	void reserve(uint newCapacity) {
-		assert(newCapacity > 0);
-
-		if (newCapacity <= capacity()) {
-			return;
-		}
-		
-		auto newSizeBytes = newCapacity * elementSizeBytes();
-		
-		auto newData = static_cast<T*>(allocator_.alloc(newSizeBytes));
-		assert(newData);
-		
-		// Not all Allocators return zero-filled memory but this container guarantees
-		// zeroed elements for default constructed values so we pre-clear the memory
-		if (canSkipElementConstructor() && ! allocator_.allocZeroesMemory()) {
-			memset(newData, 0, newSizeBytes);
-		}
-
-		if (data_) {
-			if (count() > 0) {
-				// Copy over the data to the new buffer and free the old one
-				if (std::is_trivially_move_constructible<T>::value) {
-					memcpy(newData, data_, count() * elementSizeBytes());
-				}
-				else {
-					auto elementsToCopy = count();
-					T* src = data_;
-					T* dst = newData;
-
-					while (elementsToCopy--) {
-						new (dst) T(std::move(*src)); // move-construct element in new array
-						src->~T();                    // still need to destroy element after move
-						++src;
-						++dst;
-					}
-				}
-			}
-
-			allocator_.free(data_);
-		}
-		
-		data_ = newData;
-		capacity_ = newCapacity;
+		reserveImpl(newCapacity, count());
 	}
 	
 	
@@ -281,6 +311,21 @@ public:
 	}
 
 
+	// Same as resize(), but grown elements are not zeroed, the caller
+	// must overwrite all of them. Only available for trivial Ts.
+	void resizeUninitialized(uint newCount) {
+		static_assert(canSkipElementConstructor() && canSkipElementDestructor(), "T must be trivial for resizeUninitialized");
+
+		if (newCount > capacity()) {
+			reserveImpl(newCount, newCount);
+			count_ = newCount;
+		}
+		else {
+			resize(newCount);
+		}
+	}
+
+
 	// -- adding elements
 
 	void append(const T& t) {
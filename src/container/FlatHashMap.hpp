@@ -0,0 +1,440 @@
+// ------------------------------------------------------------------
+// container::FlatHashMap - stardazed
+// (c) 2016 by Arthur Langereis
+// Control byte layout after the SwissTable design by Google (Abseil)
+// ------------------------------------------------------------------
+
+#ifndef SD_CONTAINER_FLATHASHMAP_H
+#define SD_CONTAINER_FLATHASHMAP_H
+
+#include "system/Config.hpp"
+#include "memory/Allocator.hpp"
+#include "math/Algorithm.hpp"
+#include "util/Hash.hpp"
+#include "util/ConceptTraits.hpp"
+
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
+namespace stardazed {
+namespace container {
+
+
+struct ProbeStats {
+	float averageProbeLength; // slots between an entry and its home slot
+	uint32 maxProbeLength;
+	float loadFactor;
+};
+
+
+namespace detail {
+
+	// Each slot has a control byte, empty slots are 0x80, filled slots hold the
+	// top 7 bits of the slot's hash (h2). Probing scans a group of 16 control bytes
+	// at once. The table is linear probed and the first groupWidth control bytes are
+	// cloned after the last slot so that a group load never has to wrap around.
+
+	constexpr uint8 ctrlEmpty = 0x80;
+	constexpr uint32 groupWidth = 16;
+
+	struct ControlGroup {
+#if defined(__SSE2__)
+		__m128i ctrl;
+
+		explicit ControlGroup(const uint8* pos)
+		: ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos)))
+		{}
+
+		uint32 matchH2(uint8 h2) const {
+			return static_cast<uint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(static_cast<char>(h2)))));
+		}
+
+		// empty is the only control value with the high bit set
+		uint32 matchEmpty() const {
+			return static_cast<uint32>(_mm_movemask_epi8(ctrl));
+		}
+#else
+		const uint8* ctrl;
+
+		explicit ControlGroup(const uint8* pos)
+		: ctrl(pos)
+		{}
+
+		uint32 matchH2(uint8 h2) const {
+			uint32 mask = 0;
+			for (uint32 b = 0; b < groupWidth; ++b) {
+				mask |= uint32(ctrl[b] == h2) << b;
+			}
+			return mask;
+		}
+
+		uint32 matchEmpty() const {
+			uint32 mask = 0;
+			for (uint32 b = 0; b < groupWidth; ++b) {
+				mask |= uint32(ctrl[b] >> 7) << b;
+			}
+			return mask;
+		}
+#endif
+	};
+
+} // ns detail
+
+
+template <typename Key, typename Value>
+class FlatHashMap {
+	static constexpr bool trivialDestructors = (std::is_trivially_destructible<Key>::value && std::is_trivially_destructible<Value>::value);
+	static constexpr uint32 minimumCapacity = detail::groupWidth;
+
+	memory::Allocator& allocator_;
+	uint8* ctrl_ = nullptr;
+	Key* keys_ = nullptr;
+	Value* values_ = nullptr;
+	uint32 capacity_ = 0, mask_ = 0, count_ = 0, growthLimit_ = 0;
+	float maxLoadFactor_ = 0.875f;
+
+
+	// Mix the user hash so that identity hashes of sequential keys spread
+	// over both the slot index (low bits) and the h2 tag (top 7 bits).
+	static uint64 mixedHash(const Key& key) {
+		auto h = hash(key) * 0x9E3779B97F4A7C15ull;
+		return h ^ (h >> 32);
+	}
+
+	static uint8 h2(uint64 mixed) { return static_cast<uint8>(mixed >> 57); }
+	uint32 homeSlot(uint64 mixed) const { return static_cast<uint32>(mixed) & mask_; }
+
+	bool isFilled(uint32 slot) const { return (ctrl_[slot] & detail::ctrlEmpty) == 0; }
+
+	void setCtrl(uint32 slot, uint8 value) {
+		ctrl_[slot] = value;
+		// keep the cloned bytes after the last slot in sync
+		if (slot < detail::groupWidth) {
+			ctrl_[capacity_ + slot] = value;
+		}
+	}
+
+
+	static uint64 blockSizeBytes(uint32 capacity) {
+		return valuesOffset(capacity) + (capacity * sizeof(Value));
+	}
+
+	static uint64 keysOffset(uint32 capacity) {
+		return math::alignUp(uint64(capacity + detail::groupWidth), alignof(Key));
+	}
+
+	static uint64 valuesOffset(uint32 capacity) {
+		return math::alignUp(keysOffset(capacity) + (capacity * sizeof(Key)), alignof(Value));
+	}
+
+
+	void allocateTable(uint32 capacity) {
+		assert(capacity >= minimumCapacity && (capacity & (capacity - 1)) == 0);
+		static_assert(alignof(Key) <= alignof(max_align_t) && alignof(Value) <= alignof(max_align_t), "over-aligned Key or Value");
+
+		auto block = static_cast<uint8*>(allocator_.alloc(blockSizeBytes(capacity)));
+		assert(block);
+
+		ctrl_ = block;
+		keys_ = reinterpret_cast<Key*>(block + keysOffset(capacity));
+		values_ = reinterpret_cast<Value*>(block + valuesOffset(capacity));
+		memset(ctrl_, detail::ctrlEmpty, capacity + detail::groupWidth);
+
+		capacity_ = capacity;
+		mask_ = capacity - 1;
+		growthLimit_ = growthLimitFor(capacity);
+	}
+
+
+	// at least one slot stays empty so probe sequences always end
+	uint32 growthLimitFor(uint32 capacity) const {
+		return math::min(static_cast<uint32>(capacity * maxLoadFactor_), capacity - 1);
+	}
+
+
+	void destroyElements() {
+		if (! trivialDestructors) {
+			for (uint32 slot = 0; slot < capacity_; ++slot) {
+				if (isFilled(slot)) {
+					keys_[slot].~Key();
+					values_[slot].~Value();
+				}
+			}
+		}
+	}
+
+
+	bool findSlot(const Key& key, uint64 mixed, uint32& outSlot) const {
+		auto tag = h2(mixed);
+		auto pos = homeSlot(mixed);
+
+		for (;;) {
+			detail::ControlGroup group { ctrl_ + pos };
+
+			auto matches = group.matchH2(tag);
+			while (matches) {
+				auto slot = (pos + __builtin_ctz(matches)) & mask_;
+				if (__builtin_expect(keys_[slot] == key, 1)) {
+					outSlot = slot;
+					return true;
+				}
+				matches &= matches - 1;
+			}
+
+			// with linear probing an empty slot ends the probe sequence
+			if (group.matchEmpty())
+				return false;
+
+			pos = (pos + detail::groupWidth) & mask_;
+		}
+	}
+
+
+	uint32 firstEmptySlot(uint64 mixed) const {
+		auto pos = homeSlot(mixed);
+
+		for (;;) {
+			auto empties = detail::ControlGroup{ ctrl_ + pos }.matchEmpty();
+			if (empties)
+				return (pos + __builtin_ctz(empties)) & mask_;
+
+			pos = (pos + detail::groupWidth) & mask_;
+		}
+	}
+
+
+	// Assumes key is not present and that there is room
+	template <typename K, typename V>
+	Value* insertNew(uint64 mixed, K&& key, V&& value) {
+		auto slot = firstEmptySlot(mixed);
+		setCtrl(slot, h2(mixed));
+		new (keys_ + slot) Key{ std::forward<K>(key) };
+		new (values_ + slot) Value{ std::forward<V>(value) };
+		++count_;
+		return values_ + slot;
+	}
+
+
+	void eraseSlot(uint32 slot) {
+		keys_[slot].~Key();
+		values_[slot].~Value();
+		--count_;
+
+		// Backward-shift deletion: pull following entries of the cluster into
+		// the hole if that does not move them in front of their home slot.
+		auto hole = slot;
+		auto next = slot;
+
+		for (;;) {
+			next = (next + 1) & mask_;
+			if (! isFilled(next))
+				break;
+
+			auto home = homeSlot(mixedHash(keys_[next]));
+			if (((next - home) & mask_) >= ((next - hole) & mask_)) {
+				new (keys_ + hole) Key{ std::move(keys_[next]) };
+				new (values_ + hole) Value{ std::move(values_[next]) };
+				keys_[next].~Key();
+				values_[next].~Value();
+				setCtrl(hole, ctrl_[next]);
+				hole = next;
+			}
+		}
+
+		setCtrl(hole, detail::ctrlEmpty);
+	}
+
+
+	uint32 capacityForCount(uint32 count) const {
+		auto capacity = math::max(math::roundUpPowerOf2(static_cast<uint32>(count / maxLoadFactor_) + 1), minimumCapacity);
+		while (growthLimitFor(capacity) < count) {
+			capacity *= 2;
+		}
+		return capacity;
+	}
+
+public:
+	FlatHashMap(memory::Allocator& allocator, uint initialCapacity)
+	: allocator_(allocator)
+	{
+		allocateTable(capacityForCount(initialCapacity));
+	}
+
+	FlatHashMap() : FlatHashMap{ memory::SystemAllocator::sharedInstance(), 64 } {}
+	explicit FlatHashMap(memory::Allocator& allocator) : FlatHashMap{ allocator, 64 } {}
+	explicit FlatHashMap(uint initialCapacity) : FlatHashMap{ memory::SystemAllocator::sharedInstance(), initialCapacity } {}
+	SD_NOCOPYORMOVE_CLASS(FlatHashMap)
+
+	~FlatHashMap() {
+		destroyElements();
+		allocator_.free(ctrl_);
+	}
+
+
+	uint count() const { return count_; }
+	bool empty() const { return count_ == 0; }
+	uint bucketCount() const { return capacity_; }
+
+	// The table grows when an insert would exceed maxLoadFactor * bucketCount.
+	// Lower factors trade memory for shorter probes, the default is 7/8.
+	float maxLoadFactor() const { return maxLoadFactor_; }
+	void setMaxLoadFactor(float maxLoadFactor) {
+		assert(maxLoadFactor > 0 && maxLoadFactor < 1);
+		maxLoadFactor_ = maxLoadFactor;
+		growthLimit_ = growthLimitFor(capacity_);
+		if (count_ > growthLimit_) {
+			rehash(capacityForCount(count_));
+		}
+	}
+
+	// diagnostic, walks the whole table
+	ProbeStats probeStats() const {
+		uint64 totalProbe = 0;
+		uint32 maxProbe = 0;
+		for (uint32 slot = 0; slot < capacity_; ++slot) {
+			if (isFilled(slot)) {
+				auto probe = (slot - homeSlot(mixedHash(keys_[slot]))) & mask_;
+				totalProbe += probe;
+				maxProbe = math::max(maxProbe, probe);
+			}
+		}
+		return {
+			count_ ? static_cast<float>(totalProbe) / count_ : 0.f,
+			maxProbe,
+			static_cast<float>(count_) / capacity_
+		};
+	}
+
+	memory::Allocator& allocator() const { return allocator_; }
+
+
+	// inserts a new entry or overwrites the value of an existing one
+	void insert(const Key& key, const Value& value) {
+		auto mixed = mixedHash(key);
+		uint32 slot;
+
+		if (findSlot(key, mixed, slot)) {
+			values_[slot] = value;
+			return;
+		}
+
+		if (__builtin_expect(count_ == growthLimit_, 0)) {
+			rehash(capacity_ * 2);
+		}
+
+		insertNew(mixed, key, value);
+	}
+
+
+	Value* find(const Key& key) const {
+		uint32 slot;
+		if (findSlot(key, mixedHash(key), slot)) {
+			return values_ + slot;
+		}
+		return nullptr;
+	}
+
+
+	void remove(const Key& key) {
+		uint32 slot;
+		if (findSlot(key, mixedHash(key), slot)) {
+			eraseSlot(slot);
+		}
+	}
+
+
+	void clear() {
+		destroyElements();
+		memset(ctrl_, detail::ctrlEmpty, capacity_ + detail::groupWidth);
+		count_ = 0;
+	}
+
+
+	void reserve(uint newCapacity) {
+		rehash(capacityForCount(newCapacity));
+	}
+
+
+	void rehash(uint newBucketCount) {
+		auto newCapacity = math::max(math::roundUpPowerOf2(newBucketCount), capacityForCount(count_));
+		if (newCapacity == capacity_)
+			return;
+
+		auto oldCtrl = ctrl_;
+		auto oldKeys = keys_;
+		auto oldValues = values_;
+		auto oldCapacity = capacity_;
+
+		allocateTable(newCapacity);
+		count_ = 0;
+
+		for (uint32 slot = 0; slot < oldCapacity; ++slot) {
+			if ((oldCtrl[slot] & detail::ctrlEmpty) == 0) {
+				insertNew(mixedHash(oldKeys[slot]), std::move(oldKeys[slot]), std::move(oldValues[slot]));
+				oldKeys[slot].~Key();
+				oldValues[slot].~Value();
+			}
+		}
+
+		allocator_.free(oldCtrl);
+	}
+
+
+	// -- ranges (experimental)
+private:
+	class Range {
+		const uint8 *ctrlPtr_, *endCtrlPtr_;
+		Key* keyPtr_;
+		Value* valuePtr_;
+
+	public:
+		Range(FlatHashMap& map) {
+			ctrlPtr_ = map.ctrl_ - 1;
+			endCtrlPtr_ = map.ctrl_ + map.capacity_;
+			keyPtr_ = map.keys_ - 1;
+			valuePtr_ = map.values_ - 1;
+		}
+
+		bool next() {
+			while (ctrlPtr_ != endCtrlPtr_) {
+				++ctrlPtr_;
+				++keyPtr_;
+				++valuePtr_;
+
+				if (ctrlPtr_ != endCtrlPtr_ && (*ctrlPtr_ & detail::ctrlEmpty) == 0)
+					break;
+			}
+			return ctrlPtr_ != endCtrlPtr_;
+		}
+
+		struct KeyVal {
+			const Key& key;
+			const Value& val;
+		};
+
+		KeyVal current() {
+			return { *keyPtr_, *valuePtr_ };
+		}
+	};
+
+public:
+	Range all() {
+		return { *this };
+	}
+};
+
+
+} // ns container
+
+
+// -- export to sd namespace
+using container::FlatHashMap;
+
+
+} // ns stardazed
+
+#endif
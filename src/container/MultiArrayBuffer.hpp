@@ -10,6 +10,7 @@
 #include "memory/Allocator.hpp"
 #include "math/Algorithm.hpp"
 
+#include <algorithm>
 #include <utility>
 #include <functional>
 
@@ -103,6 +104,33 @@ namespace detail {
 		EachArrayBasePtr<sizeof...(Ts) - 1, Ts...>::apply(basePtr, capacity, fn);
 	}
 
+
+
+	// -- Call a callback with the old and new base pointers of each T, last T first
+	// Used internally in MAB::reserve to re-layout the arrays inside a resized block
+
+	template <size_t Counter, typename T, typename... Ts>
+	struct EachArrayBasePtrReverse {
+		template <typename Fn>
+		static void apply(uint8* oldBasePtr, uint8* newBasePtr, uint32 oldCapacity, uint32 newCapacity, const Fn& fn) {
+			EachArrayBasePtrReverse<Counter - 1, Ts...>::apply(oldBasePtr + (oldCapacity * sizeof(T)), newBasePtr + (newCapacity * sizeof(T)), oldCapacity, newCapacity, fn);
+			fn(oldBasePtr, newBasePtr, sizeof32<T>());
+		}
+	};
+	
+	template <typename T, typename... Ts>
+	struct EachArrayBasePtrReverse<0, T, Ts...> {
+		template <typename Fn>
+		static void apply(uint8* oldBasePtr, uint8* newBasePtr, uint32 /*oldCapacity*/, uint32 /*newCapacity*/, const Fn& fn) {
+			fn(oldBasePtr, newBasePtr, sizeof32<T>());
+		}
+	};
+	
+	template <typename... Ts, typename Fn>
+	void eachArrayBasePtrReverse(uint8* oldBasePtr, uint8* newBasePtr, uint32 oldCapacity, uint32 newCapacity, const Fn& fn) {
+		EachArrayBasePtrReverse<sizeof...(Ts) - 1, Ts...>::apply(oldBasePtr, newBasePtr, oldCapacity, newCapacity, fn);
+	}
+
 } // ns detail
 
 
@@ -112,15 +140,122 @@ enum class InvalidatePointers : int {
 };
 
 
-template <typename... Ts>
-class MultiArrayBuffer {
+// -- Column layout policies
+// capacityMultiple: the capacity is always a multiple of this many elements
+// columnAlignment: minimum byte alignment of each column's base pointer
+
+// Columns follow each other directly, alignment is whatever the allocator provides.
+struct PackedColumnLayout {
+	static constexpr uint32 capacityMultiple = 32;
+	static constexpr uint32 columnAlignment = 1;
+};
+
+// Every column starts on an Alignment byte boundary (a cache line by default)
+// and has a multiple of Alignment elements, which is also a whole number of
+// SIMD vectors for any element type, so kernels can use aligned loads up to the end.
+template <uint32 Alignment = 64>
+struct AlignedColumnLayout {
+	static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be a power of 2");
+	static constexpr uint32 capacityMultiple = Alignment;
+	static constexpr uint32 columnAlignment = Alignment;
+};
+
+
+template <typename Layout, typename... Ts>
+class BasicMultiArrayBuffer {
 	memory::Allocator* allocator_;
 	uint32 capacity_ = 0, count_ = 0;
 	void* data_ = nullptr;
+	void* block_ = nullptr; // allocated block, data_ is aligned up from here
+
+	// Grows the storage to newCapacity elements, the elements from
+	// zeroFromIndex up to the new capacity are guaranteed to be zero.
+	InvalidatePointers reserveImpl(uint32 newCapacity, uint32 zeroFromIndex) {
+		assert(newCapacity > 0);
+
+		// By forcing an allocated multiple of capacityMultiple elements, we never have
+		// to worry about padding between consecutive arrays. For the packed layout 32
+		// is chosen as it is the AVX layout requirement, so e.g. a char field followed
+		// by an m256 field will be aligned regardless of array length.
+		// We could align to 16 or even 8 and likely be fine, but this container
+		// isn't meant for tiny arrays so 32 it is.
+
+		newCapacity = math::alignUp(newCapacity, Layout::capacityMultiple);
+		if (newCapacity <= capacity()) {
+			// TODO: add way to cut capacity?
+			return InvalidatePointers::No;
+		}
+		
+		auto newSizeBytes = newCapacity * detail::elementSumSize<Ts...>();
+		
+		// over-allocate if the allocator cannot provide the column alignment by itself
+		auto alignmentSlack = (columnAlignment > allocator_->guaranteedAlignment()) ? columnAlignment : 0;
+
+		if (data_) {
+			// Let the allocator resize the block, it may be able to grow it in place
+			// or remap its pages, after which the columns are re-laid out in place.
+			// If it fails the old block is untouched and the buffer stays as it was.
+			auto oldDataOffset = static_cast<uint32>(static_cast<uint8*>(data_) - static_cast<uint8*>(block_));
+			auto oldSizeBytes = capacity_ * detail::elementSumSize<Ts...>();
+			auto newBlock = allocator_->realloc(block_, oldSizeBytes + alignmentSlack, newSizeBytes + alignmentSlack);
+			if (! newBlock) {
+				assert(! "MultiArrayBuffer: could not grow storage");
+				return InvalidatePointers::No;
+			}
+
+			auto oldData = static_cast<uint8*>(newBlock) + oldDataOffset;
+			auto newData = reinterpret_cast<uint8*>(math::alignUp(reinterpret_cast<uint64>(newBlock), columnAlignment));
+
+			// Each column moves up by (its offset * growth), which is at least one
+			// capacityMultiple worth of bytes for all but the first, so moving them
+			// back to front never overwrites a column that still has to move.
+			// With large arrays >100k elements this can take millisecond-order time,
+			// so avoid resizes when possible.
+			bool columnsMoved = newBlock != block_;
+			detail::eachArrayBasePtrReverse<Ts...>(oldData, newData, capacity_, newCapacity,
+				[usedCount = count_, zeroFromIndex, newCapacity, &columnsMoved]
+				(uint8* oldBasePtr, uint8* newBasePtr, uint32 elementSizeBytes) {
+					if (oldBasePtr != newBasePtr) {
+						memmove(newBasePtr, oldBasePtr, usedCount * elementSizeBytes);
+						columnsMoved = true;
+					}
+					if (zeroFromIndex < newCapacity) {
+						memset(newBasePtr + (zeroFromIndex * elementSizeBytes), 0, (newCapacity - zeroFromIndex) * elementSizeBytes);
+					}
+				});
+
+			block_ = newBlock;
+			data_ = newData;
+			capacity_ = newCapacity;
+
+			// a single column grown in place keeps its address
+			return columnsMoved ? InvalidatePointers::Yes : InvalidatePointers::No;
+		}
+
+		auto newBlock = allocator_->alloc(newSizeBytes + alignmentSlack);
+		if (! newBlock) {
+			assert(! "MultiArrayBuffer: could not allocate storage");
+			return InvalidatePointers::No;
+		}
+		auto newData = reinterpret_cast<void*>(math::alignUp(reinterpret_cast<uint64>(newBlock), columnAlignment));
+		
+		// Not all Allocators return zero-filled memory but this container guarantees
+		// zeroed elements so we clear the memory explicitly if necessary.
+		if (! allocator_->allocZeroesMemory()) {
+			memset(newData, 0, newSizeBytes);
+		}
+
+		block_ = newBlock;
+		data_ = newData;
+		capacity_ = newCapacity;
+		
+		return InvalidatePointers::No;
+	}
 
 public:
 	static constexpr uint32 elementCount = sizeof...(Ts);
 	static constexpr float growthFactor_s = 1.5f;
+	static constexpr uint32 columnAlignment = Layout::columnAlignment;
 	
 	template <uint32 Index>
 	static constexpr size32 elementSizeBytes() {
@@ -128,15 +263,15 @@ public:
 	}
 
 
-	MultiArrayBuffer(memory::Allocator& allocator, uint32 initialCapacity)
+	BasicMultiArrayBuffer(memory::Allocator& allocator, uint32 initialCapacity)
 	: allocator_(&allocator)
 	{
 		reserve(initialCapacity);
 	}
 
 	
-	~MultiArrayBuffer() {
-		allocator_->free(data_);
+	~BasicMultiArrayBuffer() {
+		allocator_->free(block_);
 	}
 
 	
@@ -151,55 +286,7 @@ public:
 
 	
 	InvalidatePointers reserve(uint32 newCapacity) {
-		assert(newCapacity > 0);
-
-		// By forcing an allocated multiple of 32 elements, we never have
-		// to worry about padding between consecutive arrays. 32 is chosen
-		// as it is the AVX layout requirement, so e.g. a char field followed
-		// by an m256 field will be aligned regardless of array length.
-		// We could align to 16 or even 8 and likely be fine, but this container
-		// isn't meant for tiny arrays so 32 it is.
-
-		newCapacity = math::alignUp(newCapacity, 32);
-		if (newCapacity <= capacity()) {
-			// TODO: add way to cut capacity?
-			return InvalidatePointers::No;
-		}
-		
-		auto invalidation = InvalidatePointers::No;
-		auto newSizeBytes = newCapacity * detail::elementSumSize<Ts...>();
-		
-		auto newData = allocator_->alloc(newSizeBytes);
-		assert(newData);
-		
-		// Not all Allocators return zero-filled memory but this container guarantees
-		// zeroed elements so we clear the memory explicitly if necessary.
-		if (! allocator_->allocZeroesMemory()) {
-			memset(newData, 0, newSizeBytes);
-		}
-
-		if (data_) {
-			// Since a capacity change will change the length of each array individually
-			// we need to re-layout the data in the new buffer.
-			// We iterate over the basePointers and copy count_ elements from the old
-			// data to each new array. With large arrays >100k elements this can take
-			// millisecond-order time, so avoid resizes when possible.
-
-			detail::eachArrayBasePtr<Ts...>(data_, capacity_,
-				[newDataPtr = (uint8*)newData, newCapacity, usedCount = count_]
-				(void* basePtr, uint32 elementSizeBytes) mutable {
-					memcpy(newDataPtr, basePtr, usedCount * elementSizeBytes);
-					newDataPtr += elementSizeBytes * newCapacity;
-				});
-			
-			allocator_->free(data_);
-			invalidation = InvalidatePointers::Yes;
-		}
-		
-		data_ = newData;
-		capacity_ = newCapacity;
-		
-		return invalidation;
+		return reserveImpl(newCapacity, count_);
 	}
 
 	
@@ -214,6 +301,8 @@ public:
 
 		if (newCount > capacity()) {
 			invalidation = reserve(newCount);
+			if (newCount > capacity())
+				return invalidation;
 		}
 		else if (newCount < count()) {
 			// Reducing the count will clear the now freed up elements so that when
@@ -234,11 +323,28 @@ public:
 	}
 	
 	
+	// Same as resize(), but grown elements are not zeroed, the
+	// caller must overwrite all of them in every array.
+	InvalidatePointers resizeUninitialized(uint32 newCount) {
+		if (newCount > capacity()) {
+			auto invalidation = reserveImpl(newCount, newCount);
+			if (newCount <= capacity()) {
+				count_ = newCount;
+			}
+			return invalidation;
+		}
+
+		return resize(newCount);
+	}
+	
+	
 	InvalidatePointers extend() {
 		auto invalidation = InvalidatePointers::No;
 
 		if (count_ == capacity_) {
 			invalidation = reserve(capacity_ * growthFactor_s);
+			if (count_ == capacity_)
+				return invalidation;
 		}
 
 		++count_;
@@ -246,21 +352,62 @@ public:
 	}
 
 	
+	// Moves the last element over the element at index and removes the last
+	// element, the order of elements is not preserved.
+	void swapRemove(uint32 index) {
+		assert(index < count_);
+		auto lastIndex = count_ - 1;
+
+		detail::eachArrayBasePtr<Ts...>(data_, capacity_,
+			[index, lastIndex](void* basePtr, uint32 elementSizeBytes) {
+				auto bytePtr = static_cast<uint8*>(basePtr);
+				if (index != lastIndex) {
+					memcpy(bytePtr + (elementSizeBytes * index), bytePtr + (elementSizeBytes * lastIndex), elementSizeBytes);
+				}
+				memset(bytePtr + (elementSizeBytes * lastIndex), 0, elementSizeBytes);
+			});
+
+		--count_;
+	}
+
+
+	// Exchanges the elements at indexes a and b in all arrays.
+	void swapElements(uint32 a, uint32 b) {
+		assert(a < count_ && b < count_);
+		if (a == b)
+			return;
+
+		detail::eachArrayBasePtr<Ts...>(data_, capacity_,
+			[a, b](void* basePtr, uint32 elementSizeBytes) {
+				auto bytePtr = static_cast<uint8*>(basePtr);
+				std::swap_ranges(bytePtr + (elementSizeBytes * a), bytePtr + (elementSizeBytes * (a + 1)), bytePtr + (elementSizeBytes * b));
+			});
+	}
+
+	
 	template <uint32 Index>
 	auto elementsBasePtr() const {
 		auto basePtr = static_cast<uint8_t*>(data_) + (detail::elementOffset<Index, Ts...>() * capacity_);
-		return reinterpret_cast<typename detail::ElementType<Index, Ts...>::Type*>(basePtr);
+		return reinterpret_cast<typename detail::ElementType<Index, Ts...>::Type*>(__builtin_assume_aligned(basePtr, columnAlignment));
 	}
 	
 	
-	void swap(MultiArrayBuffer& other) {
+	void swap(BasicMultiArrayBuffer& other) {
 		std::swap(allocator_, other.allocator_);
 		std::swap(capacity_, other.capacity_);
 		std::swap(count_, other.count_);
 		std::swap(data_, other.data_);
+		std::swap(block_, other.block_);
 	}
 };
 
+
+template <typename... Ts>
+using MultiArrayBuffer = BasicMultiArrayBuffer<PackedColumnLayout, Ts...>;
+
+template <typename... Ts>
+using AlignedMultiArrayBuffer = BasicMultiArrayBuffer<AlignedColumnLayout<64>, Ts...>;
+
 	
 } // ns container
 } // ns stardazed
@@ -10,6 +10,7 @@
 #include "memory/Allocator.hpp"
 
 #include <type_traits>
+#include <utility>
 
 namespace stardazed {
 namespace container {
@@ -157,6 +158,17 @@ public:
 	T* data() {
 		return data_;
 	}
+
+	// -- indexed access, index 0 is the front element
+	T& operator[](uint index) {
+		assert(index < count_);
+		return data_[(head_ + index) % capacity_];
+	}
+
+	const T& operator[](uint index) const {
+		assert(index < count_);
+		return data_[(head_ + index) % capacity_];
+	}
 };
 
 
@@ -0,0 +1,240 @@
+// ------------------------------------------------------------------
+// container::SparseSet - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_CONTAINER_SPARSESET_H
+#define SD_CONTAINER_SPARSESET_H
+
+#include "system/Config.hpp"
+#include "memory/Allocator.hpp"
+#include "container/Array.hpp"
+#include "util/ConceptTraits.hpp"
+
+namespace stardazed {
+namespace container {
+
+
+// Maps a key to the sparse index it is stored under. Keys that carry
+// more than an index (e.g. a generation) are compared in full on lookup.
+// Specialize for key types that are not plain unsigned integers.
+
+template <typename Key>
+struct SparseKeyTraits {
+	static uint32 index(Key key) { return static_cast<uint32>(key); }
+};
+
+
+// Map from small integer-like keys to values, stored as a paged sparse
+// array of dense indexes plus dense, packed arrays of keys and values.
+// Lookup costs at most two dependent loads (page table and page entry) before
+// touching the dense arrays. Removal swaps the last element into the hole,
+// so the dense arrays stay packed but the order of elements is not stable.
+
+template <typename Key, typename Value>
+class SparseSet {
+	using Traits = SparseKeyTraits<Key>;
+
+	static constexpr uint32 pageShift = 12;
+	static constexpr uint32 pageSize = 1 << pageShift; // entries per page
+	static constexpr uint32 pageMask = pageSize - 1;
+	static constexpr uint32 notPresent = 0xffffffff;
+
+	memory::Allocator& allocator_;
+	Array<uint32*> pages_;
+	Array<Key> keys_;
+	Array<Value> values_;
+
+
+	uint32* sparseEntry(uint32 index) const {
+		auto pageIndex = index >> pageShift;
+		if (pageIndex >= pages_.count())
+			return nullptr;
+
+		auto page = pages_[pageIndex];
+		if (! page)
+			return nullptr;
+
+		return page + (index & pageMask);
+	}
+
+
+	uint32& sparseEntryCreate(uint32 index) {
+		auto pageIndex = index >> pageShift;
+		if (pageIndex >= pages_.count()) {
+			pages_.resize(pageIndex + 1); // new page pointers are zeroed
+		}
+
+		auto& page = pages_[pageIndex];
+		if (! page) {
+			page = static_cast<uint32*>(allocator_.alloc(pageSize * sizeof(uint32)));
+			assert(page);
+			memset(page, 0xff, pageSize * sizeof(uint32));
+		}
+
+		return page[index & pageMask];
+	}
+
+
+	bool findDense(const Key& key, uint32& outDenseIndex) const {
+		auto entry = sparseEntry(Traits::index(key));
+		if (! entry || *entry == notPresent)
+			return false;
+
+		// the sparse index may be shared by an older or newer key, e.g. an entity generation
+		if (! (keys_[*entry] == key))
+			return false;
+
+		outDenseIndex = *entry;
+		return true;
+	}
+
+public:
+	SparseSet(memory::Allocator& allocator, uint initialCapacity)
+	: allocator_(allocator)
+	, pages_(allocator, 16)
+	, keys_(allocator, initialCapacity)
+	, values_(allocator, initialCapacity)
+	{}
+
+	SparseSet() : SparseSet{ memory::SystemAllocator::sharedInstance(), 64 } {}
+	explicit SparseSet(memory::Allocator& allocator) : SparseSet{ allocator, 64 } {}
+	explicit SparseSet(uint initialCapacity) : SparseSet{ memory::SystemAllocator::sharedInstance(), initialCapacity } {}
+	SD_NOCOPYORMOVE_CLASS(SparseSet)
+
+	~SparseSet() {
+		for (uint p = 0; p < pages_.count(); ++p) {
+			allocator_.free(pages_[p]);
+		}
+	}
+
+
+	uint count() const { return keys_.count(); }
+	bool empty() const { return keys_.count() == 0; }
+
+	memory::Allocator& allocator() const { return allocator_; }
+
+	// -- dense arrays, valid until the next insert or remove
+	const Key* keysBasePtr() const { return keys_.elementsBasePtr(); }
+	Value* valuesBasePtr() { return values_.elementsBasePtr(); }
+
+
+	// inserts a new entry or overwrites the value of an existing one
+	void insert(const Key& key, const Value& value) {
+		auto& entry = sparseEntryCreate(Traits::index(key));
+
+		if (entry != notPresent && keys_[entry] == key) {
+			values_[entry] = value;
+			return;
+		}
+
+		// a stale key with the same index is replaced
+		if (entry != notPresent) {
+			keys_[entry] = key;
+			values_[entry] = value;
+			return;
+		}
+
+		entry = keys_.count();
+		keys_.append(key);
+		values_.append(value);
+	}
+
+
+	Value* find(const Key& key) {
+		uint32 denseIndex;
+		if (findDense(key, denseIndex)) {
+			return &values_[denseIndex];
+		}
+		return nullptr;
+	}
+
+	const Value* find(const Key& key) const {
+		uint32 denseIndex;
+		if (findDense(key, denseIndex)) {
+			return &values_[denseIndex];
+		}
+		return nullptr;
+	}
+
+
+	void remove(const Key& key) {
+		uint32 denseIndex;
+		if (! findDense(key, denseIndex))
+			return;
+
+		auto lastIndex = keys_.count() - 1;
+		if (denseIndex != lastIndex) {
+			// move the last element into the hole and repoint its sparse entry
+			keys_[denseIndex] = keys_[lastIndex];
+			values_[denseIndex] = std::move(values_[lastIndex]);
+			*sparseEntry(Traits::index(keys_[denseIndex])) = denseIndex;
+		}
+
+		*sparseEntry(Traits::index(key)) = notPresent;
+		keys_.popBack();
+		values_.popBack();
+	}
+
+
+	void clear() {
+		for (uint k = 0; k < keys_.count(); ++k) {
+			*sparseEntry(Traits::index(keys_[k])) = notPresent;
+		}
+		keys_.clear();
+		values_.clear();
+	}
+
+
+	void reserve(uint newCapacity) {
+		keys_.reserve(newCapacity);
+		values_.reserve(newCapacity);
+	}
+
+
+	// -- ranges (experimental)
+private:
+	class Range {
+		const Key *keyPtr_, *endKeyPtr_;
+		const Value* valuePtr_;
+
+	public:
+		Range(SparseSet& set)
+		: keyPtr_(set.keys_.elementsBasePtr() - 1)
+		, endKeyPtr_(set.keys_.elementsBasePtr() + set.keys_.count())
+		, valuePtr_(set.values_.elementsBasePtr() - 1)
+		{}
+
+		bool next() {
+			++keyPtr_;
+			++valuePtr_;
+			return keyPtr_ < endKeyPtr_;
+		}
+
+		struct KeyVal {
+			const Key& key;
+			const Value& val;
+		};
+
+		KeyVal current() {
+			return { *keyPtr_, *valuePtr_ };
+		}
+	};
+
+public:
+	Range all() {
+		return { *this };
+	}
+};
+
+
+} // ns container
+
+
+// -- export to sd namespace
+using container::SparseSet;
+
+
+} // ns stardazed
+
+#endif
@@ -9,15 +9,24 @@
 #include "system/Config.hpp"
 
 #include <string>
-#include <CoreFoundation/CFURL.h>
-#include <CoreFoundation/CFStream.h>
+
+#if SD_PLATFORM_OSX
+#	include <CoreFoundation/CFURL.h>
+#	include <CoreFoundation/CFStream.h>
+#else
+#	include <cstdio>
+#endif
 
 namespace stardazed {
 namespace fs {
 
 
 class Path {
+#if SD_PLATFORM_OSX
 	CFURLRef url_;
+#else
+	std::string path_; // absolute
+#endif
 
 public:
 	Path(const std::string& absPath);
@@ -30,7 +39,11 @@ public:
 	
 	~Path();
 	
+#if SD_PLATFORM_OSX
 	CFURLRef nativeHandle() const { return url_; }
+#else
+	const std::string& nativeHandle() const { return path_; }
+#endif
 	
 	std::string toString() const;
 	std::string extension() const;
@@ -39,7 +52,12 @@ public:
 
 
 class FileReadStream {
+#if SD_PLATFORM_OSX
 	CFReadStreamRef stream_;
+#else
+	std::FILE* file_;
+	bool atEnd_ = false; // sticky like CFReadStream's AtEnd status, seeks do not reset it
+#endif
 
 public:
 	FileReadStream(const Path&);
@@ -0,0 +1,146 @@
+// ------------------------------------------------------------------
+// fs::FileSystem - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "filesystem/FileSystem.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace stardazed {
+namespace fs {
+
+
+namespace {
+
+	std::string currentDirectory() {
+		std::string dir;
+		dir.resize(1024);
+		while (getcwd(&dir.front(), dir.size()) == nullptr) {
+			dir.resize(dir.size() * 2);
+		}
+		dir.resize(std::strlen(dir.c_str()));
+		return dir;
+	}
+
+
+	// paths are stored absolute and without a trailing slash, like CFURL does
+	void stripTrailingSlash(std::string& path) {
+		if (path.size() > 1 && path.back() == '/') {
+			path.pop_back();
+		}
+	}
+
+} // anonymous namespace
+
+
+Path::Path(const std::string& absPath)
+: path_(absPath)
+{
+	if (path_.empty() || path_.front() != '/') {
+		path_ = currentDirectory() + '/' + path_;
+	}
+	stripTrailingSlash(path_);
+}
+
+
+Path::Path(const Path& basePath, const std::string& relPath)
+: path_(basePath.path_)
+{
+	if (path_.back() != '/') {
+		path_ += '/';
+	}
+	path_ += relPath;
+	stripTrailingSlash(path_);
+}
+
+
+Path::Path(const Path& path) = default;
+
+
+Path::~Path() = default;
+
+
+int64 Path::fileSize() const {
+	struct stat info;
+	if (stat(path_.c_str(), &info) == 0) {
+		return info.st_size;
+	}
+	return 0;
+}
+
+
+std::string Path::toString() const {
+	return path_;
+}
+
+
+std::string Path::extension() const {
+	auto lastSlash = path_.rfind('/');
+	auto lastDot = path_.rfind('.');
+	if (lastDot == std::string::npos || (lastSlash != std::string::npos && lastDot < lastSlash)) {
+		return {};
+	}
+
+	// force lower-case extension
+	std::string ext = path_.substr(lastDot + 1);
+	std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) {
+		return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	});
+	return ext;
+}
+
+
+FileReadStream::FileReadStream(const Path& path)
+: file_(std::fopen(path.nativeHandle().c_str(), "rb"))
+{
+	assert(file_);
+}
+
+
+FileReadStream::~FileReadStream() {
+	if (file_) {
+		std::fclose(file_);
+	}
+}
+
+
+void FileReadStream::readBytes(void* buffer, size64 byteCount) {
+	if (std::fread(buffer, 1, byteCount, file_) < byteCount) {
+		atEnd_ = true;
+	}
+}
+
+
+int64 FileReadStream::offset() const {
+	return ftello(file_);
+}
+
+
+void FileReadStream::seekAbsolute(int64 newOffset) const {
+	fseeko(file_, newOffset, SEEK_SET);
+}
+
+
+void FileReadStream::seekRelative(int64 displacement) const {
+	fseeko(file_, displacement, SEEK_CUR);
+}
+
+
+bool FileReadStream::eof() const {
+	return atEnd_;
+}
+
+
+bool FileReadStream::ok() const {
+	return ! atEnd_ && std::ferror(file_) == 0;
+}
+
+
+} // ns fs
+} // ns stardazed
@@ -0,0 +1,23 @@
+// ------------------------------------------------------------------
+// io::headless_input - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "io/input.hpp"
+
+namespace stardazed {
+namespace io {
+
+
+Keyboard keyboard;
+
+
+// headless builds have no window to receive input events, the keyboard can
+// still be driven by calling keyDownEvent and keyUpEvent directly
+void update() {
+	keyboard.resetHalfTransitions();
+}
+
+
+} // ns io
+} // ns stardazed
@@ -0,0 +1,120 @@
+// ------------------------------------------------------------------
+// math::AVX2Lanes - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_MATH_AVX2LANES_H
+#define SD_MATH_AVX2LANES_H
+
+// Internal to the batch kernels in Stream.cpp and TransformKernels.cpp.
+// Loads and stores 8 interleaved Vec3s or Quats as one register per component.
+// The functions are compiled for AVX2 regardless of the build settings and
+// may only be called after cpu::features() reported AVX2 support.
+
+#include "system/Config.hpp"
+#include "math/Vector.hpp"
+#include "math/Quaternion.hpp"
+
+#if SD_ARCH_X86_64
+
+#include <immintrin.h>
+
+#define SD_TARGET_AVX2 __attribute__((target("avx2")))
+
+namespace stardazed {
+namespace math {
+namespace detail {
+
+
+struct Vec3x8 {
+	__m256 x, y, z;
+};
+
+struct Quatx8 {
+	__m256 x, y, z, w;
+};
+
+
+// Transposes the 4x4 blocks in the low and high 128-bit halves independently
+SD_TARGET_AVX2 inline void transpose4x2(__m256& a, __m256& b, __m256& c, __m256& d) {
+	__m256 t0 = _mm256_unpacklo_ps(a, b);
+	__m256 t1 = _mm256_unpackhi_ps(a, b);
+	__m256 t2 = _mm256_unpacklo_ps(c, d);
+	__m256 t3 = _mm256_unpackhi_ps(c, d);
+	a = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+	b = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+	c = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	d = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+
+SD_TARGET_AVX2 inline __m256 loadPair(const float* low, const float* high) {
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(low)), _mm_loadu_ps(high), 1);
+}
+
+
+SD_TARGET_AVX2 inline Vec3x8 loadVec3x8(const Vec3* v) {
+	const __m256i vec3Index = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+	auto base = &v->x;
+	return {
+		_mm256_i32gather_ps(base, vec3Index, 4),
+		_mm256_i32gather_ps(base + 1, vec3Index, 4),
+		_mm256_i32gather_ps(base + 2, vec3Index, 4)
+	};
+}
+
+
+// Each Vec3 is written with a 4-float store that spills into the x of the
+// next one, which is then overwritten by the next store. The last Vec3 is
+// written exactly so nothing past the end of the 8 is touched.
+SD_TARGET_AVX2 inline void storeVec3x8(Vec3* out, Vec3x8 v) {
+	__m256 a = v.x, b = v.y, c = v.z, d = _mm256_setzero_ps();
+	transpose4x2(a, b, c, d);
+
+	_mm_storeu_ps(out[0].data, _mm256_castps256_ps128(a));
+	_mm_storeu_ps(out[1].data, _mm256_castps256_ps128(b));
+	_mm_storeu_ps(out[2].data, _mm256_castps256_ps128(c));
+	_mm_storeu_ps(out[3].data, _mm256_castps256_ps128(d));
+	_mm_storeu_ps(out[4].data, _mm256_extractf128_ps(a, 1));
+	_mm_storeu_ps(out[5].data, _mm256_extractf128_ps(b, 1));
+	_mm_storeu_ps(out[6].data, _mm256_extractf128_ps(c, 1));
+
+	__m128 last = _mm256_extractf128_ps(d, 1);
+	_mm_storel_pi(reinterpret_cast<__m64*>(out[7].data), last);
+	_mm_store_ss(out[7].data + 2, _mm_movehl_ps(last, last));
+}
+
+
+SD_TARGET_AVX2 inline Quatx8 loadQuatx8(const Quat* q) {
+	// quaternion k and k + 4 share a register, the transpose then yields x0..x7 etc.
+	Quatx8 r {
+		loadPair(q[0].data, q[4].data),
+		loadPair(q[1].data, q[5].data),
+		loadPair(q[2].data, q[6].data),
+		loadPair(q[3].data, q[7].data)
+	};
+	transpose4x2(r.x, r.y, r.z, r.w);
+	return r;
+}
+
+
+SD_TARGET_AVX2 inline void storeQuatx8(Quat* out, Quatx8 q) {
+	transpose4x2(q.x, q.y, q.z, q.w);
+	_mm_storeu_ps(out[0].data, _mm256_castps256_ps128(q.x));
+	_mm_storeu_ps(out[1].data, _mm256_castps256_ps128(q.y));
+	_mm_storeu_ps(out[2].data, _mm256_castps256_ps128(q.z));
+	_mm_storeu_ps(out[3].data, _mm256_castps256_ps128(q.w));
+	_mm_storeu_ps(out[4].data, _mm256_extractf128_ps(q.x, 1));
+	_mm_storeu_ps(out[5].data, _mm256_extractf128_ps(q.y, 1));
+	_mm_storeu_ps(out[6].data, _mm256_extractf128_ps(q.z, 1));
+	_mm_storeu_ps(out[7].data, _mm256_extractf128_ps(q.w, 1));
+}
+
+
+} // ns detail
+} // ns math
+} // ns stardazed
+
+#endif // SD_ARCH_X86_64
+
+#endif
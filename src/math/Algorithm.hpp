@@ -111,7 +111,7 @@ constexpr uint32 alignUp(uint32 val, uint alignmentPow2) {
 
 
 constexpr uint64 alignUp(uint64 val, uint alignmentPow2) {
-	return (val + alignmentPow2 - 1) & (~(alignmentPow2 - 1));
+	return (val + alignmentPow2 - 1) & (~(uint64(alignmentPow2) - 1));
 }
 
 
@@ -124,7 +124,7 @@ constexpr uint32 alignDown(uint32 val, uint32 alignmentPow2) {
 
 
 constexpr uint64 alignDown(uint64 val, uint alignmentPow2) {
-	return val & (~(alignmentPow2 - 1));
+	return val & (~(uint64(alignmentPow2) - 1));
 }
 
 
@@ -19,9 +19,6 @@ namespace math {
 template <typename T>
 constexpr const T Epsilon = std::numeric_limits<T>::epsilon();
 
-template constexpr const float Epsilon<float>;
-template constexpr const double Epsilon<double>;
-
 
 // ---- Near-Equal Functions
 
@@ -682,6 +682,150 @@ void swap(Matrix<M, N, T>& a, Matrix<M, N, T>& b) {
 }
 
 
+#if SD_MATH_SIMD
+#pragma mark SIMD specializations for Mat4
+
+// Plain overloads for float Mat4 operations, these are preferred over the
+// templates above in overload resolution. They are not constexpr.
+namespace detail {
+	inline void loadColumns(const Mat4& m, simd::float4& c0, simd::float4& c1, simd::float4& c2, simd::float4& c3) {
+		c0 = simd::load(m.data);
+		c1 = simd::load(m.data + 4);
+		c2 = simd::load(m.data + 8);
+		c3 = simd::load(m.data + 12);
+	}
+
+	inline Mat4 fromColumns(simd::float4 c0, simd::float4 c1, simd::float4 c2, simd::float4 c3) {
+		Mat4 result;
+		simd::store(result.data, c0);
+		simd::store(result.data + 4, c1);
+		simd::store(result.data + 8, c2);
+		simd::store(result.data + 12, c3);
+		return result;
+	}
+
+	// a * b for 2x2 matrices stored as { m00, m01, m10, m11 }
+	inline simd::float4 mul2x2(simd::float4 a, simd::float4 b) {
+		return simd::add(
+			simd::mul(a, simd::swizzle<0, 3, 0, 3>(b)),
+			simd::mul(simd::swizzle<1, 0, 3, 2>(a), simd::swizzle<2, 1, 2, 1>(b))
+		);
+	}
+
+	// adjugate(a) * b
+	inline simd::float4 adjMul2x2(simd::float4 a, simd::float4 b) {
+		return simd::sub(
+			simd::mul(simd::swizzle<3, 3, 0, 0>(a), b),
+			simd::mul(simd::swizzle<1, 1, 2, 2>(a), simd::swizzle<2, 3, 0, 1>(b))
+		);
+	}
+
+	// a * adjugate(b)
+	inline simd::float4 mulAdj2x2(simd::float4 a, simd::float4 b) {
+		return simd::sub(
+			simd::mul(a, simd::swizzle<3, 0, 3, 0>(b)),
+			simd::mul(simd::swizzle<1, 0, 3, 2>(a), simd::swizzle<2, 1, 2, 1>(b))
+		);
+	}
+}
+
+
+// Each result column is a linear combination of a's columns, the sums are
+// formed in the same order as the scalar version.
+inline Mat4 operator *(const Mat4& a, const Mat4& b) {
+	simd::float4 a0, a1, a2, a3;
+	detail::loadColumns(a, a0, a1, a2, a3);
+
+	auto column = [=](const float* bc) {
+		auto bv = simd::load(bc);
+		auto r = simd::mul(a0, simd::splatLane<0>(bv));
+		r = simd::add(r, simd::mul(a1, simd::splatLane<1>(bv)));
+		r = simd::add(r, simd::mul(a2, simd::splatLane<2>(bv)));
+		return simd::add(r, simd::mul(a3, simd::splatLane<3>(bv)));
+	};
+
+	return detail::fromColumns(column(b.data), column(b.data + 4), column(b.data + 8), column(b.data + 12));
+}
+
+
+inline Vec4 operator *(const Mat4& mat, const Vec4& vec) {
+	simd::float4 t0, t1, t2, t3;
+	detail::loadColumns(mat, t0, t1, t2, t3);
+	simd::transpose(t0, t1, t2, t3);
+
+	auto v = detail::load(vec);
+	auto r = simd::mul(t0, simd::splatLane<0>(v));
+	r = simd::add(r, simd::mul(t1, simd::splatLane<1>(v)));
+	r = simd::add(r, simd::mul(t2, simd::splatLane<2>(v)));
+	return detail::toVec4(simd::add(r, simd::mul(t3, simd::splatLane<3>(v))));
+}
+
+
+inline Mat4 transpose(const Mat4& mat) {
+	simd::float4 c0, c1, c2, c3;
+	detail::loadColumns(mat, c0, c1, c2, c3);
+	simd::transpose(c0, c1, c2, c3);
+	return detail::fromColumns(c0, c1, c2, c3);
+}
+
+
+// Block-wise inverse using 2x2 sub-matrices and their adjugates. Written as
+// if the columns were rows, that is fine as inverse(transpose(M)) equals
+// transpose(inverse(M)). Like the scalar version it does not check for a
+// singular matrix.
+inline Mat4 inverse(const Mat4& mat) {
+	simd::float4 c0, c1, c2, c3;
+	detail::loadColumns(mat, c0, c1, c2, c3);
+
+	// M = | A B |
+	//     | C D |
+	auto A = simd::shuffle<0, 1, 0, 1>(c0, c1);
+	auto B = simd::shuffle<2, 3, 2, 3>(c0, c1);
+	auto C = simd::shuffle<0, 1, 0, 1>(c2, c3);
+	auto D = simd::shuffle<2, 3, 2, 3>(c2, c3);
+
+	// { |A|, |B|, |C|, |D| }
+	auto subDets = simd::sub(
+		simd::mul(simd::shuffle<0, 2, 0, 2>(c0, c2), simd::shuffle<1, 3, 1, 3>(c1, c3)),
+		simd::mul(simd::shuffle<1, 3, 1, 3>(c0, c2), simd::shuffle<0, 2, 0, 2>(c1, c3))
+	);
+	auto detA = simd::splatLane<0>(subDets);
+	auto detB = simd::splatLane<1>(subDets);
+	auto detC = simd::splatLane<2>(subDets);
+	auto detD = simd::splatLane<3>(subDets);
+
+	auto adjAB = detail::adjMul2x2(A, B);
+	auto adjDC = detail::adjMul2x2(D, C);
+
+	// adjugates of the blocks of the inverse, inverse(M) = 1/|M| * | X Y |
+	//                                                              | Z W |
+	auto adjX = simd::sub(simd::mul(detD, A), detail::mul2x2(B, adjDC));
+	auto adjY = simd::sub(simd::mul(detB, C), detail::mulAdj2x2(D, adjAB));
+	auto adjZ = simd::sub(simd::mul(detC, B), detail::mulAdj2x2(A, adjDC));
+	auto adjW = simd::sub(simd::mul(detA, D), detail::mul2x2(C, adjAB));
+
+	// |M| = |A||D| + |B||C| - trace(adj(A)B adj(D)C)
+	auto trace = simd::horizontalSum(simd::mul(adjAB, simd::swizzle<0, 2, 1, 3>(adjDC)));
+	auto det = simd::sub(simd::add(simd::mul(detA, detD), simd::mul(detB, detC)), trace);
+
+	// the sign flips of the adjugates are folded into the scale
+	auto scale = simd::div(simd::set(1, -1, -1, 1), det);
+	adjX = simd::mul(adjX, scale);
+	adjY = simd::mul(adjY, scale);
+	adjZ = simd::mul(adjZ, scale);
+	adjW = simd::mul(adjW, scale);
+
+	return detail::fromColumns(
+		simd::shuffle<3, 1, 3, 1>(adjX, adjY),
+		simd::shuffle<2, 0, 2, 0>(adjX, adjY),
+		simd::shuffle<3, 1, 3, 1>(adjZ, adjW),
+		simd::shuffle<2, 0, 2, 0>(adjZ, adjW)
+	);
+}
+
+#endif // SD_MATH_SIMD
+
+
 } // ns math
 } // ns stardazed
 
@@ -269,7 +269,7 @@ constexpr Quaternion<T> inverse(const Quaternion<T>& q) {
 
 
 template <typename T>
-constexpr Quaternion<T> dot(const Quaternion<T>& a, const Quaternion<T>& b) {
+constexpr T dot(const Quaternion<T>& a, const Quaternion<T>& b) {
 	return dot(a.xyzw, b.xyzw);
 }
 
@@ -302,6 +302,14 @@ constexpr Quaternion<T> slerp(const Quaternion<T>& q1, const Quaternion<T>& q2,
 }
 
 
+// normalized lerp along the shorter arc, close to slerp for small angles
+template <typename T>
+Quaternion<T> nlerp(const Quaternion<T>& q1, const Quaternion<T>& q2, float t) {
+	auto to = dot(q1, q2) < 0 ? -q2 : q2;
+	return normalize(q1 * (1.f - t) + to * t);
+}
+
+
 namespace detail {
 
 	template <typename T>
@@ -366,6 +374,58 @@ void swap(Quaternion<T>& a, Quaternion<T>& b) {
 }
 
 
+#if SD_MATH_SIMD
+#pragma mark SIMD specializations for Quat
+
+inline Quat operator *(const Quat& a, const Quat& b) {
+	auto av = simd::load(a.data);
+	auto bv = simd::load(b.data);
+
+	auto r = simd::mul(simd::splatLane<3>(av), bv);
+	r = simd::add(r, simd::mul(simd::mul(simd::splatLane<0>(av), simd::swizzle<3, 2, 1, 0>(bv)), simd::set(1, -1, 1, -1)));
+	r = simd::add(r, simd::mul(simd::mul(simd::splatLane<1>(av), simd::swizzle<2, 3, 0, 1>(bv)), simd::set(1, 1, -1, -1)));
+	r = simd::add(r, simd::mul(simd::mul(simd::splatLane<2>(av), simd::swizzle<1, 0, 3, 2>(bv)), simd::set(-1, 1, 1, -1)));
+
+	Quat result;
+	simd::store(result.data, r);
+	return result;
+}
+
+
+inline Quat& operator *=(Quat& a, const Quat& b) {
+	a = a * b;
+	return a;
+}
+
+
+// Each column is identity + (pa * qa + pb * qb) with lanes of q and 2q,
+// the sums come out the same as in the scalar version.
+template <>
+inline Mat4 Quat::toMatrix4() const {
+	auto q = simd::load(data);
+	auto q2 = simd::add(q, q);
+
+	auto column = [](simd::float4 unit, simd::float4 pa, simd::float4 qa, simd::float4 pb, simd::float4 qb) {
+		return simd::add(unit, simd::add(simd::mul(pa, qa), simd::mul(pb, qb)));
+	};
+
+	Mat4 result;
+	simd::store(result.data, column(simd::set(1, 0, 0, 0),
+		simd::mul(simd::swizzle<1, 0, 0, 3>(q), simd::set(-1, 1, 1, 0)), simd::swizzle<1, 1, 2, 3>(q2),
+		simd::mul(simd::swizzle<2, 3, 3, 3>(q), simd::set(-1, 1, -1, 0)), simd::swizzle<2, 2, 1, 3>(q2)));
+	simd::store(result.data + 4, column(simd::set(0, 1, 0, 0),
+		simd::mul(simd::swizzle<0, 0, 1, 3>(q), simd::set(1, -1, 1, 0)), simd::swizzle<1, 0, 2, 3>(q2),
+		simd::mul(simd::swizzle<3, 2, 3, 3>(q), simd::set(-1, -1, 1, 0)), simd::swizzle<2, 2, 0, 3>(q2)));
+	simd::store(result.data + 8, column(simd::set(0, 0, 1, 0),
+		simd::mul(simd::swizzle<0, 1, 0, 3>(q), simd::set(1, 1, -1, 0)), simd::swizzle<2, 2, 0, 3>(q2),
+		simd::mul(simd::swizzle<3, 3, 1, 3>(q), simd::set(1, -1, -1, 0)), simd::swizzle<1, 0, 1, 3>(q2)));
+	simd::store(result.data + 12, simd::set(0, 0, 0, 1));
+	return result;
+}
+
+#endif // SD_MATH_SIMD
+
+
 } // ns math
 } // ns stardazed
 
@@ -0,0 +1,126 @@
+// ------------------------------------------------------------------
+// math::SIMD - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_MATH_SIMD_H
+#define SD_MATH_SIMD_H
+
+#include "system/Config.hpp"
+
+// Thin 4 x float wrapper over SSE2 (always present on x86-64) and NEON
+// (always present on ARM64), used by the float specializations of the
+// Vec4, Mat4 and Quat operations. Define SD_MATH_SIMD to 0 to force the
+// scalar templates everywhere.
+//
+// The math types are not over-aligned: they are also stored in packed
+// vertex and instance buffers at arbitrary offsets, so all loads and
+// stores are unaligned. On current CPUs these cost the same as aligned
+// accesses when the data happens to be aligned.
+
+#ifndef SD_MATH_SIMD
+#	if SD_ARCH_X86_64 || SD_ARCH_ARM64
+#		define SD_MATH_SIMD 1
+#	else
+#		define SD_MATH_SIMD 0
+#	endif
+#endif
+
+#if SD_MATH_SIMD
+#	if SD_ARCH_X86_64
+#		include <xmmintrin.h>
+#	elif SD_ARCH_ARM64
+#		include <arm_neon.h>
+#	endif
+
+namespace stardazed {
+namespace math {
+namespace simd {
+
+
+#if SD_ARCH_X86_64
+
+using float4 = __m128;
+
+inline float4 load(const float* p) { return _mm_loadu_ps(p); }
+inline void store(float* p, float4 v) { _mm_storeu_ps(p, v); }
+inline float4 splat(float f) { return _mm_set1_ps(f); }
+inline float4 set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+
+inline float4 add(float4 a, float4 b) { return _mm_add_ps(a, b); }
+inline float4 sub(float4 a, float4 b) { return _mm_sub_ps(a, b); }
+inline float4 mul(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+inline float4 div(float4 a, float4 b) { return _mm_div_ps(a, b); }
+
+inline float first(float4 v) { return _mm_cvtss_f32(v); }
+
+// result is { a[I0], a[I1], b[I2], b[I3] }
+template <int I0, int I1, int I2, int I3>
+inline float4 shuffle(float4 a, float4 b) {
+	return _mm_shuffle_ps(a, b, _MM_SHUFFLE(I3, I2, I1, I0));
+}
+
+#elif SD_ARCH_ARM64
+
+using float4 = float32x4_t;
+
+inline float4 load(const float* p) { return vld1q_f32(p); }
+inline void store(float* p, float4 v) { vst1q_f32(p, v); }
+inline float4 splat(float f) { return vdupq_n_f32(f); }
+inline float4 set(float x, float y, float z, float w) { return float4{ x, y, z, w }; }
+
+inline float4 add(float4 a, float4 b) { return vaddq_f32(a, b); }
+inline float4 sub(float4 a, float4 b) { return vsubq_f32(a, b); }
+inline float4 mul(float4 a, float4 b) { return vmulq_f32(a, b); }
+inline float4 div(float4 a, float4 b) { return vdivq_f32(a, b); }
+
+inline float first(float4 v) { return vgetq_lane_f32(v, 0); }
+
+// result is { a[I0], a[I1], b[I2], b[I3] }, the compiler picks the permute instructions
+template <int I0, int I1, int I2, int I3>
+inline float4 shuffle(float4 a, float4 b) {
+	return float4{ a[I0], a[I1], b[I2], b[I3] };
+}
+
+#endif
+
+
+// -- shared helpers
+
+template <int I0, int I1, int I2, int I3>
+inline float4 swizzle(float4 v) {
+	return shuffle<I0, I1, I2, I3>(v, v);
+}
+
+template <int I>
+inline float4 splatLane(float4 v) {
+	return shuffle<I, I, I, I>(v, v);
+}
+
+// sum of all lanes in every lane
+inline float4 horizontalSum(float4 v) {
+	auto pairs = add(v, swizzle<1, 0, 3, 2>(v));
+	return add(pairs, swizzle<2, 3, 0, 1>(pairs));
+}
+
+// transposes a 4x4 block held in 4 registers
+inline void transpose(float4& a, float4& b, float4& c, float4& d) {
+	auto ab01 = shuffle<0, 1, 0, 1>(a, b);
+	auto ab23 = shuffle<2, 3, 2, 3>(a, b);
+	auto cd01 = shuffle<0, 1, 0, 1>(c, d);
+	auto cd23 = shuffle<2, 3, 2, 3>(c, d);
+
+	a = shuffle<0, 2, 0, 2>(ab01, cd01);
+	b = shuffle<1, 3, 1, 3>(ab01, cd01);
+	c = shuffle<0, 2, 0, 2>(ab23, cd23);
+	d = shuffle<1, 3, 1, 3>(ab23, cd23);
+}
+
+
+} // ns simd
+} // ns math
+} // ns stardazed
+
+#endif // SD_MATH_SIMD
+
+#endif
@@ -0,0 +1,436 @@
+// ------------------------------------------------------------------
+// math::Stream.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "math/Stream.hpp"
+#include "math/AVX2Lanes.hpp"
+#include "system/CPU.hpp"
+
+#include <cmath>
+
+namespace stardazed {
+namespace math {
+namespace detail {
+
+
+// Interpolation weights of from and to for slerp, cosAngle must be >= 0
+static inline void slerpWeights(float cosAngle, float t, float& outFromWeight, float& outToWeight) {
+	if (cosAngle > 0.9995f) {
+		outFromWeight = 1.f - t;
+		outToWeight = t;
+		return;
+	}
+
+	auto angle = std::acos(cosAngle);
+	auto oneOverSin = 1.f / std::sin(angle);
+	outFromWeight = std::sin(angle * (1.f - t)) * oneOverSin;
+	outToWeight = std::sin(angle * t) * oneOverSin;
+}
+
+
+void addScalar(const Vec3* a, const Vec3* b, Vec3* out, uint32 count) {
+	for (uint32 i = 0; i < count; ++i) {
+		out[i] = a[i] + b[i];
+	}
+}
+
+
+void mulScalar(const Vec3* a, const Vec3* b, Vec3* out, uint32 count) {
+	for (uint32 i = 0; i < count; ++i) {
+		out[i] = a[i] * b[i];
+	}
+}
+
+
+void addScaledScalar(const Vec3* a, const Vec3* b, float s, Vec3* out, uint32 count) {
+	for (uint32 i = 0; i < count; ++i) {
+		out[i] = a[i] + (b[i] * s);
+	}
+}
+
+
+void scaleScalar(const Vec3* in, const float* factors, Vec3* out, uint32 count) {
+	for (uint32 i = 0; i < count; ++i) {
+		out[i] = in[i] * factors[i];
+	}
+}
+
+
+void dotScalar(const Vec3* a, const Vec3* b, float* out, uint32 count) {
+	for (uint32 i = 0; i < count; ++i) {
+		out[i] = dot(a[i], b[i]);
+	}
+}
+
+
+void crossScalar(const Vec3* a, const Vec3* b, Vec3* out, uint32 count) {
+	for (uint32 i = 0; i < count; ++i) {
+		out[i] = cross(a[i], b[i]);
+	}
+}
+
+
+void normalizeScalar(const Vec3* in, Vec3* out, uint32 count) {
+	for (uint32 i = 0; i < count; ++i) {
+		out[i] = normalize(in[i]);
+	}
+}
+
+
+void lerpScalar(const Vec3* from, const Vec3* to, float t, Vec3* out, uint32 count) {
+	for (uint32 i = 0; i < count; ++i) {
+		out[i] = lerp(from[i], to[i], t);
+	}
+}
+
+
+void slerpScalar(const Quat* from, const Quat* to, float t, Quat* out, uint32 count) {
+	for (uint32 i = 0; i < count; ++i) {
+		auto a = from[i];
+		auto b = to[i];
+
+		auto cosAngle = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+		if (cosAngle < 0) {
+			b = -b;
+			cosAngle = -cosAngle;
+		}
+
+		float wa, wb;
+		slerpWeights(cosAngle, t, wa, wb);
+
+		Quat r { a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb };
+		auto len = std::sqrt(r.x * r.x + r.y * r.y + r.z * r.z + r.w * r.w);
+		out[i] = { r.x / len, r.y / len, r.z / len, r.w / len };
+	}
+}
+
+
+void transformPointsScalar(const Mat4& mat, const Vec3* in, Vec3* out, uint32 count) {
+	const auto m = mat.data;
+
+	for (uint32 i = 0; i < count; ++i) {
+		auto p = in[i];
+		out[i] = {
+			m[0] * p.x + m[4] * p.y + m[8]  * p.z + m[12],
+			m[1] * p.x + m[5] * p.y + m[9]  * p.z + m[13],
+			m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14]
+		};
+	}
+}
+
+
+#if SD_ARCH_X86_64
+
+//    ___   ____  __ ___
+//   /_\ \ / /\ \/ /|_  )
+//  / _ \ V /  >  <  / /
+// /_/ \_\_/  /_/\_\/___|
+//
+// Compiled for AVX2 regardless of the build settings, only called
+// after cpu::features() reported AVX2 support. The lane loads and
+// stores are shared with TransformKernels.cpp in AVX2Lanes.hpp.
+// The arithmetic is done in the same order as in the scalar kernels,
+// so both produce the same results.
+
+namespace {
+
+	SD_TARGET_AVX2 inline __m256 dot3(const Vec3x8& a, const Vec3x8& b) {
+		__m256 r = _mm256_mul_ps(a.x, b.x);
+		r = _mm256_add_ps(r, _mm256_mul_ps(a.y, b.y));
+		return _mm256_add_ps(r, _mm256_mul_ps(a.z, b.z));
+	}
+
+
+	SD_TARGET_AVX2 inline __m256 affineRow(const Vec3x8& p, __m256 mx, __m256 my, __m256 mz, __m256 mt) {
+		__m256 r = _mm256_mul_ps(mx, p.x);
+		r = _mm256_add_ps(r, _mm256_mul_ps(my, p.y));
+		r = _mm256_add_ps(r, _mm256_mul_ps(mz, p.z));
+		return _mm256_add_ps(r, mt);
+	}
+
+} // anonymous namespace
+
+
+SD_TARGET_AVX2 void addAVX2(const Vec3* a, const Vec3* b, Vec3* out, uint32 count) {
+	uint32 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		auto va = loadVec3x8(a + i);
+		auto vb = loadVec3x8(b + i);
+		storeVec3x8(out + i, { _mm256_add_ps(va.x, vb.x), _mm256_add_ps(va.y, vb.y), _mm256_add_ps(va.z, vb.z) });
+	}
+	addScalar(a + i, b + i, out + i, count - i);
+}
+
+
+SD_TARGET_AVX2 void mulAVX2(const Vec3* a, const Vec3* b, Vec3* out, uint32 count) {
+	uint32 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		auto va = loadVec3x8(a + i);
+		auto vb = loadVec3x8(b + i);
+		storeVec3x8(out + i, { _mm256_mul_ps(va.x, vb.x), _mm256_mul_ps(va.y, vb.y), _mm256_mul_ps(va.z, vb.z) });
+	}
+	mulScalar(a + i, b + i, out + i, count - i);
+}
+
+
+SD_TARGET_AVX2 void addScaledAVX2(const Vec3* a, const Vec3* b, float s, Vec3* out, uint32 count) {
+	const __m256 vs = _mm256_set1_ps(s);
+	uint32 i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		auto va = loadVec3x8(a + i);
+		auto vb = loadVec3x8(b + i);
+		storeVec3x8(out + i, {
+			_mm256_add_ps(va.x, _mm256_mul_ps(vb.x, vs)),
+			_mm256_add_ps(va.y, _mm256_mul_ps(vb.y, vs)),
+			_mm256_add_ps(va.z, _mm256_mul_ps(vb.z, vs))
+		});
+	}
+	addScaledScalar(a + i, b + i, s, out + i, count - i);
+}
+
+
+SD_TARGET_AVX2 void scaleAVX2(const Vec3* in, const float* factors, Vec3* out, uint32 count) {
+	uint32 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		auto v = loadVec3x8(in + i);
+		__m256 f = _mm256_loadu_ps(factors + i);
+		storeVec3x8(out + i, { _mm256_mul_ps(v.x, f), _mm256_mul_ps(v.y, f), _mm256_mul_ps(v.z, f) });
+	}
+	scaleScalar(in + i, factors + i, out + i, count - i);
+}
+
+
+SD_TARGET_AVX2 void dotAVX2(const Vec3* a, const Vec3* b, float* out, uint32 count) {
+	uint32 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(out + i, dot3(loadVec3x8(a + i), loadVec3x8(b + i)));
+	}
+	dotScalar(a + i, b + i, out + i, count - i);
+}
+
+
+SD_TARGET_AVX2 void crossAVX2(const Vec3* a, const Vec3* b, Vec3* out, uint32 count) {
+	uint32 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		auto va = loadVec3x8(a + i);
+		auto vb = loadVec3x8(b + i);
+		storeVec3x8(out + i, {
+			_mm256_sub_ps(_mm256_mul_ps(va.y, vb.z), _mm256_mul_ps(va.z, vb.y)),
+			_mm256_sub_ps(_mm256_mul_ps(va.z, vb.x), _mm256_mul_ps(va.x, vb.z)),
+			_mm256_sub_ps(_mm256_mul_ps(va.x, vb.y), _mm256_mul_ps(va.y, vb.x))
+		});
+	}
+	crossScalar(a + i, b + i, out + i, count - i);
+}
+
+
+SD_TARGET_AVX2 void normalizeAVX2(const Vec3* in, Vec3* out, uint32 count) {
+	uint32 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		auto v = loadVec3x8(in + i);
+		auto len = _mm256_sqrt_ps(dot3(v, v));
+		storeVec3x8(out + i, { _mm256_div_ps(v.x, len), _mm256_div_ps(v.y, len), _mm256_div_ps(v.z, len) });
+	}
+	normalizeScalar(in + i, out + i, count - i);
+}
+
+
+SD_TARGET_AVX2 void lerpAVX2(const Vec3* from, const Vec3* to, float t, Vec3* out, uint32 count) {
+	const __m256 vt = _mm256_set1_ps(t);
+	uint32 i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		auto a = loadVec3x8(from + i);
+		auto b = loadVec3x8(to + i);
+		storeVec3x8(out + i, {
+			_mm256_add_ps(a.x, _mm256_mul_ps(_mm256_sub_ps(b.x, a.x), vt)),
+			_mm256_add_ps(a.y, _mm256_mul_ps(_mm256_sub_ps(b.y, a.y), vt)),
+			_mm256_add_ps(a.z, _mm256_mul_ps(_mm256_sub_ps(b.z, a.z), vt))
+		});
+	}
+	lerpScalar(from + i, to + i, t, out + i, count - i);
+}
+
+
+SD_TARGET_AVX2 void slerpAVX2(const Quat* from, const Quat* to, float t, Quat* out, uint32 count) {
+	const __m256 signBit = _mm256_set1_ps(-0.f);
+	uint32 i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		auto a = loadQuatx8(from + i);
+		auto b = loadQuatx8(to + i);
+
+		__m256 cosAngle = _mm256_mul_ps(a.x, b.x);
+		cosAngle = _mm256_add_ps(cosAngle, _mm256_mul_ps(a.y, b.y));
+		cosAngle = _mm256_add_ps(cosAngle, _mm256_mul_ps(a.z, b.z));
+		cosAngle = _mm256_add_ps(cosAngle, _mm256_mul_ps(a.w, b.w));
+
+		// take the shortest path: negate b where the cosine is negative
+		__m256 flip = _mm256_and_ps(cosAngle, signBit);
+		b.x = _mm256_xor_ps(b.x, flip);
+		b.y = _mm256_xor_ps(b.y, flip);
+		b.z = _mm256_xor_ps(b.z, flip);
+		b.w = _mm256_xor_ps(b.w, flip);
+		cosAngle = _mm256_xor_ps(cosAngle, flip);
+
+		alignas(32) float cosAngles[8], weightsA[8], weightsB[8];
+		_mm256_store_ps(cosAngles, cosAngle);
+		for (uint32 k = 0; k < 8; ++k) {
+			slerpWeights(cosAngles[k], t, weightsA[k], weightsB[k]);
+		}
+		__m256 wa = _mm256_load_ps(weightsA);
+		__m256 wb = _mm256_load_ps(weightsB);
+
+		Quatx8 r {
+			_mm256_add_ps(_mm256_mul_ps(a.x, wa), _mm256_mul_ps(b.x, wb)),
+			_mm256_add_ps(_mm256_mul_ps(a.y, wa), _mm256_mul_ps(b.y, wb)),
+			_mm256_add_ps(_mm256_mul_ps(a.z, wa), _mm256_mul_ps(b.z, wb)),
+			_mm256_add_ps(_mm256_mul_ps(a.w, wa), _mm256_mul_ps(b.w, wb))
+		};
+
+		__m256 lenSq = _mm256_mul_ps(r.x, r.x);
+		lenSq = _mm256_add_ps(lenSq, _mm256_mul_ps(r.y, r.y));
+		lenSq = _mm256_add_ps(lenSq, _mm256_mul_ps(r.z, r.z));
+		lenSq = _mm256_add_ps(lenSq, _mm256_mul_ps(r.w, r.w));
+		__m256 len = _mm256_sqrt_ps(lenSq);
+
+		storeQuatx8(out + i, {
+			_mm256_div_ps(r.x, len), _mm256_div_ps(r.y, len), _mm256_div_ps(r.z, len), _mm256_div_ps(r.w, len)
+		});
+	}
+	slerpScalar(from + i, to + i, t, out + i, count - i);
+}
+
+
+SD_TARGET_AVX2 void transformPointsAVX2(const Mat4& mat, const Vec3* in, Vec3* out, uint32 count) {
+	const auto m = mat.data;
+	const __m256 m0 = _mm256_set1_ps(m[0]), m4 = _mm256_set1_ps(m[4]), m8  = _mm256_set1_ps(m[8]),  m12 = _mm256_set1_ps(m[12]);
+	const __m256 m1 = _mm256_set1_ps(m[1]), m5 = _mm256_set1_ps(m[5]), m9  = _mm256_set1_ps(m[9]),  m13 = _mm256_set1_ps(m[13]);
+	const __m256 m2 = _mm256_set1_ps(m[2]), m6 = _mm256_set1_ps(m[6]), m10 = _mm256_set1_ps(m[10]), m14 = _mm256_set1_ps(m[14]);
+	uint32 i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		auto p = loadVec3x8(in + i);
+
+		storeVec3x8(out + i, {
+			affineRow(p, m0, m4, m8, m12),
+			affineRow(p, m1, m5, m9, m13),
+			affineRow(p, m2, m6, m10, m14)
+		});
+	}
+	transformPointsScalar(mat, in + i, out + i, count - i);
+}
+
+#endif // SD_ARCH_X86_64
+
+} // ns detail
+
+
+// -- kernel selection, done once
+
+namespace {
+
+	struct StreamKernels {
+		void (*add)(const Vec3*, const Vec3*, Vec3*, uint32);
+		void (*mul)(const Vec3*, const Vec3*, Vec3*, uint32);
+		void (*addScaled)(const Vec3*, const Vec3*, float, Vec3*, uint32);
+		void (*scale)(const Vec3*, const float*, Vec3*, uint32);
+		void (*dot)(const Vec3*, const Vec3*, float*, uint32);
+		void (*cross)(const Vec3*, const Vec3*, Vec3*, uint32);
+		void (*normalize)(const Vec3*, Vec3*, uint32);
+		void (*lerp)(const Vec3*, const Vec3*, float, Vec3*, uint32);
+		void (*slerp)(const Quat*, const Quat*, float, Quat*, uint32);
+		void (*transformPoints)(const Mat4&, const Vec3*, Vec3*, uint32);
+	};
+
+
+	StreamKernels selectKernels() {
+#if SD_ARCH_X86_64
+		if (cpu::features().avx2) {
+			return {
+				detail::addAVX2, detail::mulAVX2, detail::addScaledAVX2, detail::scaleAVX2,
+				detail::dotAVX2, detail::crossAVX2, detail::normalizeAVX2,
+				detail::lerpAVX2, detail::slerpAVX2, detail::transformPointsAVX2
+			};
+		}
+#endif
+		return {
+			detail::addScalar, detail::mulScalar, detail::addScaledScalar, detail::scaleScalar,
+			detail::dotScalar, detail::crossScalar, detail::normalizeScalar,
+			detail::lerpScalar, detail::slerpScalar, detail::transformPointsScalar
+		};
+	}
+
+
+	const StreamKernels& kernels() {
+		static const StreamKernels kernels = selectKernels();
+		return kernels;
+	}
+
+} // anonymous namespace
+
+
+void add(ConstVec3Stream a, ConstVec3Stream b, Vec3Stream out) {
+	assert(a.count() == b.count() && a.count() == out.count());
+	kernels().add(a.data(), b.data(), out.data(), out.count());
+}
+
+
+void mul(ConstVec3Stream a, ConstVec3Stream b, Vec3Stream out) {
+	assert(a.count() == b.count() && a.count() == out.count());
+	kernels().mul(a.data(), b.data(), out.data(), out.count());
+}
+
+
+void addScaled(ConstVec3Stream a, ConstVec3Stream b, float s, Vec3Stream out) {
+	assert(a.count() == b.count() && a.count() == out.count());
+	kernels().addScaled(a.data(), b.data(), s, out.data(), out.count());
+}
+
+
+void scale(ConstVec3Stream in, ConstFloatStream factors, Vec3Stream out) {
+	assert(in.count() == factors.count() && in.count() == out.count());
+	kernels().scale(in.data(), factors.data(), out.data(), out.count());
+}
+
+
+void dot(ConstVec3Stream a, ConstVec3Stream b, FloatStream out) {
+	assert(a.count() == b.count() && a.count() == out.count());
+	kernels().dot(a.data(), b.data(), out.data(), out.count());
+}
+
+
+void cross(ConstVec3Stream a, ConstVec3Stream b, Vec3Stream out) {
+	assert(a.count() == b.count() && a.count() == out.count());
+	kernels().cross(a.data(), b.data(), out.data(), out.count());
+}
+
+
+void normalize(ConstVec3Stream in, Vec3Stream out) {
+	assert(in.count() == out.count());
+	kernels().normalize(in.data(), out.data(), out.count());
+}
+
+
+void lerp(ConstVec3Stream from, ConstVec3Stream to, float t, Vec3Stream out) {
+	assert(from.count() == to.count() && from.count() == out.count());
+	kernels().lerp(from.data(), to.data(), t, out.data(), out.count());
+}
+
+
+void slerp(ConstQuatStream from, ConstQuatStream to, float t, QuatStream out) {
+	assert(from.count() == to.count() && from.count() == out.count());
+	kernels().slerp(from.data(), to.data(), t, out.data(), out.count());
+}
+
+
+void transformPoints(const Mat4& mat, ConstVec3Stream in, Vec3Stream out) {
+	assert(in.count() == out.count());
+	kernels().transformPoints(mat, in.data(), out.data(), out.count());
+}
+
+
+} // ns math
+} // ns stardazed
@@ -0,0 +1,145 @@
+// ------------------------------------------------------------------
+// math::Stream - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_MATH_STREAM_H
+#define SD_MATH_STREAM_H
+
+#include "system/Config.hpp"
+#include "math/Vector.hpp"
+#include "math/Matrix.hpp"
+#include "math/Quaternion.hpp"
+
+#include <type_traits>
+
+namespace stardazed {
+namespace math {
+
+
+// Non-owning view of count consecutive values, usually a column of a
+// MultiArrayBuffer or ComponentStore. Streams of T convert to streams
+// of const T for the input arguments of the batch functions below.
+
+template <typename T>
+class Stream {
+	T* base_;
+	uint32 count_;
+
+public:
+	constexpr Stream(T* base, uint32 count)
+	: base_(base)
+	, count_(count)
+	{}
+
+	template <typename U, typename = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+	constexpr Stream(const Stream<U>& other)
+	: base_(other.data())
+	, count_(other.count())
+	{}
+
+	constexpr T* data() const { return base_; }
+	constexpr uint32 count() const { return count_; }
+
+	T& operator[](uint32 index) const {
+		assert(index < count_);
+		return base_[index];
+	}
+
+	Stream subStream(uint32 first, uint32 count) const {
+		assert(first + count <= count_);
+		return { base_ + first, count };
+	}
+};
+
+
+using FloatStream = Stream<float>;
+using Vec3Stream = Stream<Vec3>;
+using QuatStream = Stream<Quat>;
+
+using ConstFloatStream = Stream<const float>;
+using ConstVec3Stream = Stream<const Vec3>;
+using ConstQuatStream = Stream<const Quat>;
+
+
+// Stream over all elements of column Index of a MultiArrayBuffer or ComponentStore,
+// valid until the buffer is resized. Note that component stores keep a
+// null-instance at index 0, use subStream(1, count - 1) to skip it.
+template <uint32 Index, typename Buffer>
+auto columnStream(const Buffer& buffer) {
+	auto base = buffer.template elementsBasePtr<Index>();
+	return Stream<std::remove_pointer_t<decltype(base)>>{ base, buffer.count() };
+}
+
+
+// Batch operations over streams of equal length. The output stream may be
+// the same as an input stream. Elements are processed 8 at a time using
+// AVX2 when the CPU supports it, the remainder is handled one at a time.
+// Results are the same as the scalar functions in Vector.hpp, except where noted.
+
+// out[i] = a[i] + b[i]
+void add(ConstVec3Stream a, ConstVec3Stream b, Vec3Stream out);
+
+// out[i] = a[i] * b[i], component-wise
+void mul(ConstVec3Stream a, ConstVec3Stream b, Vec3Stream out);
+
+// out[i] = a[i] + (b[i] * s), e.g. an Euler step of positions by velocities
+void addScaled(ConstVec3Stream a, ConstVec3Stream b, float s, Vec3Stream out);
+
+// out[i] = in[i] * factors[i]
+void scale(ConstVec3Stream in, ConstFloatStream factors, Vec3Stream out);
+
+// out[i] = dot(a[i], b[i])
+void dot(ConstVec3Stream a, ConstVec3Stream b, FloatStream out);
+
+// out[i] = cross(a[i], b[i])
+void cross(ConstVec3Stream a, ConstVec3Stream b, Vec3Stream out);
+
+// out[i] = normalize(in[i])
+void normalize(ConstVec3Stream in, Vec3Stream out);
+
+// out[i] = lerp(from[i], to[i], t)
+void lerp(ConstVec3Stream from, ConstVec3Stream to, float t, Vec3Stream out);
+
+// Shortest-path spherical interpolation of unit quaternions, falls back to a
+// normalized lerp for nearly identical rotations. The sines and arc cosine
+// are evaluated per element with the standard library.
+void slerp(ConstQuatStream from, ConstQuatStream to, float t, QuatStream out);
+
+// out[i] = (mat * Vec4{ in[i], 1 }).xyz, the matrix is treated as an
+// affine transform (column-major, translation in column 3).
+void transformPoints(const Mat4& mat, ConstVec3Stream in, Vec3Stream out);
+
+
+// -- the individual kernels, for testing and benchmarks only
+namespace detail {
+	void addScalar(const Vec3* a, const Vec3* b, Vec3* out, uint32 count);
+	void mulScalar(const Vec3* a, const Vec3* b, Vec3* out, uint32 count);
+	void addScaledScalar(const Vec3* a, const Vec3* b, float s, Vec3* out, uint32 count);
+	void scaleScalar(const Vec3* in, const float* factors, Vec3* out, uint32 count);
+	void dotScalar(const Vec3* a, const Vec3* b, float* out, uint32 count);
+	void crossScalar(const Vec3* a, const Vec3* b, Vec3* out, uint32 count);
+	void normalizeScalar(const Vec3* in, Vec3* out, uint32 count);
+	void lerpScalar(const Vec3* from, const Vec3* to, float t, Vec3* out, uint32 count);
+	void slerpScalar(const Quat* from, const Quat* to, float t, Quat* out, uint32 count);
+	void transformPointsScalar(const Mat4& mat, const Vec3* in, Vec3* out, uint32 count);
+
+#if SD_ARCH_X86_64
+	void addAVX2(const Vec3* a, const Vec3* b, Vec3* out, uint32 count);
+	void mulAVX2(const Vec3* a, const Vec3* b, Vec3* out, uint32 count);
+	void addScaledAVX2(const Vec3* a, const Vec3* b, float s, Vec3* out, uint32 count);
+	void scaleAVX2(const Vec3* in, const float* factors, Vec3* out, uint32 count);
+	void dotAVX2(const Vec3* a, const Vec3* b, float* out, uint32 count);
+	void crossAVX2(const Vec3* a, const Vec3* b, Vec3* out, uint32 count);
+	void normalizeAVX2(const Vec3* in, Vec3* out, uint32 count);
+	void lerpAVX2(const Vec3* from, const Vec3* to, float t, Vec3* out, uint32 count);
+	void slerpAVX2(const Quat* from, const Quat* to, float t, Quat* out, uint32 count);
+	void transformPointsAVX2(const Mat4& mat, const Vec3* in, Vec3* out, uint32 count);
+#endif
+} // ns detail
+
+
+} // ns math
+} // ns stardazed
+
+#endif
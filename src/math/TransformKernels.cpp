@@ -0,0 +1,180 @@
+// ------------------------------------------------------------------
+// math::TransformKernels.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "math/TransformKernels.hpp"
+#include "math/AVX2Lanes.hpp"
+#include "system/CPU.hpp"
+
+#if SD_ARCH_X86_64
+#	include <immintrin.h>
+#endif
+
+namespace stardazed {
+namespace math {
+namespace detail {
+
+
+void composeTRSScalar(const Vec3* positions, const Quat* rotations, const Vec3* scales, Mat4* outMatrices, uint32 count) {
+	for (uint32 i = 0; i < count; ++i) {
+		composeTRS(positions[i], rotations[i], scales[i], outMatrices[i]);
+	}
+}
+
+
+#if SD_ARCH_X86_64
+
+//  ___ ___ ___
+// / __/ __| __|
+// \__ \__ \ _|
+// |___/___/___|
+//
+// SSE2 is part of x86-64, so this kernel needs no runtime check.
+
+static inline void storeColumn4(__m128 a, __m128 b, __m128 c, __m128 d, Mat4* out, uint32 column) {
+	_MM_TRANSPOSE4_PS(a, b, c, d);
+	_mm_storeu_ps(out[0].data + (column * 4), a);
+	_mm_storeu_ps(out[1].data + (column * 4), b);
+	_mm_storeu_ps(out[2].data + (column * 4), c);
+	_mm_storeu_ps(out[3].data + (column * 4), d);
+}
+
+
+void composeTRSSSE(const Vec3* positions, const Quat* rotations, const Vec3* scales, Mat4* outMatrices, uint32 count) {
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1), two = _mm_set1_ps(2);
+	uint32 i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		auto p = positions + i;
+		auto s = scales + i;
+
+		__m128 qx = _mm_loadu_ps(rotations[i].data);
+		__m128 qy = _mm_loadu_ps(rotations[i + 1].data);
+		__m128 qz = _mm_loadu_ps(rotations[i + 2].data);
+		__m128 qw = _mm_loadu_ps(rotations[i + 3].data);
+		_MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+		// Vec3s are not 16-byte sized, gather the components
+		__m128 sx = _mm_setr_ps(s[0].x, s[1].x, s[2].x, s[3].x);
+		__m128 sy = _mm_setr_ps(s[0].y, s[1].y, s[2].y, s[3].y);
+		__m128 sz = _mm_setr_ps(s[0].z, s[1].z, s[2].z, s[3].z);
+
+		__m128 x2 = _mm_mul_ps(qx, qx), y2 = _mm_mul_ps(qy, qy), z2 = _mm_mul_ps(qz, qz);
+		__m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+		__m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+		__m128 m0  = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(y2, z2))), sx);
+		__m128 m1  = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+		__m128 m2  = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+
+		__m128 m4  = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+		__m128 m5  = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(x2, z2))), sy);
+		__m128 m6  = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+
+		__m128 m8  = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+		__m128 m9  = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+		__m128 m10 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(x2, y2))), sz);
+
+		__m128 px = _mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x);
+		__m128 py = _mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y);
+		__m128 pz = _mm_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z);
+
+		auto out = outMatrices + i;
+		storeColumn4(m0, m1, m2, zero, out, 0);
+		storeColumn4(m4, m5, m6, zero, out, 1);
+		storeColumn4(m8, m9, m10, zero, out, 2);
+		storeColumn4(px, py, pz, one, out, 3);
+	}
+
+	composeTRSScalar(positions + i, rotations + i, scales + i, outMatrices + i, count - i);
+}
+
+
+//    ___   ____  __ ___
+//   /_\ \ / /\ \/ /|_  )
+//  / _ \ V /  >  <  / /
+// /_/ \_\_/  /_/\_\/___|
+//
+// Compiled for AVX2 regardless of the build settings, only called
+// after cpu::features() reported AVX2 support. The lane loads are
+// shared with Stream.cpp in AVX2Lanes.hpp.
+
+SD_TARGET_AVX2 static inline void storeColumn8(__m256 a, __m256 b, __m256 c, __m256 d, Mat4* out, uint32 column) {
+	transpose4x2(a, b, c, d);
+	auto offset = column * 4;
+	_mm_storeu_ps(out[0].data + offset, _mm256_castps256_ps128(a));
+	_mm_storeu_ps(out[1].data + offset, _mm256_castps256_ps128(b));
+	_mm_storeu_ps(out[2].data + offset, _mm256_castps256_ps128(c));
+	_mm_storeu_ps(out[3].data + offset, _mm256_castps256_ps128(d));
+	_mm_storeu_ps(out[4].data + offset, _mm256_extractf128_ps(a, 1));
+	_mm_storeu_ps(out[5].data + offset, _mm256_extractf128_ps(b, 1));
+	_mm_storeu_ps(out[6].data + offset, _mm256_extractf128_ps(c, 1));
+	_mm_storeu_ps(out[7].data + offset, _mm256_extractf128_ps(d, 1));
+}
+
+
+SD_TARGET_AVX2 void composeTRSAVX2(const Vec3* positions, const Quat* rotations, const Vec3* scales, Mat4* outMatrices, uint32 count) {
+	const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1), two = _mm256_set1_ps(2);
+	uint32 i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		auto q = loadQuatx8(rotations + i);
+		auto s = loadVec3x8(scales + i);
+		__m256 qx = q.x, qy = q.y, qz = q.z, qw = q.w;
+		__m256 sx = s.x, sy = s.y, sz = s.z;
+
+		__m256 x2 = _mm256_mul_ps(qx, qx), y2 = _mm256_mul_ps(qy, qy), z2 = _mm256_mul_ps(qz, qz);
+		__m256 xy = _mm256_mul_ps(qx, qy), xz = _mm256_mul_ps(qx, qz), yz = _mm256_mul_ps(qy, qz);
+		__m256 wx = _mm256_mul_ps(qw, qx), wy = _mm256_mul_ps(qw, qy), wz = _mm256_mul_ps(qw, qz);
+
+		__m256 m0  = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(y2, z2))), sx);
+		__m256 m1  = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+		__m256 m2  = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+
+		__m256 m4  = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+		__m256 m5  = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(x2, z2))), sy);
+		__m256 m6  = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+
+		__m256 m8  = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+		__m256 m9  = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+		__m256 m10 = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(x2, y2))), sz);
+
+		auto p = loadVec3x8(positions + i);
+
+		auto out = outMatrices + i;
+		storeColumn8(m0, m1, m2, zero, out, 0);
+		storeColumn8(m4, m5, m6, zero, out, 1);
+		storeColumn8(m8, m9, m10, zero, out, 2);
+		storeColumn8(p.x, p.y, p.z, one, out, 3);
+	}
+
+	composeTRSSSE(positions + i, rotations + i, scales + i, outMatrices + i, count - i);
+}
+
+#endif // SD_ARCH_X86_64
+
+} // ns detail
+
+
+using ComposeTRSFn = void (*)(const Vec3*, const Quat*, const Vec3*, Mat4*, uint32);
+
+static ComposeTRSFn selectComposeTRS() {
+#if SD_ARCH_X86_64
+	if (cpu::features().avx2)
+		return detail::composeTRSAVX2;
+	return detail::composeTRSSSE;
+#else
+	return detail::composeTRSScalar;
+#endif
+}
+
+
+void composeTRS(const Vec3* positions, const Quat* rotations, const Vec3* scales, Mat4* outMatrices, uint32 count) {
+	static const ComposeTRSFn composeTRSImpl = selectComposeTRS();
+	composeTRSImpl(positions, rotations, scales, outMatrices, count);
+}
+
+
+} // ns math
+} // ns stardazed
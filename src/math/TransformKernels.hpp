@@ -0,0 +1,68 @@
+// ------------------------------------------------------------------
+// math::TransformKernels - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_MATH_TRANSFORMKERNELS_H
+#define SD_MATH_TRANSFORMKERNELS_H
+
+#include "system/Config.hpp"
+#include "math/Vector.hpp"
+#include "math/Matrix.hpp"
+#include "math/Quaternion.hpp"
+
+namespace stardazed {
+namespace math {
+
+
+// Composes translation * rotation * scale directly into the matrix: the first
+// three columns are the rotation's basis vectors scaled per axis, the last
+// column is the translation. Same result as
+// translationMatrix(position) * rotation.toMatrix4() * scaleMatrix(scale)
+inline void composeTRS(const Vec3& position, const Quat& rotation, const Vec3& scale, Mat4& outMatrix) {
+	const float x2 = rotation.x * rotation.x, y2 = rotation.y * rotation.y, z2 = rotation.z * rotation.z;
+	const float xy = rotation.x * rotation.y, xz = rotation.x * rotation.z, yz = rotation.y * rotation.z;
+	const float wx = rotation.w * rotation.x, wy = rotation.w * rotation.y, wz = rotation.w * rotation.z;
+
+	auto m = outMatrix.data;
+	m[0]  = (1 - 2 * (y2 + z2)) * scale.x;
+	m[1]  = 2 * (xy + wz) * scale.x;
+	m[2]  = 2 * (xz - wy) * scale.x;
+	m[3]  = 0;
+
+	m[4]  = 2 * (xy - wz) * scale.y;
+	m[5]  = (1 - 2 * (x2 + z2)) * scale.y;
+	m[6]  = 2 * (yz + wx) * scale.y;
+	m[7]  = 0;
+
+	m[8]  = 2 * (xz + wy) * scale.z;
+	m[9]  = 2 * (yz - wx) * scale.z;
+	m[10] = (1 - 2 * (x2 + y2)) * scale.z;
+	m[11] = 0;
+
+	m[12] = position.x;
+	m[13] = position.y;
+	m[14] = position.z;
+	m[15] = 1;
+}
+
+
+// Batch version over SoA columns, writes count matrices. Uses the widest
+// vector unit available at runtime (AVX2, SSE) with a scalar fallback.
+void composeTRS(const Vec3* positions, const Quat* rotations, const Vec3* scales, Mat4* outMatrices, uint32 count);
+
+
+// -- the individual kernels, for testing and benchmarks only
+namespace detail {
+	void composeTRSScalar(const Vec3* positions, const Quat* rotations, const Vec3* scales, Mat4* outMatrices, uint32 count);
+#if SD_ARCH_X86_64
+	void composeTRSSSE(const Vec3* positions, const Quat* rotations, const Vec3* scales, Mat4* outMatrices, uint32 count);
+	void composeTRSAVX2(const Vec3* positions, const Quat* rotations, const Vec3* scales, Mat4* outMatrices, uint32 count);
+#endif
+} // ns detail
+
+
+} // ns math
+} // ns stardazed
+
+#endif
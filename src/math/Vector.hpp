@@ -8,6 +8,7 @@
 
 #include "system/Config.hpp"
 #include "math/Algorithm.hpp"
+#include "math/SIMD.hpp"
 
 #include <initializer_list>
 #include <algorithm>
@@ -865,6 +866,103 @@ Vector<3, T> reflect(const Vector<3, T>& in, const Vector<3, T>& normal) {
 	return in - (2 * dot(in, normal) * normal);
 }
 
+#if SD_MATH_SIMD
+#pragma mark SIMD specializations for Vec4
+
+// Plain overloads for float Vec4 operations, these are preferred over the
+// templates above in overload resolution. They are not constexpr.
+namespace detail {
+	inline simd::float4 load(const Vec4& vec) {
+		return simd::load(vec.data);
+	}
+
+	inline Vec4 toVec4(simd::float4 v) {
+		Vec4 result;
+		simd::store(result.data, v);
+		return result;
+	}
+}
+
+
+inline Vec4 operator +(const Vec4& a, const Vec4& b) {
+	return detail::toVec4(simd::add(detail::load(a), detail::load(b)));
+}
+
+
+inline Vec4& operator +=(Vec4& a, const Vec4& b) {
+	simd::store(a.data, simd::add(detail::load(a), detail::load(b)));
+	return a;
+}
+
+
+inline Vec4 operator -(const Vec4& a, const Vec4& b) {
+	return detail::toVec4(simd::sub(detail::load(a), detail::load(b)));
+}
+
+
+inline Vec4& operator -=(Vec4& a, const Vec4& b) {
+	simd::store(a.data, simd::sub(detail::load(a), detail::load(b)));
+	return a;
+}
+
+
+inline Vec4 operator *(const Vec4& a, const Vec4& b) {
+	return detail::toVec4(simd::mul(detail::load(a), detail::load(b)));
+}
+
+
+inline Vec4& operator *=(Vec4& a, const Vec4& b) {
+	simd::store(a.data, simd::mul(detail::load(a), detail::load(b)));
+	return a;
+}
+
+
+inline Vec4 operator *(const Vec4& vec, const float scalar) {
+	return detail::toVec4(simd::mul(detail::load(vec), simd::splat(scalar)));
+}
+
+
+inline Vec4 operator *(const float scalar, const Vec4& vec) {
+	return detail::toVec4(simd::mul(simd::splat(scalar), detail::load(vec)));
+}
+
+
+inline Vec4& operator *=(Vec4& vec, const float scalar) {
+	simd::store(vec.data, simd::mul(detail::load(vec), simd::splat(scalar)));
+	return vec;
+}
+
+
+inline Vec4 operator /(const Vec4& a, const Vec4& b) {
+	return detail::toVec4(simd::div(detail::load(a), detail::load(b)));
+}
+
+
+inline Vec4& operator /=(Vec4& a, const Vec4& b) {
+	simd::store(a.data, simd::div(detail::load(a), detail::load(b)));
+	return a;
+}
+
+
+inline Vec4 operator /(const Vec4& vec, const float scalar) {
+	return detail::toVec4(simd::div(detail::load(vec), simd::splat(scalar)));
+}
+
+
+inline Vec4& operator /=(Vec4& vec, const float scalar) {
+	simd::store(vec.data, simd::div(detail::load(vec), simd::splat(scalar)));
+	return vec;
+}
+
+
+// the lanes are summed pairwise, the result can differ from the scalar
+// version in the last bit
+inline float dot(const Vec4& a, const Vec4& b) {
+	return simd::first(simd::horizontalSum(simd::mul(detail::load(a), detail::load(b))));
+}
+
+#endif // SD_MATH_SIMD
+
 	
 } // ns math
 } // ns stardazed
@@ -4,11 +4,48 @@
 // ------------------------------------------------------------------
 
 #include "memory/Allocator.hpp"
+#include "math/Algorithm.hpp"
+
+#if SD_PLATFORM_OSX
+#	include <malloc/malloc.h>
+#else
+#	include <malloc.h>
+#endif
 
 namespace stardazed {
 namespace memory {
 
 
+bool Allocator::tryExpandInPlace(void* /* ptr */, uint64 /* oldSizeBytes */, uint64 /* newSizeBytes */) {
+	return false;
+}
+
+
+void* Allocator::realloc(void* ptr, uint64 oldSizeBytes, uint64 newSizeBytes) {
+	if (! ptr)
+		return alloc(newSizeBytes);
+
+	if (tryExpandInPlace(ptr, oldSizeBytes, newSizeBytes))
+		return ptr;
+
+	auto newPtr = alloc(newSizeBytes);
+	if (newPtr) {
+		memcpy(newPtr, ptr, math::min(oldSizeBytes, newSizeBytes));
+		free(ptr);
+	}
+	return newPtr;
+}
+
+
+bool SystemAllocator::tryExpandInPlace(void* ptr, uint64 /* oldSizeBytes */, uint64 newSizeBytes) {
+#if SD_PLATFORM_OSX
+	return newSizeBytes <= malloc_size(ptr);
+#else
+	return newSizeBytes <= malloc_usable_size(ptr);
+#endif
+}
+
+
 SystemAllocator& SystemAllocator::sharedInstance() {
 	static SystemAllocator sha_s;
 	return sha_s;
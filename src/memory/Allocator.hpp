@@ -9,6 +9,7 @@
 #include "system/Config.hpp"
 #include <cstring>
 #include <cstddef>
+#include <cstdlib>
 
 namespace stardazed {
 namespace memory {
@@ -77,6 +78,26 @@ struct Allocator {
 	
 	virtual bool allocZeroesMemory() const = 0;
 	virtual uint guaranteedAlignment() const = 0;
+
+	// Try to resize the block at ptr without moving it.
+	// The default implementation never succeeds.
+	virtual bool tryExpandInPlace(void* ptr, uint64 oldSizeBytes, uint64 newSizeBytes);
+
+	// Resize the block at ptr, possibly moving it. The contents up to the smaller
+	// of both sizes are kept, grown memory is NOT zeroed, even if allocZeroesMemory().
+	// The default implementation tries tryExpandInPlace and otherwise does alloc+copy+free.
+	virtual void* realloc(void* ptr, uint64 oldSizeBytes, uint64 newSizeBytes);
+};
+
+
+// Deleter for std::unique_ptr managed blocks obtained from an Allocator
+
+struct AllocatorDeleter {
+	Allocator* allocator = nullptr;
+
+	void operator()(void* ptr) const {
+		allocator->free(ptr);
+	}
 };
 
 
@@ -99,6 +120,14 @@ struct SystemAllocator final : Allocator {
 	
 	bool allocZeroesMemory() const final { return true; }
 	uint guaranteedAlignment() const final { return alignof(max_align_t); }
+
+	// succeeds if the new size fits in the usable size of the heap block
+	bool tryExpandInPlace(void* ptr, uint64 oldSizeBytes, uint64 newSizeBytes) final;
+
+	// defers to the C library, which can remap large blocks instead of copying
+	void* realloc(void* ptr, uint64 /* oldSizeBytes */, uint64 newSizeBytes) final {
+		return ::realloc(ptr, newSizeBytes);
+	}
 	
 	static SystemAllocator& sharedInstance();
 
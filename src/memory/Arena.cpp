@@ -0,0 +1,154 @@
+// ------------------------------------------------------------------
+// memory::Arena.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "memory/Arena.hpp"
+#include "math/Algorithm.hpp"
+
+#include <cstring>
+
+namespace stardazed {
+namespace memory {
+
+
+ArenaAllocator::ArenaAllocator(Allocator& blockAlloc, uint32 blockSize, ArenaMemory memoryInit)
+: blockAlloc_(blockAlloc)
+, blockSize_(math::alignUp(blockSize, 32))
+, offsetInCurBlock_(0)
+, curBlockIndex_(0)
+, blockList_(blockAlloc_, 16)
+, largeBlocks_(blockAlloc_, 4)
+, largeBlockBytes_(0)
+, highWaterMark_(0)
+, memoryInit_(memoryInit)
+{
+	blockList_.emplaceBack(static_cast<uint8*>(blockAlloc_.alloc(blockSize_)));
+}
+
+
+ArenaAllocator::~ArenaAllocator() {
+	releaseLargeBlocksFrom(0);
+
+	for (uint b = 0; b < blockList_.count(); ++b) {
+		blockAlloc_.free(blockList_[b]);
+	}
+}
+
+
+void ArenaAllocator::nextBlock() {
+	++curBlockIndex_;
+	offsetInCurBlock_ = 0;
+
+	// blocks released by a reset or rewind are reused before new ones are allocated
+	if (curBlockIndex_ == blockList_.count()) {
+		blockList_.emplaceBack(static_cast<uint8*>(blockAlloc_.alloc(blockSize_)));
+	}
+}
+
+
+void* ArenaAllocator::allocLarge(uint64 sizeBytes, uint32 alignment) {
+	auto blockSizeBytes = sizeBytes + alignment;
+	auto base = blockAlloc_.alloc(blockSizeBytes);
+	if (! base)
+		return nullptr;
+
+	largeBlocks_.append({ base, blockSizeBytes });
+	largeBlockBytes_ += blockSizeBytes;
+
+	auto aligned = math::alignUp(reinterpret_cast<uint64>(base), alignment);
+	return reinterpret_cast<void*>(aligned);
+}
+
+
+void ArenaAllocator::releaseLargeBlocksFrom(uint32 firstIndex) {
+	while (largeBlocks_.count() > firstIndex) {
+		auto& large = largeBlocks_.back();
+		largeBlockBytes_ -= large.sizeBytes;
+		blockAlloc_.free(large.base);
+		largeBlocks_.popBack();
+	}
+}
+
+
+void* ArenaAllocator::alloc(uint64 sizeBytes, uint32 alignment) {
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+	void* ptr;
+
+	// Large allocations would waste most of a standard block, give them their own.
+	if (__builtin_expect(sizeBytes + alignment > blockSize_ / 2, 0)) {
+		ptr = allocLarge(sizeBytes, alignment);
+	}
+	else {
+		auto curBlockAddr = reinterpret_cast<uint64>(blockList_[curBlockIndex_]);
+		auto offset = math::alignUp(curBlockAddr + offsetInCurBlock_, alignment) - curBlockAddr;
+
+		if (__builtin_expect(offset + sizeBytes > blockSize_, 0)) {
+			nextBlock();
+			curBlockAddr = reinterpret_cast<uint64>(blockList_[curBlockIndex_]);
+			offset = math::alignUp(curBlockAddr, alignment) - curBlockAddr;
+		}
+
+		ptr = blockList_[curBlockIndex_] + offset;
+		offsetInCurBlock_ = static_cast<uint32>(offset + sizeBytes);
+	}
+
+	if (memoryInit_ == ArenaMemory::Zeroed && ptr) {
+		memset(ptr, 0, sizeBytes);
+	}
+
+	highWaterMark_ = math::max(highWaterMark_, usedBytes());
+	return ptr;
+}
+
+
+bool ArenaAllocator::tryExpandInPlace(void* ptr, uint64 oldSizeBytes, uint64 newSizeBytes) {
+	auto curBlock = blockList_[curBlockIndex_];
+	auto blockPtr = static_cast<uint8*>(ptr);
+
+	// only the last allocation in the current block can grow
+	if (blockPtr + oldSizeBytes != curBlock + offsetInCurBlock_)
+		return false;
+
+	auto offset = uint64(blockPtr - curBlock);
+	if (offset + newSizeBytes > blockSize_)
+		return false;
+
+	offsetInCurBlock_ = static_cast<uint32>(offset + newSizeBytes);
+	if (memoryInit_ == ArenaMemory::Zeroed && newSizeBytes > oldSizeBytes) {
+		memset(blockPtr + oldSizeBytes, 0, newSizeBytes - oldSizeBytes);
+	}
+
+	highWaterMark_ = math::max(highWaterMark_, usedBytes());
+	return true;
+}
+
+
+void ArenaAllocator::reset() {
+	rewind({ 0, 0, 0 });
+}
+
+
+auto ArenaAllocator::mark() const -> Marker {
+	return { curBlockIndex_, offsetInCurBlock_, largeBlocks_.count() };
+}
+
+
+void ArenaAllocator::rewind(Marker marker) {
+	assert(marker.blockIndex < curBlockIndex_ || (marker.blockIndex == curBlockIndex_ && marker.offsetInBlock <= offsetInCurBlock_));
+	assert(marker.largeBlockCount <= largeBlocks_.count());
+
+	curBlockIndex_ = marker.blockIndex;
+	offsetInCurBlock_ = marker.offsetInBlock;
+	releaseLargeBlocksFrom(marker.largeBlockCount);
+}
+
+
+uint64 ArenaAllocator::usedBytes() const {
+	// bytes skipped at the end of full blocks count as used
+	return (uint64(curBlockIndex_) * blockSize_) + offsetInCurBlock_ + largeBlockBytes_;
+}
+
+
+} // ns memory
+} // ns stardazed
@@ -9,70 +9,89 @@
 #include "system/Config.hpp"
 #include "memory/Allocator.hpp"
 #include "container/Array.hpp"
-#include "math/Algorithm.hpp"
+#include "util/ConceptTraits.hpp"
 
 namespace stardazed {
 namespace memory {
 
 
-class ArenaAllocator : Allocator {
+enum class ArenaMemory {
+	Zeroed,        // every allocation is cleared, also when blocks are reused
+	Uninitialized  // caller will overwrite allocations, skip the memset
+};
+
+
+// Allocates many small objects from a list of fixed-size blocks.
+// Allocations larger than half a block get a dedicated block of their own.
+// Individual allocations are never freed, instead the arena as a whole is
+// reset or rewound to a marker. Standard blocks are kept for reuse after a
+// reset or rewind, dedicated large blocks are returned to the block allocator.
+
+class ArenaAllocator : public Allocator {
+public:
+	static constexpr uint32 defaultAlignment = 8;
+
+	struct Marker {
+		uint32 blockIndex;
+		uint32 offsetInBlock;
+		uint32 largeBlockCount;
+	};
+
+private:
+	struct LargeBlock {
+		void* base;
+		uint64 sizeBytes;
+	};
+
 	Allocator& blockAlloc_;
 	uint32 blockSize_, offsetInCurBlock_;
+	uint32 curBlockIndex_;
 	Array<uint8*> blockList_;
-	uint8* curBlock_;
-	
-	void nextBlock() {
-		curBlock_ = static_cast<uint8*>(blockAlloc_.alloc(blockSize_));
-		if (! blockAlloc_.allocZeroesMemory())
-			memset(curBlock_, 0, blockSize_);
-
-		blockList_.emplaceBack(curBlock_);
-		offsetInCurBlock_ = 0;
-	}
+	Array<LargeBlock> largeBlocks_;
+	uint64 largeBlockBytes_;
+	uint64 highWaterMark_;
+	ArenaMemory memoryInit_;
 
-public:
-	ArenaAllocator(Allocator& blockAlloc, uint32 blockSize = 4_MB)
-	: blockAlloc_(blockAlloc)
-	, blockSize_(math::alignUp(blockSize, 32))
-	, offsetInCurBlock_(0)
-	, blockList_(blockAlloc_, 16)
-	{
-		nextBlock();
-	}
+	void nextBlock();
+	void* allocLarge(uint64 sizeBytes, uint32 alignment);
+	void releaseLargeBlocksFrom(uint32 firstIndex);
 
+public:
+	ArenaAllocator(Allocator& blockAlloc, uint32 blockSize = 4_MB, ArenaMemory memoryInit = ArenaMemory::Zeroed);
+	~ArenaAllocator();
+	SD_NOCOPYORMOVE_CLASS(ArenaAllocator)
 
-	~ArenaAllocator() {
-		for (uint b = 0; b < blockList_.count(); ++b) {
-			blockAlloc_.free(blockList_[b]);
-		}
+	// -- Allocator interface
+	void* alloc(uint64 sizeBytes) final { return alloc(sizeBytes, defaultAlignment); }
+	void free(void* /* ptr */) final {
+		// Arena doesn't free individual objects
 	}
 
+	bool allocZeroesMemory() const final { return memoryInit_ == ArenaMemory::Zeroed; }
+	uint guaranteedAlignment() const final { return defaultAlignment; }
 
-	void* alloc(uint64 sizeBytes) final {
-		// ArenaAllocators are not meant for large allocations, but rather
-		// many small ones. We simply bail on too large an allocation.
-		if (__builtin_expect(sizeBytes > blockSize_, 0)) {
-			assert(! "Tried to allocate a block > blockSize");
-			return nullptr;
-		}
-		
-		if (__builtin_expect(offsetInCurBlock_ + sizeBytes > blockSize_, 0)) {
-			nextBlock();
-		}
-
-		auto ptr = curBlock_ + offsetInCurBlock_;
-		offsetInCurBlock_ += math::alignUp(sizeBytes, guaranteedAlignment());
-		return ptr;
-	}
+	// succeeds for the most recent allocation if the current block has room
+	bool tryExpandInPlace(void* ptr, uint64 oldSizeBytes, uint64 newSizeBytes) final;
 
+	// alignment must be a power of 2, it is applied to the absolute address
+	void* alloc(uint64 sizeBytes, uint32 alignment);
 
-	void free(void* /* ptr */) final {
-		// Arena doesn't free individual objects
+	template <typename T>
+	T* allocArray(uint32 count, uint32 alignment = alignof(T)) {
+		return static_cast<T*>(alloc(count * sizeof(T), alignment));
 	}
 
-	
-	bool allocZeroesMemory() const final { return true; }
-	uint guaranteedAlignment() const final { return 8; }
+	// -- bulk release, objects in released memory are not destructed
+	void reset();
+	Marker mark() const;
+	void rewind(Marker);
+
+	// -- statistics
+	uint64 usedBytes() const;
+	uint64 highWaterMark() const { return highWaterMark_; }
+	uint64 reservedBytes() const { return (uint64(blockList_.count()) * blockSize_) + largeBlockBytes_; }
+	uint32 blockCount() const { return blockList_.count(); }
+	uint32 largeBlockCount() const { return largeBlocks_.count(); }
 };
 
 
@@ -4,6 +4,7 @@
 // ------------------------------------------------------------------
 
 #include "memory/Block.hpp"
+#include "memory/VirtualMemory.hpp"
 
 namespace stardazed {
 namespace memory {
@@ -44,6 +45,21 @@ void* FixedSizeArena::alloc(uint32 sizeBytes, uint32 alignment) {
 }
 
 
+void* FixedSizeArena::tryAlloc(uint32 sizeBytes, uint32 alignment) {
+	auto usedBytes = uint32(cur_ - base_);
+	auto alignmentPadding = math::alignUp(usedBytes, alignment) - usedBytes;
+	auto effectiveSizeBytes = alignmentPadding + sizeBytes;
+
+	if (__builtin_expect(usedBytes + effectiveSizeBytes > capacity_, 0)) {
+		return nullptr;
+	}
+
+	auto block = cur_ + alignmentPadding;
+	cur_ += effectiveSizeBytes;
+	return block;
+}
+
+
 //   ___                     _    _       _
 //  / __|_ _ _____ __ ____ _| |__| |___  /_\  _ _ ___ _ _  __ _
 // | (_ | '_/ _ \ V  V / _` | '_ \ / -_)/ _ \| '_/ -_) ' \/ _` |
@@ -94,5 +110,90 @@ void* GrowableArena::alloc(uint32 sizeBytes, uint32 alignment) {
 }
 
 
+//  __   ___     _             _   _
+//  \ \ / (_)_ _| |_ _  _ __ _| | /_\  _ _ ___ _ _  __ _
+//   \ V /| | '_|  _| || / _` | |/ _ \| '_/ -_) ' \/ _` |
+//    \_/ |_|_|  \__|\_,_\__,_|_/_/ \_\_| \___|_||_\__,_|
+//
+
+VirtualArena::VirtualArena(uint32 initialCapacity, uint32 maxCapacity)
+: capacity_(0)
+, maxCapacity_(math::alignUp(maxCapacity, vm::pageSize()))
+{
+	assert(initialCapacity > 0);
+	assert(initialCapacity <= maxCapacity);
+
+	base_ = static_cast<uint8*>(vm::reserve(maxCapacity_));
+	cur_ = base_;
+	if (! base_) {
+		// an arena without address space fails every alloc
+		assert(! "VirtualArena: could not reserve address range");
+		maxCapacity_ = 0;
+		return;
+	}
+
+	if (! commitUpTo(initialCapacity)) {
+		// capacity_ stays 0, alloc will retry the commit on demand
+		assert(! "VirtualArena: could not commit initial capacity");
+	}
+}
+
+
+VirtualArena::~VirtualArena() {
+	if (base_) {
+		vm::release(base_, maxCapacity_);
+	}
+}
+
+
+bool VirtualArena::commitUpTo(uint32 newCapacity) {
+	newCapacity = math::min(math::alignUp(newCapacity, commitGranularity_s), maxCapacity_);
+	if (newCapacity <= capacity_)
+		return true;
+
+	if (! vm::commit(base_ + capacity_, newCapacity - capacity_))
+		return false;
+
+	capacity_ = newCapacity;
+	return true;
+}
+
+
+void* VirtualArena::alloc(uint32 sizeBytes, uint32 alignment) {
+	auto usedBytes = uint32(cur_ - base_);
+	auto alignmentPadding = math::alignUp(usedBytes, alignment) - usedBytes;
+	auto effectiveSizeBytes = alignmentPadding + sizeBytes;
+
+	if (__builtin_expect(usedBytes + effectiveSizeBytes > capacity_, 0)) {
+		// commit at least growthFactor more pages to limit the number of syscalls,
+		// the memory does not move so only the newly committed pages are touched
+		auto requiredCapacity = uint64(usedBytes) + effectiveSizeBytes;
+		if (requiredCapacity > maxCapacity_) {
+			assert(! "VirtualArena: reserved address range exhausted");
+			return nullptr;
+		}
+
+		auto newCapacity = math::max(uint32(requiredCapacity), uint32(math::min(uint64(capacity_) * 3 / 2, uint64(maxCapacity_))));
+		if (! commitUpTo(newCapacity)) {
+			assert(! "VirtualArena: could not commit memory");
+			return nullptr;
+		}
+	}
+
+	auto block = cur_ + alignmentPadding;
+	cur_ += effectiveSizeBytes;
+	return block;
+}
+
+
+void VirtualArena::trim() {
+	auto keepCapacity = math::alignUp(usedBytes(), commitGranularity_s);
+	if (keepCapacity < capacity_) {
+		vm::decommit(base_ + keepCapacity, capacity_ - keepCapacity);
+		capacity_ = keepCapacity;
+	}
+}
+
+
 } // ns memory
 } // ns stardazed
@@ -9,6 +9,7 @@
 #include "system/Config.hpp"
 #include "memory/Allocator.hpp"
 #include "math/Algorithm.hpp"
+#include "util/ConceptTraits.hpp"
 
 namespace stardazed {
 namespace memory {
@@ -25,11 +26,19 @@ public:
 	~FixedSizeArena();
 
 	void* alloc(uint32 sizeBytes, uint32 alignment = 8);
+	void* tryAlloc(uint32 sizeBytes, uint32 alignment = 8); // returns nullptr if full
 	
 	void clear() {
 		cur_ = base_;
 	}
 	
+	// roll back to an earlier value of usedBytes(), releasing all
+	// blocks allocated since that point in one go
+	void rewind(uint32 usedBytes) {
+		assert(usedBytes <= this->usedBytes());
+		cur_ = base_ + usedBytes;
+	}
+	
 	uint32 internalOffsetOf(void* block) {
 		assert((uint8*)block > base_ && (uint8*)block < base_ + capacity_);
 		return uint32((uint8*)block - base_);
@@ -47,6 +56,8 @@ public:
 	}
 
 	void* basePointer() const { return base_; }
+	uint32 usedBytes() const { return uint32(cur_ - base_); }
+	uint32 capacity() const { return capacity_; }
 };
 
 
@@ -89,6 +100,57 @@ public:
 };
 
 
+// Same interface as GrowableArena, but the arena reserves an address range
+// of maxCapacity bytes up front and commits pages as it grows. Growth never
+// copies and pointers into the arena stay valid for its entire lifetime.
+
+class VirtualArena {
+	uint8* base_;
+	uint8* cur_;
+	uint32 capacity_;    // committed bytes
+	uint32 maxCapacity_; // reserved bytes
+
+	static constexpr uint32 commitGranularity_s = 64 * 1024;
+
+	bool commitUpTo(uint32 newCapacity);
+
+public:
+	VirtualArena(uint32 initialCapacity, uint32 maxCapacity = 1024 * 1024 * 1024);
+	~VirtualArena();
+	SD_NOCOPYORMOVE_CLASS(VirtualArena)
+
+	void* alloc(uint32 sizeBytes, uint32 alignment = 8);
+	
+	void clear() {
+		cur_ = base_;
+	}
+
+	// return committed pages beyond the used part of the arena to the OS
+	void trim();
+	
+	uint32 internalOffsetOf(void* block) {
+		assert((uint8*)block > base_ && (uint8*)block < base_ + capacity_);
+		return uint32((uint8*)block - base_);
+	}
+	
+	void* internalPointerAtOffset(uint32 offsetBytes) {
+		assert(offsetBytes < capacity_ - 1);
+		return base_ + offsetBytes;
+	}
+
+	template <typename T>
+	T* instanceAtOffset(uint32 offsetBytes) {
+		assert(offsetBytes < capacity_ - 1);
+		return reinterpret_cast<T*>(base_ + offsetBytes);
+	}
+
+	void* basePointer() const { return base_; }
+	uint32 usedBytes() const { return uint32(cur_ - base_); }
+	uint32 capacity() const { return capacity_; }
+	uint32 maxCapacity() const { return maxCapacity_; }
+};
+
+
 } // ns memory
 } // ns stardazed
 
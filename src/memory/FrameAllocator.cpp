@@ -0,0 +1,105 @@
+// ------------------------------------------------------------------
+// memory::FrameAllocator.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "memory/FrameAllocator.hpp"
+#include "math/Algorithm.hpp"
+
+namespace stardazed {
+namespace memory {
+
+
+FrameAllocator::FrameAllocator(Allocator& blockAlloc, uint32 bytesPerFrame, uint32 bufferedFrames)
+: blockAlloc_(blockAlloc)
+, bufferedFrames_(bufferedFrames)
+{
+	assert(bufferedFrames > 0 && bufferedFrames <= maxBufferedFrames);
+	assert(blockAlloc.guaranteedAlignment() >= defaultAlignment);
+
+	for (uint32 f = 0; f < bufferedFrames_; ++f) {
+		arenas_[f] = std::make_unique<FixedSizeArena>(blockAlloc, bytesPerFrame);
+	}
+}
+
+
+FrameAllocator::~FrameAllocator() {
+	for (uint32 f = 0; f < bufferedFrames_; ++f) {
+		freeOverflow(f);
+	}
+}
+
+
+void* FrameAllocator::allocOverflow(uint32 sizeBytes) {
+	// the link header takes defaultAlignment bytes to keep the user pointer aligned
+	auto block = static_cast<uint8*>(blockAlloc_.alloc(sizeBytes + defaultAlignment));
+	if (! block)
+		return nullptr;
+
+	auto link = reinterpret_cast<OverflowBlock*>(block);
+	link->next = overflow_[current_];
+	overflow_[current_] = link;
+	++overflowCount_;
+
+	return block + defaultAlignment;
+}
+
+
+void FrameAllocator::freeOverflow(uint32 arenaIndex) {
+	auto link = overflow_[arenaIndex];
+	while (link) {
+		auto next = link->next;
+		blockAlloc_.free(link);
+		link = next;
+	}
+	overflow_[arenaIndex] = nullptr;
+}
+
+
+void* FrameAllocator::alloc(uint32 sizeBytes, uint32 alignment) {
+	// arena offsets are aligned relative to the block base
+	assert(alignment <= defaultAlignment);
+	auto& arena = *arenas_[current_];
+	auto block = arena.tryAlloc(sizeBytes, alignment);
+
+	if (__builtin_expect(block == nullptr, 0)) {
+		return allocOverflow(sizeBytes);
+	}
+
+	highWaterMark_ = math::max(highWaterMark_, arena.usedBytes());
+	return block;
+}
+
+
+void FrameAllocator::nextFrame() {
+	current_ = (current_ + 1) % bufferedFrames_;
+	++frameCounter_;
+
+	arenas_[current_]->clear();
+	freeOverflow(current_);
+}
+
+
+auto FrameAllocator::mark() const -> Marker {
+	return { frameCounter_, arenas_[current_]->usedBytes() };
+}
+
+
+void FrameAllocator::rollback(Marker marker) {
+	// a marker from an earlier frame refers to an arena that has been
+	// or will be recycled by nextFrame, nothing to roll back in that case
+	if (marker.frame != frameCounter_)
+		return;
+
+	arenas_[current_]->rewind(marker.usedBytes);
+}
+
+
+FrameAllocator& defaultFrameAllocator() {
+	static FrameAllocator defaultFA { SystemAllocator::sharedInstance(), 4_MB, 2 };
+	return defaultFA;
+}
+
+
+} // ns memory
+} // ns stardazed
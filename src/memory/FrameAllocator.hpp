@@ -0,0 +1,125 @@
+// ------------------------------------------------------------------
+// memory::FrameAllocator - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_MEMORY_FRAMEALLOCATOR_H
+#define SD_MEMORY_FRAMEALLOCATOR_H
+
+#include "system/Config.hpp"
+#include "memory/Allocator.hpp"
+#include "memory/Block.hpp"
+#include "util/ConceptTraits.hpp"
+
+#include <memory>
+
+namespace stardazed {
+namespace memory {
+
+
+//  ___                    _   _ _              _
+// | __| _ __ _ _ __  ___ /_\ | | |___  __ __ _| |_ ___ _ _
+// | _| '_/ _` | '  \/ -_) _ \| | / _ \/ _/ _` |  _/ _ \ '_|
+// |_||_| \__,_|_|_|_\___/_/ \_\_|_\___/\__\__,_|\__\___/_|
+//
+
+// Linear allocator for per-frame scratch data. Allocations are pointer
+// bumps in the arena of the current frame and are never freed individually.
+// The allocator keeps a ring of bufferedFrames arenas, an arena is only
+// cleared when the ring comes back around to it in nextFrame(), so data
+// allocated in frame N stays valid up to and including frame N + bufferedFrames - 1.
+// Use a Scope (or mark/rollback) to release function-local scratch early.
+// When a frame's arena is full, allocations fall back to the block allocator.
+// Those blocks are freed when their frame is recycled, not by rollback.
+// A FrameAllocator is not thread-safe, use one per thread.
+
+class FrameAllocator final : public Allocator {
+public:
+	static constexpr uint32 maxBufferedFrames = 3;
+	static constexpr uint32 defaultAlignment = 16;
+
+	struct Marker {
+		uint32 frame;
+		uint32 usedBytes;
+	};
+
+private:
+	struct OverflowBlock {
+		OverflowBlock* next;
+	};
+
+	Allocator& blockAlloc_;
+	std::unique_ptr<FixedSizeArena> arenas_[maxBufferedFrames];
+	OverflowBlock* overflow_[maxBufferedFrames] {};
+	uint32 bufferedFrames_;
+	uint32 current_ = 0;
+	uint32 frameCounter_ = 0;
+	uint32 highWaterMark_ = 0;
+	uint32 overflowCount_ = 0;
+
+	void* allocOverflow(uint32 sizeBytes);
+	void freeOverflow(uint32 arenaIndex);
+
+public:
+	FrameAllocator(Allocator& blockAlloc, uint32 bytesPerFrame, uint32 bufferedFrames = 2);
+	~FrameAllocator();
+	SD_NOCOPYORMOVE_CLASS(FrameAllocator)
+
+	// -- Allocator interface
+	void* alloc(uint64 sizeBytes) final { return alloc(static_cast<uint32>(sizeBytes), defaultAlignment); }
+	void free(void* /* ptr */) final { /* released by rollback or nextFrame */ }
+
+	bool allocZeroesMemory() const final { return false; }
+	uint guaranteedAlignment() const final { return defaultAlignment; }
+
+	void* alloc(uint32 sizeBytes, uint32 alignment);
+
+	template <typename T>
+	T* allocArray(uint32 count) {
+		return static_cast<T*>(alloc(count * sizeof32<T>(), alignof(T)));
+	}
+
+	// -- frame boundaries, called by the RunLoop at the start of every frame
+	void nextFrame();
+	uint32 frameCounter() const { return frameCounter_; }
+
+	// -- scoped rollback, markers are only valid in the frame they were made in
+	Marker mark() const;
+	void rollback(Marker);
+
+	class Scope {
+		FrameAllocator& allocator_;
+		Marker marker_;
+
+	public:
+		explicit Scope(FrameAllocator& allocator)
+		: allocator_(allocator)
+		, marker_(allocator.mark())
+		{}
+		SD_NOCOPYORMOVE_CLASS(Scope)
+
+		~Scope() {
+			allocator_.rollback(marker_);
+		}
+	};
+
+	// -- observers
+	uint32 bufferedFrames() const { return bufferedFrames_; }
+	uint32 bytesPerFrame() const { return arenas_[0]->capacity(); }
+	uint32 usedBytes() const { return arenas_[current_]->usedBytes(); }
+	uint32 highWaterMark() const { return highWaterMark_; }
+	// allocations that did not fit in their frame's arena, a non-zero count
+	// means bytesPerFrame is too small for the workload
+	uint32 overflowCount() const { return overflowCount_; }
+};
+
+
+// The shared frame allocator, advanced by the default RunLoop.
+// Only to be used from the main thread.
+FrameAllocator& defaultFrameAllocator();
+
+
+} // ns memory
+} // ns stardazed
+
+#endif
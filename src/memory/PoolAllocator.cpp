@@ -0,0 +1,234 @@
+// ------------------------------------------------------------------
+// memory::PoolAllocator.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "memory/PoolAllocator.hpp"
+#include "math/Algorithm.hpp"
+
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+
+namespace stardazed {
+namespace memory {
+
+
+namespace {
+
+	// Block sizes include the per-block header and are all multiples of the
+	// block alignment. Classes are spaced ~25% apart so that the 1.5x growth
+	// of Array and HashMap lands in a different class on every resize.
+	constexpr uint32 classBlockSizes[] = {
+		32, 48, 64, 80, 96, 128, 160, 192, 256, 320, 384, 512, 640, 768,
+		1024, 1280, 1536, 2048, 2560, 3072, 4096, 5120, 6144, 8192, 10240, 12288, 16384
+	};
+
+	constexpr uint32 sizeClassCount = sizeof(classBlockSizes) / sizeof(classBlockSizes[0]);
+	constexpr uint32 largeBlockClass = 0xffffffff;
+	constexpr uint32 headerSizeBytes = PoolAllocator::blockAlignment;
+	constexpr uint32 granuleShift = 4;
+	constexpr uint32 granuleCount = (PoolAllocator::maxPooledSizeBytes + headerSizeBytes) >> granuleShift;
+
+	static_assert(classBlockSizes[sizeClassCount - 1] == PoolAllocator::maxPooledSizeBytes + headerSizeBytes, "largest class must match maxPooledSizeBytes");
+	static_assert((1 << granuleShift) == PoolAllocator::blockAlignment, "granules must be block aligned");
+
+
+	// -- map of total block size (in 16-byte granules) to size class
+	struct SizeClassMap {
+		uint8 classForGranules[granuleCount + 1];
+
+		constexpr SizeClassMap() : classForGranules{} {
+			uint32 sizeClass = 0;
+			for (uint32 granules = 0; granules <= granuleCount; ++granules) {
+				while ((classBlockSizes[sizeClass] >> granuleShift) < granules)
+					++sizeClass;
+				classForGranules[granules] = static_cast<uint8>(sizeClass);
+			}
+		}
+	};
+
+	constexpr SizeClassMap sizeClassMap_s {};
+
+
+	struct BlockHeader {
+		uint32 sizeClass;
+		uint32 pad_[3];
+	};
+
+	static_assert(sizeof(BlockHeader) == headerSizeBytes, "BlockHeader must be exactly 1 alignment unit");
+
+
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+
+	// -- state shared by all threads, only touched under the lock
+	struct SharedPool {
+		std::mutex lock;
+		FreeBlock* orphanedBlocks[sizeClassCount] {};
+		std::atomic<uint32> slabCount { 0 };
+		std::atomic<uint64> largeBlockCount { 0 };
+	};
+
+	SharedPool& sharedPool() {
+		static SharedPool pool_s;
+		return pool_s;
+	}
+
+
+	FreeBlock* carveSlab(uint32 sizeClass) {
+		void* slab = nullptr;
+		if (posix_memalign(&slab, PoolAllocator::slabAlignment, PoolAllocator::slabSizeBytes) != 0) {
+			return nullptr;
+		}
+		sharedPool().slabCount.fetch_add(1, std::memory_order_relaxed);
+
+		// link all blocks in the slab in address order
+		auto blockSize = classBlockSizes[sizeClass];
+		auto blockCount = PoolAllocator::slabSizeBytes / blockSize;
+		auto base = static_cast<uint8*>(slab);
+
+		for (uint32 b = 0; b < blockCount - 1; ++b) {
+			reinterpret_cast<FreeBlock*>(base + (b * blockSize))->next = reinterpret_cast<FreeBlock*>(base + ((b + 1) * blockSize));
+		}
+		reinterpret_cast<FreeBlock*>(base + ((blockCount - 1) * blockSize))->next = nullptr;
+
+		return reinterpret_cast<FreeBlock*>(base);
+	}
+
+
+	// -- per-thread free lists, no locking required
+	struct ThreadCache {
+		FreeBlock* freeBlocks[sizeClassCount] {};
+
+		~ThreadCache() {
+			// hand all cached blocks to the shared pool so other threads can use them
+			auto& pool = sharedPool();
+			std::lock_guard<std::mutex> guard { pool.lock };
+
+			for (uint32 sc = 0; sc < sizeClassCount; ++sc) {
+				auto head = freeBlocks[sc];
+				if (! head)
+					continue;
+
+				auto tail = head;
+				while (tail->next)
+					tail = tail->next;
+
+				tail->next = pool.orphanedBlocks[sc];
+				pool.orphanedBlocks[sc] = head;
+				freeBlocks[sc] = nullptr;
+			}
+		}
+
+		FreeBlock* refill(uint32 sizeClass) {
+			auto& pool = sharedPool();
+			{
+				std::lock_guard<std::mutex> guard { pool.lock };
+				auto orphans = pool.orphanedBlocks[sizeClass];
+				if (orphans) {
+					pool.orphanedBlocks[sizeClass] = nullptr;
+					return orphans;
+				}
+			}
+
+			return carveSlab(sizeClass);
+		}
+	};
+
+	thread_local ThreadCache threadCache_s;
+
+} // anonymous namespace
+
+
+PoolAllocator& PoolAllocator::sharedInstance() {
+	static PoolAllocator pool_s;
+	return pool_s;
+}
+
+
+void* PoolAllocator::alloc(uint64 sizeBytes) {
+	auto totalSizeBytes = sizeBytes + headerSizeBytes;
+	BlockHeader* header;
+	uint32 sizeClass;
+
+	if (__builtin_expect(sizeBytes <= maxPooledSizeBytes, 1)) {
+		auto granules = static_cast<uint32>(math::alignUp(totalSizeBytes, blockAlignment) >> granuleShift);
+		sizeClass = sizeClassMap_s.classForGranules[granules];
+
+		auto& cache = threadCache_s;
+		auto block = cache.freeBlocks[sizeClass];
+		if (__builtin_expect(block == nullptr, 0)) {
+			block = cache.refill(sizeClass);
+			if (! block)
+				return nullptr;
+		}
+		cache.freeBlocks[sizeClass] = block->next;
+
+		header = reinterpret_cast<BlockHeader*>(block);
+	}
+	else {
+		// large blocks bypass the pool entirely
+		void* mem = nullptr;
+		if (posix_memalign(&mem, blockAlignment, totalSizeBytes) != 0)
+			return nullptr;
+		sharedPool().largeBlockCount.fetch_add(1, std::memory_order_relaxed);
+
+		header = static_cast<BlockHeader*>(mem);
+		sizeClass = largeBlockClass;
+	}
+
+	header->sizeClass = sizeClass;
+	return header + 1;
+}
+
+
+void PoolAllocator::free(void* ptr) {
+	if (! ptr)
+		return;
+
+	auto header = static_cast<BlockHeader*>(ptr) - 1;
+	auto sizeClass = header->sizeClass;
+
+	if (__builtin_expect(sizeClass == largeBlockClass, 0)) {
+		sharedPool().largeBlockCount.fetch_sub(1, std::memory_order_relaxed);
+		::free(header);
+		return;
+	}
+
+	assert(sizeClass < sizeClassCount);
+
+	// blocks freed on a thread other than the allocating one simply
+	// join the freeing thread's list, all blocks of a class are equivalent
+	auto& cache = threadCache_s;
+	auto block = reinterpret_cast<FreeBlock*>(header);
+	block->next = cache.freeBlocks[sizeClass];
+	cache.freeBlocks[sizeClass] = block;
+}
+
+
+bool PoolAllocator::tryExpandInPlace(void* ptr, uint64 /* oldSizeBytes */, uint64 newSizeBytes) {
+	auto header = static_cast<BlockHeader*>(ptr) - 1;
+	auto sizeClass = header->sizeClass;
+
+	if (sizeClass == largeBlockClass || newSizeBytes > maxPooledSizeBytes)
+		return false;
+
+	return newSizeBytes + headerSizeBytes <= classBlockSizes[sizeClass];
+}
+
+
+uint32 PoolAllocator::slabCount() const {
+	return sharedPool().slabCount.load(std::memory_order_relaxed);
+}
+
+
+uint64 PoolAllocator::largeBlockCount() const {
+	return sharedPool().largeBlockCount.load(std::memory_order_relaxed);
+}
+
+
+} // ns memory
+} // ns stardazed
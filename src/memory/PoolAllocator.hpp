@@ -0,0 +1,61 @@
+// ------------------------------------------------------------------
+// memory::PoolAllocator - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_MEMORY_POOLALLOCATOR_H
+#define SD_MEMORY_POOLALLOCATOR_H
+
+#include "system/Config.hpp"
+#include "memory/Allocator.hpp"
+
+namespace stardazed {
+namespace memory {
+
+
+//  ___          _   _   _ _              _
+// | _ \___  ___| | /_\ | | |___  __ __ _| |_ ___ _ _
+// |  _/ _ \/ _ \ |/ _ \| | / _ \/ _/ _` |  _/ _ \ '_|
+// |_| \___/\___/_/_/ \_\_|_\___/\__\__,_|\__\___/_|
+//
+
+// Size-class pool allocator for the many small to medium sized
+// blocks that Array, HashMap and MultiArrayBuffer request.
+// Blocks are carved out of 64-byte aligned slabs and recycled through
+// per-thread free lists so the common alloc/free path takes no locks.
+// Requests larger than maxPooledSizeBytes go to the system heap.
+// Slabs are never returned to the system, memory freed by a thread is
+// handed back to a shared list when that thread exits.
+
+struct PoolAllocator final : Allocator {
+	void* alloc(uint64 sizeBytes) final;
+	void free(void* ptr) final;
+
+	// recycled blocks are handed out as-is
+	bool allocZeroesMemory() const final { return false; }
+	uint guaranteedAlignment() const final { return blockAlignment; }
+
+	// succeeds if the new size falls in the block's size class
+	bool tryExpandInPlace(void* ptr, uint64 oldSizeBytes, uint64 newSizeBytes) final;
+
+	static PoolAllocator& sharedInstance();
+
+	// -- pool configuration
+	static constexpr uint32 blockAlignment = 16;
+	static constexpr uint32 slabAlignment = 64;
+	static constexpr uint32 slabSizeBytes = 64 * 1024;
+	static constexpr uint32 maxPooledSizeBytes = 16 * 1024 - blockAlignment;
+
+	// -- statistics, shared over all threads
+	uint32 slabCount() const;
+	uint64 largeBlockCount() const;
+
+private:
+	PoolAllocator() = default; // singleton
+};
+
+
+} // ns memory
+} // ns stardazed
+
+#endif
@@ -0,0 +1,298 @@
+// ------------------------------------------------------------------
+// memory::TrackingAllocator.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "memory/TrackingAllocator.hpp"
+#include "system/Logging.hpp"
+#include "math/Algorithm.hpp"
+
+#include <cstdio>
+
+namespace stardazed {
+namespace memory {
+
+
+const char* memoryTagName(MemoryTag tag) {
+	switch (tag) {
+		case MemoryTag::Untagged: return "Untagged";
+		case MemoryTag::TransformManager: return "TransformManager";
+		case MemoryTag::RigidBodyManager: return "RigidBodyManager";
+		case MemoryTag::ColliderManager: return "ColliderManager";
+		case MemoryTag::Behaviour: return "Behaviour";
+		case MemoryTag::StandardModelManager: return "StandardModelManager";
+		case MemoryTag::TextureLoaders: return "TextureLoaders";
+		default:
+			assert(!"invalid MemoryTag");
+			return "";
+	}
+}
+
+
+namespace {
+	uint32 sizeBucket(uint64 sizeBytes) {
+		if (sizeBytes <= 16)
+			return 0;
+		auto log2Ceil = 64 - __builtin_clzll(sizeBytes - 1);
+		return math::min<uint32>(log2Ceil - 4, memorySizeBucketCount - 1);
+	}
+}
+
+
+//  __  __                        _____            _
+// |  \/  |___ _ __  ___ _ _ _  _|_   _| _ __ _ __| |_____ _ _
+// | |\/| / -_) '  \/ _ \ '_| || | | || '_/ _` / _| / / -_) '_|
+// |_|  |_\___|_|_|_\___/_|  \_, | |_||_| \__,_\__|_\_\___|_|
+//                           |__/
+
+MemoryTracker::MemoryTracker()
+: report_{ SystemAllocator::sharedInstance(), maxReportFrames * memoryTagCount }
+{}
+
+
+MemoryTracker& MemoryTracker::sharedInstance() {
+	static MemoryTracker tracker_s;
+	return tracker_s;
+}
+
+
+void MemoryTracker::setBudget(MemoryTag tag, uint64 budgetBytes, BudgetPolicy policy) {
+	auto& counters = tags_[static_cast<uint32>(tag)];
+	counters.budgetPolicy.store(policy, std::memory_order_relaxed);
+	counters.budgetBytes.store(budgetBytes, std::memory_order_relaxed);
+}
+
+
+bool MemoryTracker::addLiveBytes(MemoryTag tag, uint64 sizeBytes) {
+	auto& counters = tags_[static_cast<uint32>(tag)];
+
+	auto prevLive = counters.liveBytes.fetch_add(sizeBytes, std::memory_order_relaxed);
+	auto newLive = prevLive + sizeBytes;
+
+	auto budget = counters.budgetBytes.load(std::memory_order_relaxed);
+	if (__builtin_expect(budget > 0 && newLive > budget, 0)) {
+		if (counters.budgetPolicy.load(std::memory_order_relaxed) == BudgetPolicy::Fail) {
+			counters.liveBytes.fetch_sub(sizeBytes, std::memory_order_relaxed);
+			counters.failedCount.fetch_add(1, std::memory_order_relaxed);
+			log("Memory budget of ", memoryTagName(tag), " (", budget, " bytes) exceeded, refused allocation of ", sizeBytes, " bytes");
+			return false;
+		}
+
+		// only report the allocation that crosses the budget
+		if (prevLive <= budget) {
+			log("Memory budget of ", memoryTagName(tag), " (", budget, " bytes) exceeded, now at ", newLive, " bytes");
+		}
+	}
+
+	auto peak = counters.peakBytes.load(std::memory_order_relaxed);
+	while (newLive > peak && ! counters.peakBytes.compare_exchange_weak(peak, newLive, std::memory_order_relaxed))
+		;
+
+	return true;
+}
+
+
+bool MemoryTracker::recordAlloc(MemoryTag tag, uint64 sizeBytes) {
+	if (! addLiveBytes(tag, sizeBytes))
+		return false;
+
+	auto& counters = tags_[static_cast<uint32>(tag)];
+	counters.allocCount.fetch_add(1, std::memory_order_relaxed);
+	counters.sizeHistogram[sizeBucket(sizeBytes)].fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+
+bool MemoryTracker::recordResize(MemoryTag tag, uint64 oldSizeBytes, uint64 newSizeBytes) {
+	if (newSizeBytes >= oldSizeBytes)
+		return addLiveBytes(tag, newSizeBytes - oldSizeBytes);
+
+	tags_[static_cast<uint32>(tag)].liveBytes.fetch_sub(oldSizeBytes - newSizeBytes, std::memory_order_relaxed);
+	return true;
+}
+
+
+void MemoryTracker::recordFree(MemoryTag tag, uint64 sizeBytes) {
+	auto& counters = tags_[static_cast<uint32>(tag)];
+	counters.liveBytes.fetch_sub(sizeBytes, std::memory_order_relaxed);
+	counters.freeCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+MemoryTagStats MemoryTracker::stats(MemoryTag tag) const {
+	auto& counters = tags_[static_cast<uint32>(tag)];
+
+	MemoryTagStats stats;
+	stats.liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+	stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+	stats.allocCount = counters.allocCount.load(std::memory_order_relaxed);
+	stats.freeCount = counters.freeCount.load(std::memory_order_relaxed);
+	stats.failedCount = counters.failedCount.load(std::memory_order_relaxed);
+	stats.budgetBytes = counters.budgetBytes.load(std::memory_order_relaxed);
+	for (uint32 b = 0; b < memorySizeBucketCount; ++b) {
+		stats.sizeHistogram[b] = counters.sizeHistogram[b].load(std::memory_order_relaxed);
+	}
+	return stats;
+}
+
+
+void MemoryTracker::endFrame() {
+	for (uint32 t = 0; t < memoryTagCount; ++t) {
+		auto& counters = tags_[t];
+		auto allocCount = counters.allocCount.load(std::memory_order_relaxed);
+		auto freeCount = counters.freeCount.load(std::memory_order_relaxed);
+
+		if (report_.full()) {
+			report_.popFront();
+		}
+
+		report_.append({
+			frame_,
+			static_cast<MemoryTag>(t),
+			counters.liveBytes.load(std::memory_order_relaxed),
+			counters.peakBytes.load(std::memory_order_relaxed),
+			allocCount - counters.lastFrameAllocCount,
+			freeCount - counters.lastFrameFreeCount
+		});
+
+		counters.lastFrameAllocCount = allocCount;
+		counters.lastFrameFreeCount = freeCount;
+	}
+
+	++frame_;
+}
+
+
+std::string MemoryTracker::reportCSV() const {
+	std::string csv = "frame,tag,liveBytes,peakBytes,allocs,frees\n";
+
+	for (uint r = 0; r < report_.count(); ++r) {
+		const auto& rec = report_[r];
+		csv += concatAsString(rec.frame, ",", memoryTagName(rec.tag), ",", rec.liveBytes, ",", rec.peakBytes, ",", rec.frameAllocCount, ",", rec.frameFreeCount, "\n");
+	}
+
+	return csv;
+}
+
+
+bool MemoryTracker::writeReportCSV(const std::string& filePath) const {
+	auto file = fopen(filePath.c_str(), "w");
+	if (! file) {
+		log("Could not open ", filePath, " to write memory report");
+		return false;
+	}
+
+	auto csv = reportCSV();
+	auto written = fwrite(csv.data(), 1, csv.size(), file);
+	fclose(file);
+	return written == csv.size();
+}
+
+
+//  _____            _   _             _   _ _              _
+// |_   _| _ __ _ __| |_(_)_ _  __ _  /_\ | | |___  __ __ _| |_ ___ _ _
+//   | || '_/ _` / _| / / | ' \/ _` |/ _ \| | / _ \/ _/ _` |  _/ _ \ '_|
+//   |_||_| \__,_\__|_\_\_|_||_\__, /_/ \_\_|_\___/\__\__,_|\__\___/_|
+//                             |___/
+
+TrackingAllocator::TrackingAllocator(Allocator& base, MemoryTag tag)
+: base_(base)
+, tag_(tag)
+, headerSizeBytes_(math::max<uint32>(sizeof(uint64), base.guaranteedAlignment()))
+{}
+
+
+void* TrackingAllocator::alloc(uint64 sizeBytes) {
+	if (! MemoryTracker::sharedInstance().recordAlloc(tag_, sizeBytes))
+		return nullptr;
+
+	auto block = static_cast<uint8*>(base_.alloc(sizeBytes + headerSizeBytes_));
+	if (! block) {
+		MemoryTracker::sharedInstance().recordFree(tag_, sizeBytes);
+		return nullptr;
+	}
+
+	// the size is stored directly in front of the user pointer
+	auto ptr = block + headerSizeBytes_;
+	*(reinterpret_cast<uint64*>(ptr) - 1) = sizeBytes;
+	return ptr;
+}
+
+
+void TrackingAllocator::free(void* ptr) {
+	if (! ptr)
+		return;
+
+	auto sizeBytes = *(static_cast<uint64*>(ptr) - 1);
+	MemoryTracker::sharedInstance().recordFree(tag_, sizeBytes);
+	base_.free(static_cast<uint8*>(ptr) - headerSizeBytes_);
+}
+
+
+bool TrackingAllocator::tryExpandInPlace(void* ptr, uint64 /* oldSizeBytes */, uint64 newSizeBytes) {
+	// the header holds the size actually recorded for this block
+	auto oldSizeBytes = *(static_cast<uint64*>(ptr) - 1);
+
+	auto& tracker = MemoryTracker::sharedInstance();
+	if (! tracker.recordResize(tag_, oldSizeBytes, newSizeBytes))
+		return false;
+
+	auto block = static_cast<uint8*>(ptr) - headerSizeBytes_;
+	if (! base_.tryExpandInPlace(block, oldSizeBytes + headerSizeBytes_, newSizeBytes + headerSizeBytes_)) {
+		tracker.recordResize(tag_, newSizeBytes, oldSizeBytes);
+		return false;
+	}
+
+	*(static_cast<uint64*>(ptr) - 1) = newSizeBytes;
+	return true;
+}
+
+
+void* TrackingAllocator::realloc(void* ptr, uint64 /* oldSizeBytes */, uint64 newSizeBytes) {
+	if (! ptr)
+		return alloc(newSizeBytes);
+
+	auto oldSizeBytes = *(static_cast<uint64*>(ptr) - 1);
+
+	auto& tracker = MemoryTracker::sharedInstance();
+	if (! tracker.recordResize(tag_, oldSizeBytes, newSizeBytes))
+		return nullptr;
+
+	// let the base allocator move the block including its header
+	auto block = static_cast<uint8*>(ptr) - headerSizeBytes_;
+	auto newBlock = static_cast<uint8*>(base_.realloc(block, oldSizeBytes + headerSizeBytes_, newSizeBytes + headerSizeBytes_));
+	if (! newBlock) {
+		tracker.recordResize(tag_, newSizeBytes, oldSizeBytes);
+		return nullptr;
+	}
+
+	auto newPtr = newBlock + headerSizeBytes_;
+	*(reinterpret_cast<uint64*>(newPtr) - 1) = newSizeBytes;
+	return newPtr;
+}
+
+
+namespace {
+	template <MemoryTag Tag>
+	TrackingAllocator& systemTrackingAllocator() {
+		static TrackingAllocator ta_s { SystemAllocator::sharedInstance(), Tag };
+		return ta_s;
+	}
+}
+
+
+TrackingAllocator& trackedAllocator(MemoryTag tag) {
+	switch (tag) {
+		case MemoryTag::TransformManager: return systemTrackingAllocator<MemoryTag::TransformManager>();
+		case MemoryTag::RigidBodyManager: return systemTrackingAllocator<MemoryTag::RigidBodyManager>();
+		case MemoryTag::ColliderManager: return systemTrackingAllocator<MemoryTag::ColliderManager>();
+		case MemoryTag::Behaviour: return systemTrackingAllocator<MemoryTag::Behaviour>();
+		case MemoryTag::StandardModelManager: return systemTrackingAllocator<MemoryTag::StandardModelManager>();
+		case MemoryTag::TextureLoaders: return systemTrackingAllocator<MemoryTag::TextureLoaders>();
+		default: return systemTrackingAllocator<MemoryTag::Untagged>();
+	}
+}
+
+
+} // ns memory
+} // ns stardazed
@@ -0,0 +1,177 @@
+// ------------------------------------------------------------------
+// memory::TrackingAllocator - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_MEMORY_TRACKINGALLOCATOR_H
+#define SD_MEMORY_TRACKINGALLOCATOR_H
+
+#include "system/Config.hpp"
+#include "memory/Allocator.hpp"
+#include "container/RingBuffer.hpp"
+#include "util/ConceptTraits.hpp"
+
+#include <atomic>
+#include <string>
+
+namespace stardazed {
+namespace memory {
+
+
+//  __  __                        _____
+// |  \/  |___ _ __  ___ _ _ _  _|_   _|_ _ __ _
+// | |\/| / -_) '  \/ _ \ '_| || | | |/ _` / _` |
+// |_|  |_\___|_|_|_\___/_|  \_, | |_|\__,_\__, |
+//                           |__/          |___/
+
+enum class MemoryTag : uint32 {
+	Untagged,
+	TransformManager,
+	RigidBodyManager,
+	ColliderManager,
+	Behaviour,
+	StandardModelManager,
+	TextureLoaders,
+
+	TagCount
+};
+
+constexpr uint32 memoryTagCount = static_cast<uint32>(MemoryTag::TagCount);
+
+const char* memoryTagName(MemoryTag);
+
+
+enum class BudgetPolicy {
+	Log,  // log when the budget is crossed, allocation succeeds
+	Fail  // log and return nullptr
+};
+
+
+// Power-of-2 size buckets: <= 16 bytes, 32, 64, ..., and everything > 128 KiB
+constexpr uint32 memorySizeBucketCount = 14;
+
+
+struct MemoryTagStats {
+	uint64 liveBytes;
+	uint64 peakBytes;
+	uint64 allocCount;
+	uint64 freeCount;
+	uint64 failedCount;
+	uint64 budgetBytes; // 0 = no budget
+	uint64 sizeHistogram[memorySizeBucketCount];
+};
+
+
+struct MemoryFrameRecord {
+	uint32 frame;
+	MemoryTag tag;
+	uint64 liveBytes;
+	uint64 peakBytes;
+	uint64 frameAllocCount;
+	uint64 frameFreeCount;
+};
+
+
+//  __  __                        _____            _
+// |  \/  |___ _ __  ___ _ _ _  _|_   _| _ __ _ __| |_____ _ _
+// | |\/| / -_) '  \/ _ \ '_| || | | || '_/ _` / _| / / -_) '_|
+// |_|  |_\___|_|_|_\___/_|  \_, | |_||_| \__,_\__|_\_\___|_|
+//                           |__/
+
+// Collects allocation statistics per MemoryTag. Recording is lock-free and
+// may happen on any thread, endFrame() and the report functions are to be
+// called from the main thread only.
+
+class MemoryTracker {
+	struct TagCounters {
+		std::atomic<uint64> liveBytes { 0 };
+		std::atomic<uint64> peakBytes { 0 };
+		std::atomic<uint64> allocCount { 0 };
+		std::atomic<uint64> freeCount { 0 };
+		std::atomic<uint64> failedCount { 0 };
+		std::atomic<uint64> budgetBytes { 0 };
+		std::atomic<BudgetPolicy> budgetPolicy { BudgetPolicy::Log };
+		std::atomic<uint64> sizeHistogram[memorySizeBucketCount] {};
+
+		uint64 lastFrameAllocCount = 0;
+		uint64 lastFrameFreeCount = 0;
+	};
+
+	TagCounters tags_[memoryTagCount];
+	container::RingBuffer<MemoryFrameRecord> report_;
+	uint32 frame_ = 0;
+
+	MemoryTracker();
+	bool addLiveBytes(MemoryTag, uint64 sizeBytes);
+
+public:
+	static constexpr uint32 maxReportFrames = 600;
+
+	static MemoryTracker& sharedInstance();
+	SD_NOCOPYORMOVE_CLASS(MemoryTracker)
+
+	// -- budgets, a budget of 0 bytes removes the budget
+	void setBudget(MemoryTag, uint64 budgetBytes, BudgetPolicy = BudgetPolicy::Log);
+
+	// -- recording, recordAlloc returns false if the allocation must fail
+	bool recordAlloc(MemoryTag, uint64 sizeBytes);
+	void recordFree(MemoryTag, uint64 sizeBytes);
+
+	// a resize only adds or removes the difference between both sizes, so the
+	// budget is checked against growth alone. It is not counted as an alloc or free.
+	bool recordResize(MemoryTag, uint64 oldSizeBytes, uint64 newSizeBytes);
+
+	MemoryTagStats stats(MemoryTag) const;
+
+	// -- per-frame report, keeps the last maxReportFrames frames
+	void endFrame();
+	uint32 frame() const { return frame_; }
+
+	const container::RingBuffer<MemoryFrameRecord>& report() const { return report_; }
+	std::string reportCSV() const;
+	bool writeReportCSV(const std::string& filePath) const;
+};
+
+
+//  _____            _   _             _   _ _              _
+// |_   _| _ __ _ __| |_(_)_ _  __ _  /_\ | | |___  __ __ _| |_ ___ _ _
+//   | || '_/ _` / _| / / | ' \/ _` |/ _ \| | / _ \/ _/ _` |  _/ _ \ '_|
+//   |_||_| \__,_\__|_\_\_|_||_\__, /_/ \_\_|_\___/\__\__,_|\__\___/_|
+//                             |___/
+
+// Decorates another allocator and records every alloc and free under
+// a MemoryTag. Each block is prefixed with a header holding its size,
+// the header is as large as the underlying allocator's alignment so
+// the alignment guarantee is passed through unchanged.
+
+class TrackingAllocator final : public Allocator {
+	Allocator& base_;
+	MemoryTag tag_;
+	uint32 headerSizeBytes_;
+
+public:
+	TrackingAllocator(Allocator& base, MemoryTag tag);
+	SD_NOCOPYORMOVE_CLASS(TrackingAllocator)
+
+	void* alloc(uint64 sizeBytes) final;
+	void free(void* ptr) final;
+	bool tryExpandInPlace(void* ptr, uint64 oldSizeBytes, uint64 newSizeBytes) final;
+	void* realloc(void* ptr, uint64 oldSizeBytes, uint64 newSizeBytes) final;
+
+	bool allocZeroesMemory() const final { return base_.allocZeroesMemory(); }
+	uint guaranteedAlignment() const final { return base_.guaranteedAlignment(); }
+
+	MemoryTag tag() const { return tag_; }
+	Allocator& baseAllocator() const { return base_; }
+};
+
+
+// Shared per-tag tracking allocators on top of the SystemAllocator
+// for systems that do not take an allocator from their owner.
+TrackingAllocator& trackedAllocator(MemoryTag);
+
+
+} // ns memory
+} // ns stardazed
+
+#endif
@@ -0,0 +1,40 @@
+// ------------------------------------------------------------------
+// memory::VirtualMemory - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_MEMORY_VIRTUALMEMORY_H
+#define SD_MEMORY_VIRTUALMEMORY_H
+
+#include "system/Config.hpp"
+
+namespace stardazed {
+namespace memory {
+
+
+// Thin layer over the OS virtual memory functions. Address ranges are
+// reserved up front without backing memory and pages are committed as
+// needed. All addresses and sizes passed to commit and decommit must be
+// multiples of pageSize().
+
+namespace vm {
+
+	uint32 pageSize();
+
+	// returns nullptr if the address range could not be reserved
+	void* reserve(uint64 sizeBytes);
+	void release(void* base, uint64 sizeBytes);
+
+	// committed pages read as zero until first written
+	bool commit(void* address, uint64 sizeBytes);
+
+	// returns the pages to the OS, the range stays reserved
+	void decommit(void* address, uint64 sizeBytes);
+
+} // ns vm
+
+
+} // ns memory
+} // ns stardazed
+
+#endif
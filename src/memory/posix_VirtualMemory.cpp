@@ -0,0 +1,62 @@
+// ------------------------------------------------------------------
+// memory::posix_VirtualMemory.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "memory/VirtualMemory.hpp"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace stardazed {
+namespace memory {
+namespace vm {
+
+
+uint32 pageSize() {
+	static const uint32 pageSize_s = static_cast<uint32>(sysconf(_SC_PAGESIZE));
+	return pageSize_s;
+}
+
+
+void* reserve(uint64 sizeBytes) {
+	assert((sizeBytes & (pageSize() - 1)) == 0);
+
+	auto base = mmap(nullptr, sizeBytes, PROT_NONE, MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+	if (base == MAP_FAILED)
+		return nullptr;
+	return base;
+}
+
+
+void release(void* base, uint64 sizeBytes) {
+	munmap(base, sizeBytes);
+}
+
+
+bool commit(void* address, uint64 sizeBytes) {
+	assert((reinterpret_cast<uintptr_t>(address) & (pageSize() - 1)) == 0);
+	assert((sizeBytes & (pageSize() - 1)) == 0);
+
+	return mprotect(address, sizeBytes, PROT_READ | PROT_WRITE) == 0;
+}
+
+
+void decommit(void* address, uint64 sizeBytes) {
+	assert((reinterpret_cast<uintptr_t>(address) & (pageSize() - 1)) == 0);
+	assert((sizeBytes & (pageSize() - 1)) == 0);
+
+	// drop the backing pages so they read as zero when recommitted
+#if SD_PLATFORM_LINUX
+	madvise(address, sizeBytes, MADV_DONTNEED);
+	mprotect(address, sizeBytes, PROT_NONE);
+#else
+	// MADV_FREE'd pages may keep their contents, map fresh pages instead
+	mmap(address, sizeBytes, PROT_NONE, MAP_FIXED | MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+#endif
+}
+
+
+} // ns vm
+} // ns memory
+} // ns stardazed
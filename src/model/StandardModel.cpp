@@ -7,6 +7,8 @@
 #include "render/opengl/Mesh.hpp"
 #include "render/opengl/Buffer.hpp"
 #include "render/opengl/Pipeline.hpp"
+#include "memory/FrameAllocator.hpp"
+#include "memory/TrackingAllocator.hpp"
 
 namespace stardazed {
 namespace model {
@@ -45,7 +47,7 @@ StandardMaterialBuffer::StandardMaterialBuffer()
 	nextIndex_ = 1; // Indexes are 1-based to allow 0 being a nullptr-like
 	maxIndex_ = materialsPerBlock_ - 1;
 
-	auto numBlocks = static_cast<uint32>(std::ceilf((float)maxIndex_ / (float)materialsPerBlock_));
+	auto numBlocks = static_cast<uint32>(std::ceil((float)maxIndex_ / (float)materialsPerBlock_));
 	materialsConstBuffer_.allocate(numBlocks * rangeBlockSizeBytesAligned_);
 }
 
@@ -68,17 +70,19 @@ void StandardMaterialBuffer::appendMultiple(const StandardMaterialDescriptor* ba
 	size32 arraySizeBytes =  structSizeBytes * count;
 	size32 offsetBytes = nextIndex_ * structSizeBytes;
 
-	// -- copy-append const part of each descriptor into temp array
-	auto cma = std::make_unique<ConstStandardMaterial[]>(count);
+	// -- copy-append const part of each descriptor into frame scratch array
+	auto& frameAlloc = memory::defaultFrameAllocator();
+	memory::FrameAllocator::Scope scratchScope { frameAlloc };
+	auto cma = frameAlloc.allocArray<ConstStandardMaterial>(count);
 	
 	std::for_each(base, base + count,
-		[cmaPtr = cma.get()](const StandardMaterialDescriptor& mat) mutable {
+		[cmaPtr = cma](const StandardMaterialDescriptor& mat) mutable {
 			std::memcpy(cmaPtr, &mat, sizeof(ConstStandardMaterial));
 			++cmaPtr;
 		});
 
 	// -- copy const materials to GL buffer
-	materialsConstBuffer_.write(arraySizeBytes, cma.get(), offsetBytes);
+	materialsConstBuffer_.write(arraySizeBytes, cma, offsetBytes);
 
 	// -- return optional Indexes
 	if (outIndexesBase) {
@@ -178,9 +182,10 @@ StandardModelManager::StandardModelManager(RenderContext& renderCtx, scene::Tran
 : transformMgr_(tm)
 , stdShader_{renderCtx}
 , stdMaterialBuffer_{}
-, materialIndexes_{ memory::SystemAllocator::sharedInstance(), 4096 }
-, faceGroups_{ memory::SystemAllocator::sharedInstance(), 4096 }
-, instanceData_{ memory::SystemAllocator::sharedInstance(), 2048 }
+, materialIndexes_{ memory::trackedAllocator(memory::MemoryTag::StandardModelManager), 4096 }
+, faceGroups_{ memory::trackedAllocator(memory::MemoryTag::StandardModelManager), 4096 }
+, instanceData_{ memory::trackedAllocator(memory::MemoryTag::StandardModelManager), 2048 }
+, entityMap_{ memory::trackedAllocator(memory::MemoryTag::StandardModelManager) }
 {}
 
 
@@ -210,18 +215,38 @@ void StandardModelManager::linkEntityToModel(scene::Entity entity, Instance inst
 
 
 void StandardModelManager::render(RenderPass& renderPass, const scene::ProjectionSetup& proj, scene::Entity entity) {
-	// get instance data
 	auto modelTrans = entityMap_.find(entity);
 	assert(modelTrans);
-	auto instance = modelTrans->instance;
-	auto modelMatrix = transformMgr_.modelMatrix(modelTrans->transformInstance);
-	
-	auto mesh = *(instanceData_.elementsBasePtr<0>() + instance.ref);
+	auto mesh = *(instanceData_.elementsBasePtr<0>() + modelTrans->instance.ref);
+	renderInstance(renderPass, proj, modelTrans->instance, *mesh, transformMgr_.modelMatrix(modelTrans->transformInstance));
+}
+
+
+void StandardModelManager::capture(scene::RenderSnapshot& snapshot, scene::Entity entity) const {
+	auto modelTrans = entityMap_.find(entity);
+	assert(modelTrans);
+	auto mesh = *(instanceData_.elementsBasePtr<0>() + modelTrans->instance.ref);
+	snapshot.captureModel({ entity, modelTrans->transformInstance, mesh, modelTrans->instance.ref });
+}
+
+
+void StandardModelManager::render(RenderPass& renderPass, const scene::ProjectionSetup& proj, const scene::RenderSnapshot& snapshot) {
+	for (uint32 index = 0, count = snapshot.modelCount(); index < count; ++index) {
+		const auto& model = snapshot.model(index);
+		if (snapshot.hasTransform(model.transform)) {
+			renderInstance(renderPass, proj, { model.model }, *model.mesh, snapshot.modelMatrix(model.transform));
+		}
+	}
+}
+
+
+void StandardModelManager::renderInstance(RenderPass& renderPass, const scene::ProjectionSetup& proj, Instance instance, render::Mesh& mesh, const math::Mat4& modelMatrix) {
+	// get instance data
 	auto matIndexRange = *(instanceData_.elementsBasePtr<1>() + instance.ref);
 	auto faceGroupIndexRange = *(instanceData_.elementsBasePtr<2>() + instance.ref);
 
 	renderPass.setPipeline(stdShader_.pipeline());
-	renderPass.setMesh(*mesh);
+	renderPass.setMesh(mesh);
 	
 	// TODO: add some material-range thing here
 	stdMaterialBuffer_.mapMaterialAtBindPoint(materialIndexes_[matIndexRange.first], 0);
@@ -11,7 +11,7 @@
 
 #include "container/Array.hpp"
 #include "container/MultiArrayBuffer.hpp"
-#include "container/HashMap.hpp"
+#include "scene/EntityMap.hpp"
 
 #include "render/common/Mesh.hpp"
 #include "render/common/Texture.hpp"
@@ -24,6 +24,7 @@
 #include "scene/Entity.hpp"
 #include "scene/Transform.hpp"
 #include "scene/RendererShared.hpp"
+#include "scene/RenderSnapshot.hpp"
 
 
 namespace stardazed {
@@ -133,7 +134,9 @@ private:
 		scene::TransformManager::Instance transformInstance;
 	};
 
-	HashMap<scene::Entity, ModelTrans> entityMap_;
+	scene::EntityMap<ModelTrans> entityMap_;
+
+	void renderInstance(render::RenderPass&, const scene::ProjectionSetup&, Instance, render::Mesh&, const math::Mat4& modelMatrix);
 
 public:
 	StandardModelManager(render::RenderContext&, scene::TransformManager&);
@@ -142,6 +145,14 @@ public:
 	void linkEntityToModel(scene::Entity, Instance);
 
 	void render(render::RenderPass& renderPass, const scene::ProjectionSetup& proj, scene::Entity);
+
+	// -- pipelined mode: capture adds the entity's model to the snapshot on the
+	// simulation side, call it after the transforms are captured. render then
+	// draws the captured models without touching the live manager data, models
+	// whose transform is not in the snapshot are skipped. Models must be
+	// created outside of the simulation as create() uploads their materials.
+	void capture(scene::RenderSnapshot&, scene::Entity) const;
+	void render(render::RenderPass& renderPass, const scene::ProjectionSetup& proj, const scene::RenderSnapshot&);
 };
 
 
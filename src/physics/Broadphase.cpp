@@ -0,0 +1,872 @@
+// ------------------------------------------------------------------
+// physics::Broadphase.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "physics/Broadphase.hpp"
+#include "math/Algorithm.hpp"
+#include "util/Hash.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace stardazed {
+namespace physics {
+
+
+namespace {
+
+	BroadphasePair makePair(uint32 userA, uint32 userB) {
+		return userA < userB ? BroadphasePair{ userA, userB } : BroadphasePair{ userB, userA };
+	}
+
+
+	// order-independent key for a pair of proxy indexes
+	uint64 pairKey(uint32 proxyA, uint32 proxyB) {
+		return proxyA < proxyB ? (uint64(proxyA) << 32) | proxyB : (uint64(proxyB) << 32) | proxyA;
+	}
+
+
+	math::Bounds merged(const math::Bounds& a, const math::Bounds& b) {
+		auto result = a;
+		result.include(b);
+		return result;
+	}
+
+
+	float surfaceArea(const math::Bounds& bounds) {
+		auto size = bounds.size();
+		return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+} // anonymous namespace
+
+
+std::unique_ptr<Broadphase> makeBroadphase(BroadphaseType type, memory::Allocator& allocator) {
+	switch (type) {
+		case BroadphaseType::SweepAndPrune:
+			return std::make_unique<SweepAndPrune>(allocator);
+		case BroadphaseType::AABBTree:
+			return std::make_unique<AABBTree>(allocator);
+		case BroadphaseType::SpatialHashGrid:
+			return std::make_unique<SpatialHashGrid>(allocator);
+	}
+
+	assert(! "unknown broadphase type");
+	return nullptr;
+}
+
+
+// ---- SweepAndPrune
+
+SweepAndPrune::SweepAndPrune(memory::Allocator& allocator)
+: proxies_(allocator, 256)
+, freeProxies_(allocator, 64)
+, destroyedProxies_(allocator, 64)
+, endpoints_{ { allocator, 512 }, { allocator, 512 }, { allocator, 512 } }
+, active_(allocator, 64)
+, pairs_(allocator, 256)
+, deadPairs_(allocator, 64)
+{}
+
+
+BroadphaseProxy SweepAndPrune::createProxy(const math::Bounds& bounds, uint32 userValue) {
+	BroadphaseProxy proxy;
+	if (freeProxies_.count() > 0) {
+		proxy = freeProxies_.back();
+		freeProxies_.popBack();
+	}
+	else {
+		proxy = proxies_.count();
+		assert(proxy < maxEndpointBit);
+		proxies_.emplaceBack();
+	}
+
+	proxies_[proxy] = { bounds, userValue, 0, true };
+
+	// the next findPairs sorts the new endpoints into place
+	for (uint32 axis = 0; axis < 3; ++axis) {
+		endpoints_[axis].append({ bounds.min()[axis], proxy });
+		endpoints_[axis].append({ bounds.max()[axis], proxy | maxEndpointBit });
+	}
+	unsortedEndpoints_ += 2;
+
+	return proxy;
+}
+
+
+void SweepAndPrune::destroyProxy(BroadphaseProxy proxy) {
+	assert(proxies_[proxy].alive);
+	proxies_[proxy].alive = false;
+	destroyedProxies_.append(proxy);
+}
+
+
+void SweepAndPrune::moveProxy(BroadphaseProxy proxy, const math::Bounds& bounds) {
+	assert(proxies_[proxy].alive);
+	proxies_[proxy].bounds = bounds;
+}
+
+
+// Copies the current bounds into the endpoints and drops the endpoints and
+// pairs of destroyed proxies. The compaction keeps the relative order of the others.
+void SweepAndPrune::refreshEndpoints() {
+	auto proxies = proxies_.elementsBasePtr();
+
+	for (uint32 axis = 0; axis < 3; ++axis) {
+		auto& endpointArray = endpoints_[axis];
+		auto endpoints = endpointArray.elementsBasePtr();
+		uint32 writeIndex = 0;
+
+		for (uint32 readIndex = 0; readIndex < endpointArray.count(); ++readIndex) {
+			auto endpoint = endpoints[readIndex];
+			const auto& proxy = proxies[endpoint.proxyAndKind & ~maxEndpointBit];
+			if (! proxy.alive)
+				continue;
+
+			endpoint.value = (endpoint.proxyAndKind & maxEndpointBit) ? proxy.bounds.max()[axis] : proxy.bounds.min()[axis];
+			endpoints[writeIndex++] = endpoint;
+		}
+
+		endpointArray.resize(writeIndex);
+	}
+
+	if (destroyedProxies_.count() == 0)
+		return;
+
+	// the map cannot be changed while walking it, collect the keys first
+	deadPairs_.clear();
+	auto pairs = pairs_.all();
+	while (pairs.next()) {
+		auto key = pairs.current().key;
+		if (! proxies[key >> 32].alive || ! proxies[key & 0xffffffffu].alive) {
+			deadPairs_.append(key);
+		}
+	}
+	for (auto key : deadPairs_) {
+		pairs_.remove(key);
+	}
+
+	for (uint32 d = 0; d < destroyedProxies_.count(); ++d) {
+		freeProxies_.append(destroyedProxies_[d]);
+	}
+	destroyedProxies_.clear();
+}
+
+
+// Insertion sort of one axis. An endpoint moving down past an endpoint of the
+// other kind changes whether their proxies overlap on this axis: a min passing
+// a max starts an overlap, a max passing a min ends one. A started overlap is
+// only a pair if the final bounds also overlap on the other axes. Each pair of
+// endpoints passes at most once per sort, so an ended overlap removes a pair
+// that was not added again on another axis. Endpoints with equal values order
+// min before max so touching bounds overlap.
+void SweepAndPrune::sortAxis(uint32 axis) {
+	auto proxies = proxies_.elementsBasePtr();
+	auto first = endpoints_[axis].elementsBasePtr();
+	auto count = endpoints_[axis].count();
+
+	for (uint32 i = 1; i < count; ++i) {
+		auto endpoint = first[i];
+		auto isMax = endpoint.proxyAndKind & maxEndpointBit;
+		auto proxyIndex = endpoint.proxyAndKind & ~maxEndpointBit;
+		auto j = i;
+
+		while (j > 0 && endpointLess(endpoint, first[j - 1])) {
+			auto passed = first[j - 1];
+			auto passedIndex = passed.proxyAndKind & ~maxEndpointBit;
+
+			if ((passed.proxyAndKind & maxEndpointBit) != isMax && passedIndex != proxyIndex) {
+				auto key = pairKey(proxyIndex, passedIndex);
+				if (isMax) {
+					pairs_.remove(key);
+				}
+				else {
+					const auto& proxy = proxies[proxyIndex];
+					const auto& other = proxies[passedIndex];
+					if (proxy.bounds.intersects(other.bounds)) {
+						pairs_.insert(key, makePair(proxy.userValue, other.userValue));
+					}
+				}
+			}
+
+			first[j] = passed;
+			--j;
+		}
+		first[j] = endpoint;
+	}
+}
+
+
+// Finds all pairs from scratch with a sweep over the sorted x-axis endpoints,
+// testing the y and z axes only for proxies that overlap on x.
+void SweepAndPrune::sweepPairs() {
+	pairs_.clear();
+	active_.clear();
+
+	auto endpoints = endpoints_[0].elementsBasePtr();
+	auto proxies = proxies_.elementsBasePtr();
+
+	for (uint32 e = 0; e < endpoints_[0].count(); ++e) {
+		auto proxyIndex = endpoints[e].proxyAndKind & ~maxEndpointBit;
+		auto& proxy = proxies[proxyIndex];
+
+		if (endpoints[e].proxyAndKind & maxEndpointBit) {
+			// leaves the active list, the last active proxy takes its place
+			auto lastActive = active_.back();
+			active_[proxy.activeIndex] = lastActive;
+			proxies[lastActive].activeIndex = proxy.activeIndex;
+			active_.popBack();
+		}
+		else {
+			// overlaps on x with all active proxies, test the other axes
+			const auto& bMin = proxy.bounds.min();
+			const auto& bMax = proxy.bounds.max();
+
+			for (uint32 a = 0; a < active_.count(); ++a) {
+				auto otherIndex = active_[a];
+				const auto& other = proxies[otherIndex];
+				const auto& oMin = other.bounds.min();
+				const auto& oMax = other.bounds.max();
+
+				if (oMin.y <= bMax.y && oMax.y >= bMin.y && oMin.z <= bMax.z && oMax.z >= bMin.z) {
+					pairs_.insert(pairKey(proxyIndex, otherIndex), makePair(proxy.userValue, other.userValue));
+				}
+			}
+
+			proxy.activeIndex = active_.count();
+			active_.append(proxyIndex);
+		}
+	}
+}
+
+
+void SweepAndPrune::findPairs(Array<BroadphasePair>& outPairs) {
+	refreshEndpoints();
+
+	// many new endpoints at the back make the insertion sort quadratic
+	if (unsortedEndpoints_ > endpoints_[0].count() / 8) {
+		for (auto& endpoints : endpoints_) {
+			auto first = endpoints.elementsBasePtr();
+			std::sort(first, first + endpoints.count(), endpointLess);
+		}
+		sweepPairs();
+	}
+	else {
+		for (uint32 axis = 0; axis < 3; ++axis) {
+			sortAxis(axis);
+		}
+	}
+	unsortedEndpoints_ = 0;
+
+	outPairs.clear();
+	outPairs.reserve(pairs_.count());
+	auto pairs = pairs_.all();
+	while (pairs.next()) {
+		outPairs.append(pairs.current().val);
+	}
+}
+
+
+// ---- AABBTree
+
+AABBTree::AABBTree(memory::Allocator& allocator, float margin)
+: margin_(margin)
+, nodes_(allocator, 512)
+, proxies_(allocator, 256)
+, freeProxies_(allocator, 64)
+, stack_(allocator, 64)
+{}
+
+
+uint32 AABBTree::allocateNode() {
+	uint32 node;
+	if (freeNode_ != nullNode) {
+		node = freeNode_;
+		freeNode_ = nodes_[node].parent;
+	}
+	else {
+		node = nodes_.count();
+		nodes_.emplaceBack();
+	}
+
+	auto& n = nodes_[node];
+	n.parent = nullNode;
+	n.child1 = nullNode;
+	n.child2 = nullNode;
+	n.height = 0;
+	n.proxy = 0;
+	return node;
+}
+
+
+void AABBTree::freeNode(uint32 node) {
+	nodes_[node].parent = freeNode_;
+	nodes_[node].height = -1;
+	freeNode_ = node;
+}
+
+
+// Walks down from the root to the sibling with the lowest cost, the cost being
+// the surface area of the new parent plus the area added to the ancestors.
+void AABBTree::insertLeaf(uint32 leaf) {
+	if (root_ == nullNode) {
+		root_ = leaf;
+		nodes_[leaf].parent = nullNode;
+		return;
+	}
+
+	const auto leafBounds = nodes_[leaf].fatBounds;
+	auto index = root_;
+
+	while (nodes_[index].child1 != nullNode) {
+		const auto& node = nodes_[index];
+		auto area = surfaceArea(node.fatBounds);
+		auto combinedArea = surfaceArea(merged(node.fatBounds, leafBounds));
+
+		// cost of pairing the leaf with this node, and the minimum cost of descending
+		auto cost = 2.f * combinedArea;
+		auto inheritanceCost = 2.f * (combinedArea - area);
+
+		auto descendCost = [&](uint32 child) {
+			const auto& childBounds = nodes_[child].fatBounds;
+			auto childArea = surfaceArea(merged(leafBounds, childBounds));
+			if (nodes_[child].child1 != nullNode) {
+				childArea -= surfaceArea(childBounds);
+			}
+			return childArea + inheritanceCost;
+		};
+
+		auto cost1 = descendCost(node.child1);
+		auto cost2 = descendCost(node.child2);
+
+		if (cost < cost1 && cost < cost2)
+			break;
+
+		index = cost1 < cost2 ? node.child1 : node.child2;
+	}
+
+	auto sibling = index;
+	auto oldParent = nodes_[sibling].parent;
+	auto newParent = allocateNode(); // may move nodes_, take no references before this
+
+	auto& parentNode = nodes_[newParent];
+	parentNode.parent = oldParent;
+	parentNode.fatBounds = merged(leafBounds, nodes_[sibling].fatBounds);
+	parentNode.height = nodes_[sibling].height + 1;
+	parentNode.child1 = sibling;
+	parentNode.child2 = leaf;
+	nodes_[sibling].parent = newParent;
+	nodes_[leaf].parent = newParent;
+
+	if (oldParent != nullNode) {
+		if (nodes_[oldParent].child1 == sibling)
+			nodes_[oldParent].child1 = newParent;
+		else
+			nodes_[oldParent].child2 = newParent;
+	}
+	else {
+		root_ = newParent;
+	}
+
+	refitAncestors(nodes_[leaf].parent);
+}
+
+
+void AABBTree::removeLeaf(uint32 leaf) {
+	if (leaf == root_) {
+		root_ = nullNode;
+		return;
+	}
+
+	auto parent = nodes_[leaf].parent;
+	auto grandParent = nodes_[parent].parent;
+	auto sibling = nodes_[parent].child1 == leaf ? nodes_[parent].child2 : nodes_[parent].child1;
+
+	// the sibling takes the place of the parent
+	if (grandParent != nullNode) {
+		if (nodes_[grandParent].child1 == parent)
+			nodes_[grandParent].child1 = sibling;
+		else
+			nodes_[grandParent].child2 = sibling;
+		nodes_[sibling].parent = grandParent;
+		freeNode(parent);
+		refitAncestors(grandParent);
+	}
+	else {
+		root_ = sibling;
+		nodes_[sibling].parent = nullNode;
+		freeNode(parent);
+	}
+}
+
+
+// Recomputes bounds and heights from node up to the root, rebalancing on the way.
+void AABBTree::refitAncestors(uint32 node) {
+	while (node != nullNode) {
+		node = balance(node);
+
+		auto& n = nodes_[node];
+		const auto& c1 = nodes_[n.child1];
+		const auto& c2 = nodes_[n.child2];
+		n.height = 1 + math::max(c1.height, c2.height);
+		n.fatBounds = merged(c1.fatBounds, c2.fatBounds);
+
+		node = n.parent;
+	}
+}
+
+
+// If the subtrees of node differ in height by more than 1, the higher child is
+// rotated up to take the place of node. Returns the index of the subtree's new root.
+uint32 AABBTree::balance(uint32 iA) {
+	auto& A = nodes_[iA];
+	if (A.child1 == nullNode || A.height < 2)
+		return iA;
+
+	auto iB = A.child1;
+	auto iC = A.child2;
+	auto& B = nodes_[iB];
+	auto& C = nodes_[iC];
+	auto heightDiff = C.height - B.height;
+
+	auto replaceInParent = [this](uint32 parent, uint32 oldChild, uint32 newChild) {
+		if (parent == nullNode) {
+			root_ = newChild;
+		}
+		else if (nodes_[parent].child1 == oldChild) {
+			nodes_[parent].child1 = newChild;
+		}
+		else {
+			nodes_[parent].child2 = newChild;
+		}
+	};
+
+	if (heightDiff > 1) {
+		// rotate C up, its higher child stays with C, the other moves to A
+		auto iF = C.child1;
+		auto iG = C.child2;
+		auto& F = nodes_[iF];
+		auto& G = nodes_[iG];
+
+		C.child1 = iA;
+		C.parent = A.parent;
+		A.parent = iC;
+		replaceInParent(C.parent, iA, iC);
+
+		if (F.height > G.height) {
+			C.child2 = iF;
+			A.child2 = iG;
+			G.parent = iA;
+			A.fatBounds = merged(B.fatBounds, G.fatBounds);
+			A.height = 1 + math::max(B.height, G.height);
+			C.fatBounds = merged(A.fatBounds, F.fatBounds);
+			C.height = 1 + math::max(A.height, F.height);
+		}
+		else {
+			C.child2 = iG;
+			A.child2 = iF;
+			F.parent = iA;
+			A.fatBounds = merged(B.fatBounds, F.fatBounds);
+			A.height = 1 + math::max(B.height, F.height);
+			C.fatBounds = merged(A.fatBounds, G.fatBounds);
+			C.height = 1 + math::max(A.height, G.height);
+		}
+
+		return iC;
+	}
+
+	if (heightDiff < -1) {
+		// rotate B up, mirror image of the above
+		auto iD = B.child1;
+		auto iE = B.child2;
+		auto& D = nodes_[iD];
+		auto& E = nodes_[iE];
+
+		B.child1 = iA;
+		B.parent = A.parent;
+		A.parent = iB;
+		replaceInParent(B.parent, iA, iB);
+
+		if (D.height > E.height) {
+			B.child2 = iD;
+			A.child1 = iE;
+			E.parent = iA;
+			A.fatBounds = merged(C.fatBounds, E.fatBounds);
+			A.height = 1 + math::max(C.height, E.height);
+			B.fatBounds = merged(A.fatBounds, D.fatBounds);
+			B.height = 1 + math::max(A.height, D.height);
+		}
+		else {
+			B.child2 = iE;
+			A.child1 = iD;
+			D.parent = iA;
+			A.fatBounds = merged(C.fatBounds, D.fatBounds);
+			A.height = 1 + math::max(C.height, D.height);
+			B.fatBounds = merged(A.fatBounds, E.fatBounds);
+			B.height = 1 + math::max(A.height, E.height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
+
+
+BroadphaseProxy AABBTree::createProxy(const math::Bounds& bounds, uint32 userValue) {
+	BroadphaseProxy proxy;
+	if (freeProxies_.count() > 0) {
+		proxy = freeProxies_.back();
+		freeProxies_.popBack();
+	}
+	else {
+		proxy = proxies_.count();
+		proxies_.emplaceBack();
+	}
+
+	auto leaf = allocateNode();
+	math::Vec3 margin { margin_ };
+	nodes_[leaf].fatBounds = math::Bounds::fromMinAndMax(bounds.min() - margin, bounds.max() + margin);
+	nodes_[leaf].proxy = proxy;
+	insertLeaf(leaf);
+
+	proxies_[proxy] = { bounds, userValue, leaf };
+	return proxy;
+}
+
+
+void AABBTree::destroyProxy(BroadphaseProxy proxy) {
+	auto leaf = proxies_[proxy].leaf;
+	assert(leaf != nullNode);
+
+	removeLeaf(leaf);
+	freeNode(leaf);
+	proxies_[proxy].leaf = nullNode;
+	freeProxies_.append(proxy);
+}
+
+
+void AABBTree::moveProxy(BroadphaseProxy proxy, const math::Bounds& bounds) {
+	auto& p = proxies_[proxy];
+	assert(p.leaf != nullNode);
+	p.bounds = bounds;
+
+	if (nodes_[p.leaf].fatBounds.contains(bounds))
+		return;
+
+	removeLeaf(p.leaf);
+	math::Vec3 margin { margin_ };
+	nodes_[p.leaf].fatBounds = math::Bounds::fromMinAndMax(bounds.min() - margin, bounds.max() + margin);
+	insertLeaf(p.leaf);
+}
+
+
+// Queries the tree with each proxy's bounds. A pair is found from both of its
+// proxies, only the query from the lower proxy index reports it.
+void AABBTree::findPairs(Array<BroadphasePair>& outPairs) {
+	outPairs.clear();
+	if (root_ == nullNode)
+		return;
+
+	auto nodes = nodes_.elementsBasePtr();
+	auto proxies = proxies_.elementsBasePtr();
+
+	for (uint32 proxyIndex = 0; proxyIndex < proxies_.count(); ++proxyIndex) {
+		const auto& proxy = proxies[proxyIndex];
+		if (proxy.leaf == nullNode)
+			continue;
+
+		stack_.clear();
+		stack_.append(root_);
+
+		while (stack_.count() > 0) {
+			auto index = stack_.back();
+			stack_.popBack();
+
+			const auto& node = nodes[index];
+			if (! node.fatBounds.intersects(proxy.bounds))
+				continue;
+
+			if (node.child1 == nullNode) {
+				auto& other = proxies[node.proxy];
+				if (node.proxy > proxyIndex && other.bounds.intersects(proxy.bounds)) {
+					outPairs.append(makePair(proxy.userValue, other.userValue));
+				}
+			}
+			else {
+				stack_.append(node.child1);
+				stack_.append(node.child2);
+			}
+		}
+	}
+}
+
+
+// ---- SpatialHashGrid
+
+SpatialHashGrid::SpatialHashGrid(memory::Allocator& allocator, float cellSize)
+: cellSize_(cellSize)
+, invCellSize_(1.f / cellSize)
+, proxies_(allocator, 256)
+, freeProxies_(allocator, 64)
+, ranges_(allocator, 256)
+, entryBuckets_(allocator, 1024)
+, bucketStarts_(allocator, 1024)
+, bucketFill_(allocator, 1024)
+, entries_(allocator, 1024)
+, oversized_(allocator, 16)
+{
+	assert(cellSize > 0);
+	rebuild();
+}
+
+
+void SpatialHashGrid::setCellSize(float cellSize) {
+	assert(cellSize > 0);
+	cellSize_ = cellSize;
+	invCellSize_ = 1.f / cellSize;
+	rebuild();
+}
+
+
+// Converting a float outside the int32 range is undefined, so far away and
+// non-finite coordinates are clamped first. The upper limit is the largest
+// float below 2^31, which also keeps the ++x of the cell loops from overflowing.
+// NaN ends up at the lower limit.
+auto SpatialHashGrid::cellOf(const math::Vec3& point) const -> CellCoord {
+	auto cell = [this](float coord) {
+		auto c = std::floor(coord * invCellSize_);
+		return static_cast<int32>(std::fmin(std::fmax(c, -2147483648.f), 2147483520.f));
+	};
+	return { cell(point.x), cell(point.y), cell(point.z) };
+}
+
+
+auto SpatialHashGrid::cellRange(const math::Bounds& bounds) const -> CellRange {
+	return { cellOf(bounds.min()), cellOf(bounds.max()) };
+}
+
+
+uint32 SpatialHashGrid::bucketOf(const CellCoord& cell) const {
+	return static_cast<uint32>(hash(cell)) & bucketMask_;
+}
+
+
+BroadphaseProxy SpatialHashGrid::createProxy(const math::Bounds& bounds, uint32 userValue) {
+	BroadphaseProxy proxy;
+	if (freeProxies_.count() > 0) {
+		proxy = freeProxies_.back();
+		freeProxies_.popBack();
+	}
+	else {
+		proxy = proxies_.count();
+		proxies_.emplaceBack();
+	}
+
+	proxies_[proxy] = { bounds, userValue, true };
+	return proxy;
+}
+
+
+void SpatialHashGrid::destroyProxy(BroadphaseProxy proxy) {
+	assert(proxies_[proxy].alive);
+	proxies_[proxy].alive = false;
+	freeProxies_.append(proxy);
+}
+
+
+void SpatialHashGrid::moveProxy(BroadphaseProxy proxy, const math::Bounds& bounds) {
+	assert(proxies_[proxy].alive);
+	proxies_[proxy].bounds = bounds;
+}
+
+
+void SpatialHashGrid::rebuild() {
+	auto proxyCount = proxies_.count();
+	ranges_.resize(proxyCount);
+	entryBuckets_.clear();
+	oversized_.clear();
+
+	// -- find the cells covered by each proxy, set aside the large ones
+	uint32 entryCount = 0;
+	for (uint32 index = 0; index < proxyCount; ++index) {
+		const auto& proxy = proxies_[index];
+		auto& range = ranges_[index];
+		range = { { 0, 0, 0 }, { -1, -1, -1 } };
+		if (! proxy.alive)
+			continue;
+
+		auto cells = cellRange(proxy.bounds);
+		auto spanX = static_cast<uint64>(int64(cells.max.x) - cells.min.x + 1);
+		auto spanY = static_cast<uint64>(int64(cells.max.y) - cells.min.y + 1);
+		auto spanZ = static_cast<uint64>(int64(cells.max.z) - cells.min.z + 1);
+		if (spanX * spanY * spanZ > maxCellsPerProxy) {
+			oversized_.append({ proxy.bounds, {}, index, proxy.userValue });
+			continue;
+		}
+
+		range = cells;
+		entryCount += static_cast<uint32>(spanX * spanY * spanZ);
+	}
+
+	// -- counting sort of all entries by bucket, about 1 bucket per entry
+	auto bucketCount = math::roundUpPowerOf2(math::max(entryCount, 1u));
+	bucketMask_ = bucketCount - 1;
+	bucketStarts_.clear();
+	bucketStarts_.resize(bucketCount + 1);
+
+	for (uint32 index = 0; index < proxyCount; ++index) {
+		const auto& range = ranges_[index];
+		for (auto z = range.min.z; z <= range.max.z; ++z) {
+			for (auto y = range.min.y; y <= range.max.y; ++y) {
+				for (auto x = range.min.x; x <= range.max.x; ++x) {
+					auto bucket = bucketOf({ x, y, z });
+					entryBuckets_.append(bucket);
+					bucketStarts_[bucket + 1]++;
+				}
+			}
+		}
+	}
+
+	for (uint32 bucket = 1; bucket <= bucketCount; ++bucket) {
+		bucketStarts_[bucket] += bucketStarts_[bucket - 1];
+	}
+
+	bucketFill_.resizeUninitialized(bucketCount);
+	std::copy(bucketStarts_.elementsBasePtr(), bucketStarts_.elementsBasePtr() + bucketCount, bucketFill_.elementsBasePtr());
+	entries_.resize(entryCount);
+
+	// -- place the entries, visiting the cells in the same order as above
+	uint32 entryIndex = 0;
+	for (uint32 index = 0; index < proxyCount; ++index) {
+		const auto& proxy = proxies_[index];
+		const auto& range = ranges_[index];
+		for (auto z = range.min.z; z <= range.max.z; ++z) {
+			for (auto y = range.min.y; y <= range.max.y; ++y) {
+				for (auto x = range.min.x; x <= range.max.x; ++x) {
+					auto bucket = entryBuckets_[entryIndex++];
+					entries_[bucketFill_[bucket]++] = { proxy.bounds, { x, y, z }, index, proxy.userValue };
+				}
+			}
+		}
+	}
+}
+
+
+void SpatialHashGrid::findPairs(Array<BroadphasePair>& outPairs) {
+	rebuild();
+	outPairs.clear();
+
+	// Two proxies share every cell their intersection touches, the pair is
+	// reported only in the cell holding the minimum corner of the intersection.
+	// Buckets can contain entries from several cells, so compare cells as well.
+	auto bucketCount = bucketMask_ + 1;
+	auto entries = entries_.elementsBasePtr();
+	for (uint32 bucket = 0; bucket < bucketCount; ++bucket) {
+		auto end = bucketStarts_[bucket + 1];
+		for (auto a = bucketStarts_[bucket]; a < end; ++a) {
+			const auto& entryA = entries[a];
+			for (auto b = a + 1; b < end; ++b) {
+				const auto& entryB = entries[b];
+				if (entryA.cell == entryB.cell &&
+					entryA.bounds.intersects(entryB.bounds) &&
+					cellOf(math::max(entryA.bounds.min(), entryB.bounds.min())) == entryA.cell)
+				{
+					outPairs.append(makePair(entryA.userValue, entryB.userValue));
+				}
+			}
+		}
+	}
+
+	// -- large proxies are tested against all others
+	auto proxyCount = proxies_.count();
+	for (uint32 large = 0; large < oversized_.count(); ++large) {
+		const auto& entry = oversized_[large];
+
+		for (uint32 index = 0; index < proxyCount; ++index) {
+			const auto& range = ranges_[index];
+			if (range.max.x >= range.min.x && proxies_[index].bounds.intersects(entry.bounds)) {
+				outPairs.append(makePair(entry.userValue, proxies_[index].userValue));
+			}
+		}
+
+		for (auto other = large + 1; other < oversized_.count(); ++other) {
+			if (oversized_[other].bounds.intersects(entry.bounds)) {
+				outPairs.append(makePair(entry.userValue, oversized_[other].userValue));
+			}
+		}
+	}
+}
+
+
+template <typename Fn>
+void SpatialHashGrid::forEachEntry(const math::Bounds& area, Fn&& fn) const {
+	// Each entry is visited only in the cell holding the minimum corner
+	// of its intersection with area, as in findPairs.
+	auto accept = [&](const Entry& entry) {
+		return entry.bounds.intersects(area) &&
+			cellOf(math::max(entry.bounds.min(), area.min())) == entry.cell;
+	};
+
+	auto range = cellRange(area);
+	auto cellCount = static_cast<uint64>(int64(range.max.x) - range.min.x + 1) *
+	                 static_cast<uint64>(int64(range.max.y) - range.min.y + 1) *
+	                 static_cast<uint64>(int64(range.max.z) - range.min.z + 1);
+
+	if (cellCount > entries_.count()) {
+		// a large area is cheaper to handle by checking all entries
+		for (const auto& entry : entries_) {
+			if (accept(entry)) {
+				fn(entry);
+			}
+		}
+	}
+	else {
+		for (auto z = range.min.z; z <= range.max.z; ++z) {
+			for (auto y = range.min.y; y <= range.max.y; ++y) {
+				for (auto x = range.min.x; x <= range.max.x; ++x) {
+					CellCoord cell { x, y, z };
+					auto bucket = bucketOf(cell);
+					for (auto index = bucketStarts_[bucket]; index < bucketStarts_[bucket + 1]; ++index) {
+						const auto& entry = entries_[index];
+						if (entry.cell == cell && accept(entry)) {
+							fn(entry);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	for (const auto& entry : oversized_) {
+		if (entry.bounds.intersects(area)) {
+			fn(entry);
+		}
+	}
+}
+
+
+void SpatialHashGrid::queryBounds(const math::Bounds& area, Array<uint32>& outUserValues) const {
+	outUserValues.clear();
+	forEachEntry(area, [&](const Entry& entry) {
+		outUserValues.append(entry.userValue);
+	});
+}
+
+
+void SpatialHashGrid::queryRadius(const math::Vec3& center, float radius, Array<uint32>& outUserValues) const {
+	outUserValues.clear();
+	auto area = math::Bounds::fromCenterAndSize(center, math::Vec3{ radius * 2.f });
+	auto radiusSquared = radius * radius;
+
+	forEachEntry(area, [&](const Entry& entry) {
+		if (math::lengthSquared(entry.bounds.closestPoint(center) - center) <= radiusSquared) {
+			outUserValues.append(entry.userValue);
+		}
+	});
+}
+
+
+} // ns physics
+} // ns stardazed
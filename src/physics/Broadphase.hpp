@@ -0,0 +1,248 @@
+// ------------------------------------------------------------------
+// physics::Broadphase - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_PHYSICS_BROADPHASE_H
+#define SD_PHYSICS_BROADPHASE_H
+
+#include "system/Config.hpp"
+#include "memory/Allocator.hpp"
+#include "container/Array.hpp"
+#include "container/FlatHashMap.hpp"
+#include "math/Bounds.hpp"
+#include "util/ConceptTraits.hpp"
+
+#include <memory>
+
+namespace stardazed {
+namespace physics {
+
+
+// A broadphase tracks the world bounds of proxies and finds the pairs of
+// proxies whose bounds intersect, touching bounds count as intersecting.
+// Each proxy carries a user value, pairs are reported as user values with
+// userA < userB, every intersecting pair exactly once, in no particular order.
+
+using BroadphaseProxy = uint32;
+
+struct BroadphasePair {
+	uint32 userA, userB;
+};
+
+
+class Broadphase {
+public:
+	virtual ~Broadphase() = default;
+
+	virtual BroadphaseProxy createProxy(const math::Bounds& bounds, uint32 userValue) = 0;
+	virtual void destroyProxy(BroadphaseProxy) = 0;
+	virtual void moveProxy(BroadphaseProxy, const math::Bounds& bounds) = 0;
+
+	// replaces the contents of outPairs
+	virtual void findPairs(Array<BroadphasePair>& outPairs) = 0;
+	virtual uint32 proxyCount() const = 0;
+};
+
+
+enum class BroadphaseType {
+	SweepAndPrune,
+	AABBTree,
+	SpatialHashGrid
+};
+
+std::unique_ptr<Broadphase> makeBroadphase(BroadphaseType, memory::Allocator&);
+
+
+// Keeps the endpoints of all proxies sorted on each axis. Bounds change little
+// from frame to frame so re-sorting with an insertion sort costs about O(n)
+// plus the number of endpoints that pass each other. Each pass starts or ends
+// an overlap on one axis, so the set of intersecting pairs is updated during
+// the sort and findPairs only copies it out. After many proxies were created
+// at once the endpoints are fully sorted and the pairs found with a sweep of
+// the x-axis instead.
+
+class SweepAndPrune final : public Broadphase {
+	struct Proxy {
+		math::Bounds bounds;
+		uint32 userValue;
+		uint32 activeIndex; // position in the active list during a sweep
+		bool8 alive;
+	};
+
+	// proxy index in bits 0-30, bit 31 set for a max endpoint
+	struct Endpoint {
+		float value;
+		uint32 proxyAndKind;
+	};
+
+	static constexpr uint32 maxEndpointBit = 0x80000000u;
+
+	Array<Proxy> proxies_;
+	Array<BroadphaseProxy> freeProxies_;
+	Array<BroadphaseProxy> destroyedProxies_; // reusable after their endpoints and pairs are removed
+	Array<Endpoint> endpoints_[3];
+	Array<uint32> active_;
+	FlatHashMap<uint64, BroadphasePair> pairs_; // keyed by the proxy indexes, lower one in the high bits
+	Array<uint64> deadPairs_;
+	uint32 unsortedEndpoints_ = 0;
+
+	// endpoints with equal values order min before max so touching bounds overlap
+	static bool endpointLess(const Endpoint& a, const Endpoint& b) {
+		return a.value < b.value || (a.value == b.value && (a.proxyAndKind & maxEndpointBit) < (b.proxyAndKind & maxEndpointBit));
+	}
+
+	void refreshEndpoints();
+	void sortAxis(uint32 axis);
+	void sweepPairs();
+
+public:
+	explicit SweepAndPrune(memory::Allocator&);
+	SD_NOCOPYORMOVE_CLASS(SweepAndPrune)
+
+	BroadphaseProxy createProxy(const math::Bounds& bounds, uint32 userValue) final;
+	void destroyProxy(BroadphaseProxy) final;
+	void moveProxy(BroadphaseProxy, const math::Bounds& bounds) final;
+
+	void findPairs(Array<BroadphasePair>& outPairs) final;
+	uint32 proxyCount() const final { return proxies_.count() - freeProxies_.count() - destroyedProxies_.count(); }
+};
+
+
+// Dynamic bounding volume tree. Leaves store bounds enlarged by a margin, so
+// a proxy that moves a little stays in its leaf and only proxies that leave
+// their fat bounds are reinserted. Inserts pick the sibling that adds the
+// least surface area and the tree is kept height-balanced with rotations.
+
+class AABBTree final : public Broadphase {
+	static constexpr uint32 nullNode = 0xffffffffu;
+
+	struct Node {
+		math::Bounds fatBounds;
+		uint32 parent;   // also links the free list
+		uint32 child1, child2; // nullNode for leaves
+		int32 height;    // leaf = 0, free node = -1
+		BroadphaseProxy proxy;
+	};
+
+	struct Proxy {
+		math::Bounds bounds;
+		uint32 userValue;
+		uint32 leaf; // nullNode for a free proxy
+	};
+
+	float margin_;
+	Array<Node> nodes_;
+	uint32 root_ = nullNode, freeNode_ = nullNode;
+	Array<Proxy> proxies_;
+	Array<BroadphaseProxy> freeProxies_;
+	Array<uint32> stack_;
+
+	uint32 allocateNode();
+	void freeNode(uint32 node);
+	void insertLeaf(uint32 leaf);
+	void removeLeaf(uint32 leaf);
+	uint32 balance(uint32 node);
+	void refitAncestors(uint32 node);
+
+public:
+	static constexpr float defaultMargin = 0.1f;
+
+	explicit AABBTree(memory::Allocator&, float margin = defaultMargin);
+	SD_NOCOPYORMOVE_CLASS(AABBTree)
+
+	BroadphaseProxy createProxy(const math::Bounds& bounds, uint32 userValue) final;
+	void destroyProxy(BroadphaseProxy) final;
+	void moveProxy(BroadphaseProxy, const math::Bounds& bounds) final;
+
+	void findPairs(Array<BroadphasePair>& outPairs) final;
+	uint32 proxyCount() const final { return proxies_.count() - freeProxies_.count(); }
+
+	// -- tree statistics
+	int32 height() const { return root_ == nullNode ? 0 : nodes_[root_].height; }
+};
+
+
+// Uniform grid of cubic cells, the integer cell coordinates are hashed into
+// a bucket table so the grid is unbounded and only occupied cells take up
+// memory. The grid is rebuilt from scratch by findPairs or rebuild with a
+// counting sort of all (proxy, cell) entries by bucket, O(n) and linear in
+// memory. Works best for many objects of about the cell size, like particles
+// or crowds. Proxies covering more than maxCellsPerProxy cells are kept out
+// of the grid and tested against everything.
+//
+// The queries can be used by gameplay code and see the bounds as they were
+// at the last rebuild. They replace the contents of outUserValues.
+
+class SpatialHashGrid final : public Broadphase {
+	struct CellCoord {
+		int32 x, y, z;
+
+		bool operator==(const CellCoord& other) const {
+			return x == other.x && y == other.y && z == other.z;
+		}
+	};
+
+	struct CellRange {
+		CellCoord min, max; // inclusive, empty if max.x < min.x
+	};
+
+	struct Proxy {
+		math::Bounds bounds;
+		uint32 userValue;
+		bool8 alive;
+	};
+
+	struct Entry {
+		math::Bounds bounds;
+		CellCoord cell;
+		BroadphaseProxy proxy;
+		uint32 userValue;
+	};
+
+	float cellSize_, invCellSize_;
+	Array<Proxy> proxies_;
+	Array<BroadphaseProxy> freeProxies_;
+	Array<CellRange> ranges_;
+	Array<uint32> entryBuckets_;
+	Array<uint32> bucketStarts_; // bucketCount + 1 offsets into entries_
+	Array<uint32> bucketFill_;
+	Array<Entry> entries_;
+	Array<Entry> oversized_;
+	uint32 bucketMask_ = 0;
+
+	CellCoord cellOf(const math::Vec3& point) const;
+	CellRange cellRange(const math::Bounds& bounds) const;
+	uint32 bucketOf(const CellCoord& cell) const;
+
+	template <typename Fn>
+	void forEachEntry(const math::Bounds& area, Fn&& fn) const;
+
+public:
+	static constexpr float defaultCellSize = 2.f;
+	static constexpr uint32 maxCellsPerProxy = 64;
+
+	explicit SpatialHashGrid(memory::Allocator&, float cellSize = defaultCellSize);
+	SD_NOCOPYORMOVE_CLASS(SpatialHashGrid)
+
+	BroadphaseProxy createProxy(const math::Bounds& bounds, uint32 userValue) final;
+	void destroyProxy(BroadphaseProxy) final;
+	void moveProxy(BroadphaseProxy, const math::Bounds& bounds) final;
+
+	void findPairs(Array<BroadphasePair>& outPairs) final;
+	uint32 proxyCount() const final { return proxies_.count() - freeProxies_.count(); }
+
+	float cellSize() const { return cellSize_; }
+	void setCellSize(float cellSize);
+	void rebuild();
+
+	// -- queries
+	void queryBounds(const math::Bounds& area, Array<uint32>& outUserValues) const;
+	void queryRadius(const math::Vec3& center, float radius, Array<uint32>& outUserValues) const;
+};
+
+
+} // ns physics
+} // ns stardazed
+
+#endif
@@ -5,23 +5,54 @@
 
 #include "physics/Collider.hpp"
 #include "system/Logging.hpp"
+#include "runtime/Profiler.hpp"
+#include "math/Stream.hpp"
+
+#include <cmath>
 
 namespace stardazed {
 namespace physics {
 
 
-ColliderManager::ColliderManager(memory::Allocator& allocator, scene::TransformManager& tm, RigidBodyManager& rbm)
-: transformMgr_(tm)
+namespace {
+
+	// Transforms an AABB by an affine matrix (J. Arvo, Graphics Gems 1990): the
+	// center is transformed as a point, each world extent is the sum of the
+	// local extents weighted by the absolute matrix elements of that row.
+	math::Bounds transformBounds(const math::Bounds& local, const math::Mat4& mat) {
+		auto center = local.center();
+		auto extents = local.extents();
+		const auto* m = mat.data; // column-major
+		math::Vec3 worldCenter, worldExtents;
+
+		for (int row = 0; row < 3; ++row) {
+			worldCenter[row] = m[row] * center.x + m[4 + row] * center.y + m[8 + row] * center.z + m[12 + row];
+			worldExtents[row] = std::abs(m[row]) * extents.x + std::abs(m[4 + row]) * extents.y + std::abs(m[8 + row]) * extents.z;
+		}
+
+		return math::Bounds::fromMinAndMax(worldCenter - worldExtents, worldCenter + worldExtents);
+	}
+
+} // anonymous namespace
+
+
+ColliderManager::ColliderManager(memory::Allocator& allocator, scene::TransformManager& tm, RigidBodyManager& rbm, BroadphaseType broadphaseType)
+: allocator_{ allocator, memory::MemoryTag::ColliderManager }
+, transformMgr_(tm)
 , rigidBodyMgr_(rbm)
-, instanceData_(allocator, 1024)
-{
-	instanceData_.extend(); // instance 0 is a null-instance
-}
+, instanceData_(allocator_, 1024)
+, entityMap_(allocator_)
+, broadphase_(makeBroadphase(broadphaseType, allocator_))
+, pairs_(allocator_, 256)
+, dirtyColliders_(allocator_, 256)
+, dirtyTransforms_(allocator_, 256)
+{}
 
 
 auto ColliderManager::create(scene::Entity entity, ColliderType type, const math::Vec3& localCenter, const math::Vec3& size) -> Instance {
-	instanceData_.extend();
-	uint index = instanceData_.count() - 1;
+	Instance h;
+	instanceData_.create(h);
+	uint index = instanceData_.indexOf(h);
 	
 	auto trans = transformMgr_.forEntity(entity);
 	auto rigid = rigidBodyMgr_.forEntity(entity); // may be a null-instance
@@ -31,104 +62,219 @@ auto ColliderManager::create(scene::Entity entity, ColliderType type, const math
 	*(basePtr<InstField::Type>() + index) = type;
 	*(basePtr<InstField::Transform>() + index) = trans;
 	*(basePtr<InstField::RigidBody>() + index) = rigid;
-	*(basePtr<InstField::LocalBounds>() + index) = Bounds::fromCenterAndSize(localCenter, size);
-	*(basePtr<InstField::WorldBounds>() + index) = Bounds::fromCenterAndSize(localCenter + transformMgr_.position(trans), size * transformMgr_.scale(trans));
+	auto localBounds = Bounds::fromCenterAndSize(localCenter, size);
+	*(basePtr<InstField::LocalBounds>() + index) = localBounds;
+	auto worldBounds = boundsUpdateMode_ == BoundsUpdateMode::WorldMatrix
+		? transformBounds(localBounds, transformMgr_.modelMatrix(trans))
+		: Bounds::fromCenterAndSize(localCenter + transformMgr_.position(trans), size * transformMgr_.scale(trans));
+	*(basePtr<InstField::WorldBounds>() + index) = worldBounds;
+	*(basePtr<InstField::Proxy>() + index) = broadphase_->createProxy(worldBounds, h.ref);
+	*(basePtr<InstField::BoundsChangeCount>() + index) = transformMgr_.changeCountAtIndex(transformMgr_.denseIndex(trans));
 	
-	Instance h { index };
 	entityMap_.insert(entity, h);
 	return h;
+}
 
+
+void ColliderManager::destroy(scene::Entity entity) {
+	auto h = forEntity(entity);
+	if (h) {
+		broadphase_->destroyProxy(*(basePtr<InstField::Proxy>() + instanceData_.indexOf(h)));
+		entityMap_.remove(entity);
+		instanceData_.destroy(h);
+	}
+}
+
+
+auto ColliderManager::forEntity(scene::Entity ent) -> Instance {
+	Instance* result = entityMap_.find(ent);
+	return result ? *result : Instance{0};
 }
 
 
 void ColliderManager::linkToRigidBody(Instance h, RigidBodyManager::Instance rb) {
-	*(basePtr<InstField::RigidBody>() + h.ref) = rb;
+	*(basePtr<InstField::RigidBody>() + instanceData_.indexOf(h)) = rb;
 }
 
 
 RigidBodyManager::Instance ColliderManager::linkedRigidBody(Instance h) const {
-	return *(basePtr<InstField::RigidBody>() + h.ref);
+	return *(basePtr<InstField::RigidBody>() + instanceData_.indexOf(h));
 }
 
 
-void ColliderManager::resolveAll() {
+void ColliderManager::setBoundsUpdateMode(BoundsUpdateMode mode) {
+	if (mode != boundsUpdateMode_) {
+		boundsUpdateMode_ = mode;
+		allBoundsStale_ = true;
+	}
+}
+
+
+void ColliderManager::updateWorldBounds() {
 	auto collCount = instanceData_.count();
+	auto transformBase = basePtr<InstField::Transform>();
+	auto boundsChangeCountBase = basePtr<InstField::BoundsChangeCount>();
+
+	// -- collect the colliders whose transform changed and their transform indexes
+	dirtyColliders_.clear();
+	dirtyTransforms_.clear();
+
+	for (auto index = 1u; index < collCount; ++index) {
+		auto trans = transformBase[index];
+		if (! transformMgr_.valid(trans))
+			continue;
+
+		auto transIndex = transformMgr_.denseIndex(trans);
+		auto changeCount = transformMgr_.changeCountAtIndex(transIndex);
+		if (allBoundsStale_ || changeCount != boundsChangeCountBase[index]) {
+			boundsChangeCountBase[index] = changeCount;
+			dirtyColliders_.append(index);
+			dirtyTransforms_.append(transIndex);
+		}
+	}
+	allBoundsStale_ = false;
+
+	// -- recompute their bounds from the transform arrays
+	auto dirtyCount = dirtyColliders_.count();
+	auto colliders = dirtyColliders_.elementsBasePtr();
+	auto transforms = dirtyTransforms_.elementsBasePtr();
+	auto localBoundsBase = basePtr<InstField::LocalBounds>();
+	auto worldBoundsBase = basePtr<InstField::WorldBounds>();
+
+	if (boundsUpdateMode_ == BoundsUpdateMode::WorldMatrix) {
+		auto worldMatrices = transformMgr_.worldMatrices();
+		jobs::parallelFor(jobSystem_, 0, dirtyCount, 1024, [=](uint32 first, uint32 last) {
+			for (auto d = first; d < last; ++d) {
+				worldBoundsBase[colliders[d]] = transformBounds(localBoundsBase[colliders[d]], worldMatrices[transforms[d]]);
+			}
+		});
+	}
+	else {
+		auto positions = transformMgr_.positions();
+		auto scales = transformMgr_.scales();
+		jobs::parallelFor(jobSystem_, 0, dirtyCount, 1024, [=](uint32 first, uint32 last) {
+			// gather into batches for the Stream kernels, world center = local center
+			// + position, world size = local size * scale
+			constexpr uint32 batchSize = 64;
+			math::Vec3 centers[batchSize], sizes[batchSize], batchPositions[batchSize], batchScales[batchSize];
+
+			for (auto batchFirst = first; batchFirst < last; batchFirst += batchSize) {
+				auto batchCount = math::min(batchSize, last - batchFirst);
+
+				for (uint32 b = 0; b < batchCount; ++b) {
+					auto d = batchFirst + b;
+					const auto& localBounds = localBoundsBase[colliders[d]];
+					centers[b] = localBounds.center();
+					sizes[b] = localBounds.size();
+					batchPositions[b] = positions[transforms[d]];
+					batchScales[b] = scales[transforms[d]];
+				}
+
+				math::Vec3Stream centerStream { centers, batchCount }, sizeStream { sizes, batchCount };
+				math::add(centerStream, math::ConstVec3Stream{ batchPositions, batchCount }, centerStream);
+				math::mul(sizeStream, math::ConstVec3Stream{ batchScales, batchCount }, sizeStream);
+
+				for (uint32 b = 0; b < batchCount; ++b) {
+					worldBoundsBase[colliders[batchFirst + b]] = math::Bounds::fromCenterAndSize(centers[b], sizes[b]);
+				}
+			}
+		});
+	}
+
+	// the broadphase is not thread-safe
+	auto proxyBase = basePtr<InstField::Proxy>();
+	for (auto d = 0u; d < dirtyCount; ++d) {
+		broadphase_->moveProxy(proxyBase[colliders[d]], worldBoundsBase[colliders[d]]);
+	}
+}
+
+
+void ColliderManager::resolveCollision(uint32 indexA, uint32 indexB) {
 	const float bounciness = 0.3;
-	
+
 	using namespace math;
+
+	auto rigidBodyA = *(basePtr<InstField::RigidBody>() + indexA);
+	auto transA = *(basePtr<InstField::Transform>() + indexA);
+	auto& posA = transformMgr_.position(transA);
+
+	const auto& collABounds = *(basePtr<InstField::WorldBounds>() + indexA);
+	const auto& collBBounds = *(basePtr<InstField::WorldBounds>() + indexB);
+
+	auto previousPosition = rigidBodyMgr_.previousPosition(rigidBodyA);
+
+	auto dA = posA - previousPosition;
+	auto tEnter = (collBBounds.min() - (collABounds.max() - dA)) / dA;
+	auto tLeave = (collBBounds.max() - (collABounds.min() - dA)) / dA;
 	
+	// find bounce time and normal of closest plane
+	float tEnterMin = 100.0;
+	math::Vec3 bounceNormal, bounceFriction;
+	
+	if (! nearEqual(0.0f, dA.x)) {
+		auto tEnterX = min(tEnter.x, tLeave.x);
+		if (tEnterX > 0.0f) {
+			tEnterMin = min(tEnter.x, tLeave.x);
+			bounceNormal = normalize(Vec3{ -dA.x, 0, 0 });
+			bounceFriction = { bounciness, 1, 1 };
+		}
+	}
+	if (! nearEqual(0.0f, dA.y)) {
+		auto tEnterY = min(tEnter.y, tLeave.y);
+		if (tEnterY > 0 && tEnterY < tEnterMin) {
+			tEnterMin = tEnterY;
+			bounceNormal = normalize(Vec3{ 0, -dA.y, 0 });
+			bounceFriction = { 1, bounciness, 1 };
+		}
+	}
+	if (! nearEqual(0.0f, dA.z)) {
+		auto tEnterZ = min(tEnter.z, tLeave.z);
+		if (tEnterZ > 0 && tEnterZ < tEnterMin) {
+			tEnterMin = tEnterZ;
+			bounceNormal = normalize(Vec3{ 0, 0, -dA.z });
+			bounceFriction = { 1, 1, bounciness };
+		}
+	}
+	
+	// --
+	if (tEnterMin > 0.0f && tEnterMin < 100.0f) {
+		auto previousVelocity = rigidBodyMgr_.previousVelocity(rigidBodyA);
+		auto dVA = rigidBodyMgr_.velocity(rigidBodyA) - previousVelocity;
+
+		auto velAtHit = previousVelocity + (dVA * tEnterMin);
+		auto velOut = reflect(velAtHit, bounceNormal) * bounceFriction;
+		
+		auto clippedPos = previousPosition + (dA * tEnterMin);
+		transformMgr_.setPosition(transA, clippedPos + ((1.0 - tEnterMin) * reflect(dA, bounceNormal) * bounciness));
+		rigidBodyMgr_.setMomentum(rigidBodyA, velOut * rigidBodyMgr_.mass(rigidBodyA).value);
+	}
+}
+
+
+void ColliderManager::resolveAll() {
+	SD_PROFILE_SCOPE("ColliderManager::resolveAll");
+
+	updateWorldBounds();
+	broadphase_->findPairs(pairs_);
+
 	auto linkedBodyBase = basePtr<InstField::RigidBody>();
-	auto localBoundsBase = basePtr<InstField::LocalBounds>();
-	auto worldBoundsBase = basePtr<InstField::WorldBounds>();
 	auto transformBase = basePtr<InstField::Transform>();
-	
-	// fun little n^2 algo for my couple of colliders
-	for (auto loopIndex = 1u; loopIndex < collCount; ++loopIndex) {
-		auto rigidBodyA = linkedBodyBase[loopIndex];
-		if (! rigidBodyA)
+
+	for (auto p = 0u; p < pairs_.count(); ++p) {
+		auto indexA = instanceData_.indexOf(Instance{ pairs_[p].userA });
+		auto indexB = instanceData_.indexOf(Instance{ pairs_[p].userB });
+
+		// colliders of destroyed entities keep their last bounds until they are destroyed
+		if (! (transformMgr_.valid(transformBase[indexA]) && transformMgr_.valid(transformBase[indexB]))) {
 			continue;
-		
-		auto transA = transformBase[loopIndex];
-		auto& posA = transformMgr_.position(transA);
+		}
 
-		auto& localABounds = localBoundsBase[loopIndex];
-		Bounds collABounds = Bounds::fromCenterAndSize(localABounds.center() + posA, localABounds.size() * transformMgr_.scale(transA));
-		
-		for (auto subIndex = 1u; subIndex < collCount; ++subIndex) {
-			if (subIndex == loopIndex)
-				continue;
-
-			auto& collBBounds = worldBoundsBase[subIndex];
-			
-			if (collABounds.intersects(collBBounds)) {
-				auto previousPosition = rigidBodyMgr_.previousPosition(rigidBodyA);
-
-				auto dA = posA - previousPosition;
-				auto tEnter = (collBBounds.min() - (collABounds.max() - dA)) / dA;
-				auto tLeave = (collBBounds.max() - (collABounds.min() - dA)) / dA;
-				
-				// find bounce time and normal of closest plane
-				float tEnterMin = 100.0;
-				math::Vec3 bounceNormal, bounceFriction;
-				
-				if (! nearEqual(0.0f, dA.x)) {
-					auto tEnterX = min(tEnter.x, tLeave.x);
-					if (tEnterX > 0.0f) {
-						tEnterMin = min(tEnter.x, tLeave.x);
-						bounceNormal = normalize(Vec3{ -dA.x, 0, 0 });
-						bounceFriction = { bounciness, 1, 1 };
-					}
-				}
-				if (! nearEqual(0.0f, dA.y)) {
-					auto tEnterY = min(tEnter.y, tLeave.y);
-					if (tEnterY > 0 && tEnterY < tEnterMin) {
-						tEnterMin = tEnterY;
-						bounceNormal = normalize(Vec3{ 0, -dA.y, 0 });
-						bounceFriction = { 1, bounciness, 1 };
-					}
-				}
-				if (! nearEqual(0.0f, dA.z)) {
-					auto tEnterZ = min(tEnter.z, tLeave.z);
-					if (tEnterZ > 0 && tEnterZ < tEnterMin) {
-						tEnterMin = tEnterZ;
-						bounceNormal = normalize(Vec3{ 0, 0, -dA.z });
-						bounceFriction = { 1, 1, bounciness };
-					}
-				}
-				
-				// --
-				if (tEnterMin > 0.0f && tEnterMin < 100.0f) {
-					auto previousVelocity = rigidBodyMgr_.previousVelocity(rigidBodyA);
-					auto dVA = rigidBodyMgr_.velocity(rigidBodyA) - previousVelocity;
-
-					auto velAtHit = previousVelocity + (dVA * tEnterMin);
-					auto velOut = reflect(velAtHit, bounceNormal) * bounceFriction;
-					
-					auto clippedPos = previousPosition + (dA * tEnterMin);
-					transformMgr_.setPosition(transA, clippedPos + ((1.0 - tEnterMin) * reflect(dA, bounceNormal) * bounciness));
-					rigidBodyMgr_.setMomentum(rigidBodyA, velOut * rigidBodyMgr_.mass(rigidBodyA).value);
-				}
-			}
+		// the linked body may have been destroyed before its collider
+		if (rigidBodyMgr_.valid(linkedBodyBase[indexA])) {
+			resolveCollision(indexA, indexB);
+		}
+		if (rigidBodyMgr_.valid(linkedBodyBase[indexB])) {
+			resolveCollision(indexB, indexA);
 		}
 	}
 }
@@ -8,11 +8,14 @@
 
 #include "system/Config.hpp"
 #include "math/Bounds.hpp"
-#include "container/MultiArrayBuffer.hpp"
-#include "container/HashMap.hpp"
+#include "scene/ComponentStore.hpp"
+#include "scene/EntityMap.hpp"
+#include "memory/TrackingAllocator.hpp"
 #include "physics/RigidBody.hpp"
+#include "physics/Broadphase.hpp"
 #include "scene/Transform.hpp"
 #include "scene/Entity.hpp"
+#include "runtime/Jobs.hpp"
 
 namespace stardazed {
 namespace physics {
@@ -24,20 +27,29 @@ enum class ColliderType : uint8 {
 };
 
 
+enum class BoundsUpdateMode {
+	PositionAndScale, // local bounds offset by the position and sized by the scale of the transform
+	WorldMatrix       // local bounds transformed by the world matrix, includes rotation and parents
+};
+
+
 class ColliderManager {
 public:
 	using Instance = scene::Instance<ColliderManager>;
 
 private:
+	memory::TrackingAllocator allocator_;
 	scene::TransformManager& transformMgr_;
 	RigidBodyManager& rigidBodyMgr_;
 
-	container::MultiArrayBuffer<
+	scene::ComponentStore<ColliderManager,
 		ColliderType,
 		scene::TransformManager::Instance,
 		RigidBodyManager::Instance,
 		math::Bounds, // localBounds
-		math::Bounds  // worldBounds
+		math::Bounds, // worldBounds
+		BroadphaseProxy,
+		uint32 // transform change count the world bounds were computed at
 	> instanceData_;
 	
 	enum class InstField {
@@ -45,24 +57,53 @@ private:
 		Transform,
 		RigidBody,
 		LocalBounds,
-		WorldBounds
+		WorldBounds,
+		Proxy,
+		BoundsChangeCount
 	};
 	
-	HashMap<scene::Entity, Instance> entityMap_;
+	scene::EntityMap<Instance> entityMap_;
+	std::unique_ptr<Broadphase> broadphase_;
+	Array<BroadphasePair> pairs_;
+	Array<uint32> dirtyColliders_, dirtyTransforms_;
+	BoundsUpdateMode boundsUpdateMode_ = BoundsUpdateMode::PositionAndScale;
+	bool allBoundsStale_ = false;
+	jobs::JobSystem* jobSystem_ = nullptr;
 	
 	template <InstField F>
 	auto basePtr() const {
 		return instanceData_.template elementsBasePtr<(uint)F>();
 	}
 
+	void resolveCollision(uint32 indexA, uint32 indexB);
+
 public:
-	ColliderManager(memory::Allocator&, scene::TransformManager&, RigidBodyManager&);
+	ColliderManager(memory::Allocator&, scene::TransformManager&, RigidBodyManager&, BroadphaseType = BroadphaseType::SweepAndPrune);
 	
 	Instance create(scene::Entity, ColliderType, const math::Vec3& localCenter, const math::Vec3& size);
+	void destroy(scene::Entity);
+
+	Instance forEntity(scene::Entity);
+	bool valid(Instance h) const { return instanceData_.valid(h); }
+	uint32 count() const { return instanceData_.liveCount(); }
 
 	void linkToRigidBody(Instance, RigidBodyManager::Instance);
 	RigidBodyManager::Instance linkedRigidBody(Instance) const;
-	
+	const math::Bounds& worldBounds(Instance h) const { return *(basePtr<InstField::WorldBounds>() + instanceData_.indexOf(h)); }
+
+	// Recomputes the world bounds of colliders whose transform changed since
+	// their last bounds update and moves their broadphase proxies. WorldMatrix
+	// mode uses the world matrices of the last TransformManager::updateMatrices() call.
+	BoundsUpdateMode boundsUpdateMode() const { return boundsUpdateMode_; }
+	void setBoundsUpdateMode(BoundsUpdateMode);
+	void updateWorldBounds();
+
+	// with a job system set, the bounds are recomputed in parallel chunks
+	jobs::JobSystem* jobSystem() const { return jobSystem_; }
+	void setJobSystem(jobs::JobSystem* jobSystem) { jobSystem_ = jobSystem; }
+
+	// updates the world bounds, then resolves collisions for
+	// the candidate pairs found by the broadphase
 	void resolveAll();
 };
 
@@ -5,24 +5,26 @@
 
 #include "physics/RigidBody.hpp"
 #include "system/Logging.hpp"
-#include "physics/RK4Integrator.hpp"
+#include "runtime/Profiler.hpp"
+#include "math/Stream.hpp"
 
 namespace stardazed {
 namespace physics {
 
 
 RigidBodyManager::RigidBodyManager(memory::Allocator& allocator, scene::TransformManager& transform)
-: transformMgr_(transform)
-, instanceData_{ allocator, 1024 }
-, entityMap_{ allocator, 1024 }
+: allocator_{ allocator, memory::MemoryTag::RigidBodyManager }
+, transformMgr_(transform)
+, instanceData_{ allocator_, 1024 }
+, entityMap_{ allocator_, 1024 }
 {
-	instanceData_.extend();  // index 0 is a null-instance
 }
 
 
 auto RigidBodyManager::create(scene::Entity entity, const RigidBodyDescriptor& desc) -> Instance {
-	instanceData_.extend();
-	uint index = instanceData_.count() - 1;
+	Instance h;
+	instanceData_.create(h);
+	uint index = instanceData_.indexOf(h);
 	
 	// FIXME: calc average drag intersection area, right now A = 1
 	
@@ -35,12 +37,20 @@ auto RigidBodyManager::create(scene::Entity entity, const RigidBodyDescriptor& d
 	*(basePtr<InstField::Transform>() + index) = trans;
 	*(basePtr<InstField::PreviousPosition>() + index) = transformMgr_.position(trans);
 
-	Instance h { index };
 	entityMap_.insert(entity, h);
 	return h;
 }
 
 
+void RigidBodyManager::destroy(scene::Entity entity) {
+	auto h = forEntity(entity);
+	if (h) {
+		entityMap_.remove(entity);
+		instanceData_.destroy(h);
+	}
+}
+
+
 auto RigidBodyManager::forEntity(scene::Entity ent) -> Instance {
 	Instance* result = entityMap_.find(ent);
 	return result ? *result : Instance{0};
@@ -54,6 +64,20 @@ void RigidBodyManager::addExternalForce(Instance h, const math::Vec3& force) {
 
 
 void RigidBodyManager::integrateAll(Time dt) {
+	SD_PROFILE_SCOPE("RigidBodyManager::integrateAll");
+
+	// 256 instances span a whole number of cache lines in every column and the
+	// columns start on a cache line, so chunks never share a line. Index 0 is the
+	// null-instance, the range starts at 0 to keep the chunks aligned.
+	constexpr uint32 integrateGrainSize = 256;
+
+	jobs::parallelFor(jobSystem_, 0, instanceData_.count(), integrateGrainSize, [this, dt](uint32 first, uint32 last) {
+		integrateRange(dt, math::max(first, 1u), last);
+	});
+}
+
+
+void RigidBodyManager::integrateRange(Time dt, uint32 first, uint32 last) {
 	auto massBase = basePtr<InstField::Mass>();
 	auto dragAreaBase = basePtr<InstField::DragArea>();
 	auto propertiesBase = basePtr<InstField::Properties>();
@@ -63,50 +87,80 @@ void RigidBodyManager::integrateAll(Time dt) {
 	auto velocityBase = basePtr<InstField::Velocity>();
 	auto previousPositionBase = basePtr<InstField::PreviousPosition>();
 	auto previousVelocityBase = basePtr<InstField::PreviousVelocity>();
+	auto positions = transformMgr_.positions();
 
 	using namespace math;
 
 	const Vec3 gravityAccel { 0, -9.80665, 0 };
-	EulerIntegrator integrator;
-
-	for (uint rbi=1, rbCount = instanceData_.count(); rbi < rbCount; ++rbi) {
-		auto properties = propertiesBase[rbi];
-		auto dragArea = dragAreaBase[rbi].value;
-		auto transform = transformBase[rbi];
-		auto totalForce = externalForceBase[rbi];
-		auto velocity = velocityBase[rbi];
-
-		// -- apply constant forces: gravity and air drag
-		if (properties.gravity)
-			totalForce += gravityAccel * massBase[rbi].value;
-		
-		if (! (nearEqual(0.0f, lengthSquared(velocity)) || nearEqual(0.0f, dragArea)) ) {
-			// 1.2f is air drag (rho) at 15C at 0m elevation
-			auto signedDirection = math::sign(velocity);
-			totalForce -= .5f * 1.2f * dragArea * velocity * velocity * signedDirection;
+	const float dtf = static_cast<float>(dt);
+
+	// Bodies are processed in batches: the forces and the gather of positions
+	// through the transform indexes are per body, the Euler step itself
+	// (see EulerIntegrator) runs over the batch with the Stream kernels.
+	// Bodies whose transform was destroyed are stepped but not written back.
+	constexpr uint32 batchSize = 64;
+	constexpr uint32 noTransform = 0;
+	uint32 transformIndexes[batchSize];
+	Vec3 totalForces[batchSize];
+	Vec3 newPositions[batchSize];
+	float inverseMasses[batchSize];
+
+	for (uint32 batchFirst = first; batchFirst < last; batchFirst += batchSize) {
+		auto batchCount = math::min(batchSize, last - batchFirst);
+
+		for (uint32 b = 0; b < batchCount; ++b) {
+			auto rbi = batchFirst + b;
+			auto properties = propertiesBase[rbi];
+			auto dragArea = dragAreaBase[rbi].value;
+			auto transform = transformBase[rbi];
+			auto transformIndex = transformMgr_.valid(transform) ? transformMgr_.denseIndex(transform) : noTransform;
+			auto totalForce = externalForceBase[rbi];
+			auto velocity = velocityBase[rbi];
+
+			// -- apply constant forces: gravity and air drag
+			if (properties.gravity)
+				totalForce += gravityAccel * massBase[rbi].value;
 			
-			// -- apply friction
-			totalForce -= .5f * momentumBase[rbi];
+			if (! (nearEqual(0.0f, lengthSquared(velocity)) || nearEqual(0.0f, dragArea)) ) {
+				// 1.2f is air drag (rho) at 15C at 0m elevation
+				auto signedDirection = math::sign(velocity);
+				totalForce -= .5f * 1.2f * dragArea * velocity * velocity * signedDirection;
+				
+				// -- apply friction
+				totalForce -= .5f * momentumBase[rbi];
+			}
+
+			// -- keep old position and velocity (for collision tests)
+			transformIndexes[b] = transformIndex;
+			totalForces[b] = totalForce;
+			inverseMasses[b] = massBase[rbi].reciprocal;
+			if (transformIndex != noTransform)
+				previousPositionBase[rbi] = positions[transformIndex];
+			previousVelocityBase[rbi] = velocity;
+		}
+
+		// -- Euler step: position += velocity * dt, momentum += force * dt, velocity = momentum / mass
+		Vec3Stream momenta { momentumBase + batchFirst, batchCount };
+		Vec3Stream velocities { velocityBase + batchFirst, batchCount };
+		Vec3Stream newPos { newPositions, batchCount };
+
+		addScaled(ConstVec3Stream{ previousPositionBase + batchFirst, batchCount }, velocities, dtf, newPos);
+		addScaled(momenta, ConstVec3Stream{ totalForces, batchCount }, dtf, momenta);
+		scale(momenta, ConstFloatStream{ inverseMasses, batchCount }, velocities);
+
+		uint32 writeCount = 0;
+		for (uint32 b = 0; b < batchCount; ++b) {
+			if (transformIndexes[b] != noTransform) {
+				transformIndexes[writeCount] = transformIndexes[b];
+				newPositions[writeCount] = newPositions[b];
+				++writeCount;
+			}
 		}
-		
-		// -- update position and keep old position (for collision tests)
-		RK4State state {
-			massBase[rbi].reciprocal,
-			transformMgr_.position(transform),
-			momentumBase[rbi],
-			velocity
-		};
-
-		previousPositionBase[rbi] = state.position;
-		previousVelocityBase[rbi] = velocity;
-		integrator.integrate(state, totalForce, dt);
-		transformMgr_.setPosition(transform, state.position);
-		momentumBase[rbi] = state.momentum;
-		velocityBase[rbi] = state.velocity;
+		transformMgr_.setPositions(transformIndexes, newPositions, writeCount);
 	}
 	
-	// clear all external forces (FIXME: make this a MAB method)
-	memset(basePtr<InstField::ExternalForce>(), 0, instanceData_.count() * sizeof(Vec3));
+	// clear the external forces of this range (FIXME: make this a MAB method)
+	memset(externalForceBase + first, 0, (last - first) * sizeof(Vec3));
 }
 
 
@@ -8,10 +8,12 @@
 
 #include "system/Config.hpp"
 #include "system/Time.hpp"
-#include "container/MultiArrayBuffer.hpp"
-#include "container/HashMap.hpp"
+#include "scene/ComponentStore.hpp"
+#include "scene/EntityMap.hpp"
+#include "memory/TrackingAllocator.hpp"
 #include "scene/Entity.hpp"
 #include "scene/Transform.hpp"
+#include "runtime/Jobs.hpp"
 
 namespace stardazed {
 namespace physics {
@@ -28,6 +30,7 @@ public:
 	using Instance = scene::Instance<RigidBodyManager>;
 
 private:
+	memory::TrackingAllocator allocator_;
 	scene::TransformManager& transformMgr_;
 	
 	struct Properties {
@@ -40,7 +43,7 @@ private:
 		float reciprocal;
 	};
 
-	container::MultiArrayBuffer<
+	scene::AlignedComponentStore<RigidBodyManager,
 		// packed flags and properties
 		Properties,
 
@@ -63,7 +66,8 @@ private:
 		math::Vec3  // previousVelocity
 	> instanceData_;
 	
-	HashMap<scene::Entity, Instance> entityMap_;
+	scene::EntityMap<Instance> entityMap_;
+	jobs::JobSystem* jobSystem_ = nullptr;
 	
 	enum class InstField : uint {
 		Properties,
@@ -90,15 +94,20 @@ private:
 	
 	template <InstField F>
 	auto instancePtr(Instance h) const {
-		return basePtr<F>() + h.ref;
+		return basePtr<F>() + instanceData_.indexOf(h);
 	}
 
+	void integrateRange(Time dt, uint32 first, uint32 last);
+
 public:
 	RigidBodyManager(memory::Allocator&, scene::TransformManager&);
 
 	Instance create(scene::Entity, const RigidBodyDescriptor&);
+	void destroy(scene::Entity);
 	
 	Instance forEntity(scene::Entity);
+	bool valid(Instance h) const { return instanceData_.valid(h); }
+	uint32 count() const { return instanceData_.liveCount(); }
 
 	// -- single instance access
 	const Properties properties(Instance h) const { return *(instancePtr<InstField::Properties>(h)); }
@@ -124,6 +133,12 @@ public:
 
 	// -- integration
 	void integrateAll(Time dt);
+
+	// With a job system set, integrateAll() integrates chunks of bodies in
+	// parallel. Chunk boundaries fall on cache line boundaries of all instance
+	// columns and the results are identical to those of the serial path.
+	jobs::JobSystem* jobSystem() const { return jobSystem_; }
+	void setJobSystem(jobs::JobSystem* jobSystem) { jobSystem_ = jobSystem; }
 };
 
 
@@ -5,7 +5,9 @@
 
 #include "system/Config.hpp"
 
-#if SD_PLATFORM_OSX
+#if SD_RENDER_ENGINE_NULL
+#	include "render/null/NullRenderContext.hpp"
+#elif SD_PLATFORM_OSX
 #	if SD_RENDER_ENGINE_OPENGL
 #		include "render/opengl/mac_GLRenderContext.hpp"
 #	else
@@ -40,6 +40,7 @@ constexpr size32 indexElementTypeSizeBytes(IndexElementType iet) {
 		case IndexElementType::UInt16: return sizeof32<uint16>();
 		case IndexElementType::UInt32: return sizeof32<uint32>();
 	}
+	return 0;
 }
 
 
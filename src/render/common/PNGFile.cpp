@@ -7,10 +7,11 @@
 // ------------------------------------------------------------------
 
 #include "render/common/PNGFile.hpp"
-#include "system/Logging.hpp"
+#include "runtime/Profiler.hpp"
 
 #include "zlib.h"
 #include <cstdlib>
+#include <arpa/inet.h>
 
 namespace stardazed {
 namespace render {
@@ -85,13 +86,17 @@ enum LineFilter : uint8 {
 };
 
 
+static constexpr uint8 pngSignature[8] = { 0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A };
+
+
 PNGFile::PNGFile(const std::string& resourcePath) {
+	SD_PROFILE_SCOPE("PNGFile::load");
 	fs::FileReadStream png{ resourcePath };
 	
-	uint8 realSig[8], expectedSig[8] = { 0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A };
+	uint8 realSig[8];
 	png.readBytes(realSig, 8);
 	// FIXME: this should not be an assert
-	assert(std::equal(realSig, realSig + 8, expectedSig, expectedSig + 8));
+	assert(std::equal(realSig, realSig + 8, pngSignature, pngSignature + 8));
 	
 	while (png.ok())
 		nextChunk(png);
@@ -117,10 +122,6 @@ void PNGFile::nextChunk(fs::FileReadStream& png) {
 			png.readValue(&ihdr);
 			width_ = ntohl(ihdr.Width);
 			height_ = ntohl(ihdr.Height);
-			sd::log("Width : ", width_);
-			sd::log("Height: ", height_);
-			sd::log("Kind  : ", (int)ihdr.ColorType);
-			
 			// FIXME: instead of a bunch of asserts, just return an empty image + logging
 			assert(ihdr.BitDepth == 8);
 			assert((ColorType)ihdr.ColorType != ColorType::Palette);
@@ -6,6 +6,8 @@
 #include "render/common/PixelBuffer.hpp"
 #include "render/common/PNGFile.hpp"
 #include "filesystem/FileSystem.hpp"
+#include "memory/TrackingAllocator.hpp"
+#include "runtime/Profiler.hpp"
 
 #include "jpgd.h"
 
@@ -15,6 +17,12 @@ namespace stardazed {
 namespace render {
 
 
+PixelDataPtr allocPixelData(size32 sizeBytes) {
+	auto& allocator = memory::trackedAllocator(memory::MemoryTag::TextureLoaders);
+	return PixelDataPtr{ static_cast<uint8*>(allocator.alloc(sizeBytes)), { &allocator } };
+}
+
+
 std::unique_ptr<PixelDataProvider> makePixelDataProviderForPath(const std::string& resourcePath) {
 	fs::Path path { resourcePath };
 	auto extension = path.extension(); // guaranteed lowercase
@@ -77,6 +85,7 @@ constexpr uint32 fourCharCode(char a, char b, char c, char d) {
 
 
 DDSDataProvider::DDSDataProvider(const std::string& resourcePath) {
+	SD_PROFILE_SCOPE("DDSDataProvider::load");
 	DDS_HEADER header;
 	fs::FileReadStream file{ resourcePath };
 
@@ -89,7 +98,7 @@ DDSDataProvider::DDSDataProvider(const std::string& resourcePath) {
 	size32 dataSize = header.dwPitchOrLinearSize;
 	if (header.dwMipMapCount > 1)
 		dataSize *= 2;
-	data_ = std::make_unique<uint8[]>(dataSize);
+	data_ = allocPixelData(dataSize);
 	file.readBytes(data_.get(), dataSize);
 
 	switch (header.ddspf.dwFourCC) {
@@ -167,6 +176,7 @@ struct BITMAPINFOHEADER {
 
 
 BMPDataProvider::BMPDataProvider(const std::string& resourcePath) {
+	SD_PROFILE_SCOPE("BMPDataProvider::load");
 	fs::FileReadStream file{ resourcePath };
 
 	BITMAPFILEHEADER header;
@@ -191,18 +201,16 @@ BMPDataProvider::BMPDataProvider(const std::string& resourcePath) {
 	width_ = info.biWidth;
 	height_ = info.biHeight;
 	
-	auto dataSize   = dataSizeBytesForPixelFormatAndDimensions(format_, { width_, height_ });
-	auto dataOffset = header.bfOffBits;
-	auto headerSize = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER);
-	
-	assert(dataOffset == headerSize);
+	auto dataSize = dataSizeBytesForPixelFormatAndDimensions(format_, { width_, height_ });
+	assert(header.bfOffBits == sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER));
 	
-	data_ = std::make_unique<uint8[]>(dataSize);
+	data_ = allocPixelData(dataSize);
 	file.readBytes(data_.get(), dataSize);
 }
 
 
 PixelBuffer BMPDataProvider::pixelBufferForLevel(uint32 level) const {
+	SD_UNUSED_PARAM(level)
 	assert(level == 0);
 	
 	PixelBuffer image {};
@@ -221,6 +229,7 @@ PixelBuffer BMPDataProvider::pixelBufferForLevel(uint32 level) const {
 //
 
 PNGDataProvider::PNGDataProvider(const std::string& resourcePath) {
+	SD_PROFILE_SCOPE("PNGDataProvider::load");
 	PNGFile png(resourcePath);
 	
 	width_ = png.width();
@@ -238,7 +247,7 @@ PNGDataProvider::PNGDataProvider(const std::string& resourcePath) {
 	}
 	
 	auto size = png.rowBytes() * png.height();
-	data_ = std::make_unique<uint8[]>(size);
+	data_ = allocPixelData(size);
 	auto dataPtr = data_.get();
 
 	for (auto row = 0u; row < png.height(); ++row) {
@@ -250,6 +259,7 @@ PNGDataProvider::PNGDataProvider(const std::string& resourcePath) {
 
 
 PixelBuffer PNGDataProvider::pixelBufferForLevel(uint32 level) const {
+	SD_UNUSED_PARAM(level)
 	assert(level == 0);
 	
 	PixelBuffer image {};
@@ -296,6 +306,7 @@ static_assert(sizeof(TGAFileHeader) == 18, "TGA header struct must be packed");
 
 
 TGADataProvider::TGADataProvider(const std::string& resourcePath) {
+	SD_PROFILE_SCOPE("TGADataProvider::load");
 	fs::FileReadStream file{ resourcePath };
 	
 	TGAFileHeader header;
@@ -330,12 +341,13 @@ TGADataProvider::TGADataProvider(const std::string& resourcePath) {
 	}
 	
 	auto dataSize = dataSizeBytesForPixelFormatAndDimensions(format_, { width_, height_ });
-	data_ = std::make_unique<uint8[]>(dataSize);
+	data_ = allocPixelData(dataSize);
 	file.readBytes(data_.get(), dataSize);
 }
 
 
 PixelBuffer TGADataProvider::pixelBufferForLevel(uint32 level) const {
+	SD_UNUSED_PARAM(level)
 	assert(level == 0);
 	
 	PixelBuffer image {};
@@ -380,19 +392,21 @@ public:
 
 
 JPGDataProvider::JPGDataProvider(const std::string& resourcePath) {
+	SD_PROFILE_SCOPE("JPGDataProvider::load");
 	SDJPGDecoderStream stream{ resourcePath };
 	
 	int width, height, components;
 	auto data = jpgd::decompress_jpeg_image_from_stream(&stream, &width, &height, &components, 4);
 
-	// adopt the data pointer for auto-disposal
-	data_.reset(data);
+	// adopt the data pointer for auto-disposal, jpgd allocates it with malloc
+	data_ = PixelDataPtr{ data, { &memory::SystemAllocator::sharedInstance() } };
 	width_ = width;
 	height_ = height;
 }
 
 
 PixelBuffer JPGDataProvider::pixelBufferForLevel(uint32 level) const {
+	SD_UNUSED_PARAM(level)
 	assert(level == 0);
 	
 	PixelBuffer image {};
@@ -8,6 +8,7 @@
 
 #include "system/Config.hpp"
 #include "math/Algorithm.hpp"
+#include "memory/Allocator.hpp"
 #include "render/common/PixelFormat.hpp"
 
 #include <memory>
@@ -67,6 +68,12 @@ struct PixelBuffer {
 };
 
 
+// Pixel data read by the texture loaders, allocated under MemoryTag::TextureLoaders
+using PixelDataPtr = std::unique_ptr<uint8[], memory::AllocatorDeleter>;
+
+PixelDataPtr allocPixelData(size32 sizeBytes);
+
+
 class PixelDataProvider {
 public:
 	virtual ~PixelDataProvider() = default;
@@ -82,7 +89,7 @@ public:
 class DDSDataProvider : public PixelDataProvider {
 	uint32 width_, height_, mipMaps_;
 	PixelFormat format_;
-	std::unique_ptr<uint8[]> data_;
+	PixelDataPtr data_;
 	
 	size32 dataSizeForLevel(uint32 level) const;
 	
@@ -100,7 +107,7 @@ public:
 class BMPDataProvider : public PixelDataProvider {
 	uint32 width_, height_;
 	PixelFormat format_;
-	std::unique_ptr<uint8[]> data_;
+	PixelDataPtr data_;
 	
 public:
 	BMPDataProvider(const std::string& resourcePath);
@@ -116,7 +123,7 @@ public:
 class PNGDataProvider : public PixelDataProvider {
 	uint32 width_, height_;
 	PixelFormat format_;
-	std::unique_ptr<uint8[]> data_;
+	PixelDataPtr data_;
 
 public:
 	PNGDataProvider(const std::string& resourcePath);
@@ -132,7 +139,7 @@ public:
 class TGADataProvider : public PixelDataProvider {
 	uint32 width_, height_;
 	PixelFormat format_;
-	std::unique_ptr<uint8[]> data_;
+	PixelDataPtr data_;
 	
 public:
 	TGADataProvider(const std::string& resourcePath);
@@ -147,12 +154,13 @@ public:
 
 class JPGDataProvider : public PixelDataProvider {
 	uint32 width_, height_;
-	std::unique_ptr<uint8[]> data_;
+	PixelDataPtr data_;
 
 public:
 	JPGDataProvider(const std::string& resourcePath);
 
-	PixelFormat format() const override { return PixelFormat::RGBA8; }
+	// ext/jpgd is built with DECODE_TO_BGRA
+	PixelFormat format() const override { return PixelFormat::BGRA8; }
 	PixelDimensions dim() const override { return { width_, height_ }; }
 	uint32 mipMapCount() const override { return 1; }
 	
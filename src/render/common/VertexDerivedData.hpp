@@ -27,8 +27,7 @@ template <typename VertIt, typename NormIt, typename FaceIt>
 // requires RandomAccessIterator{VertIt}, RandomAccessIterator{NormIt}, RandomAccessIterator{FaceIt}
 void calcVertexNormals(VertIt vertBegin, VertIt vertEnd, NormIt normBegin, NormIt normEnd, FaceIt faceBegin, FaceIt faceEnd) {
 	auto vertexCount = std::distance(vertBegin, vertEnd);
-	auto normalCount = std::distance(normBegin, normEnd);
-	assert(vertexCount <= normalCount);
+	assert(vertexCount <= std::distance(normBegin, normEnd));
 	
 	std::fill(normBegin, normEnd, math::Vec3{ 0, 0, 1 });
 	std::vector<float> usages(vertexCount);
@@ -69,6 +68,9 @@ void calcVertexTangents(
 	// by Eric Lengyel
 	
 	using namespace sd::math;
+	SD_UNUSED_PARAM(normEnd)
+	SD_UNUSED_PARAM(texEnd)
+	SD_UNUSED_PARAM(tanEnd)
 
 	auto vertexCount = std::distance(vertBegin, vertEnd);
 	assert(vertexCount <= std::distance(normBegin, normEnd));
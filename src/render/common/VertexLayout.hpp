@@ -138,6 +138,7 @@ constexpr size32 vertexFieldElementCount(VertexField vf) {
 		case VertexField::Floatx4:
 			return 4;
 	}
+	return 0;
 }
 
 
@@ -193,6 +194,7 @@ constexpr size32 vertexFieldElementSizeBytes(VertexField vf) {
 		case VertexField::Norm_SInt8x4:
 			return 1;
 	}
+	return 0;
 }
 
 
@@ -0,0 +1,27 @@
+// ------------------------------------------------------------------
+// render::NullRenderContext.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "render/null/NullRenderContext.hpp"
+
+namespace stardazed {
+namespace render {
+
+
+RenderContext::RenderContext(const RenderContextDescriptor& descriptor)
+: renderWidth_(static_cast<uint32>(descriptor.width))
+, renderHeight_(static_cast<uint32>(descriptor.height))
+{}
+
+
+RenderContext::~RenderContext() {}
+
+
+void RenderContext::swap() {
+	++frameCount_;
+}
+
+
+} // ns render
+} // ns stardazed
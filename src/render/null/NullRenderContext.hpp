@@ -0,0 +1,48 @@
+// ------------------------------------------------------------------
+// render::NullRenderContext - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_RENDER_NULLRENDERCONTEXT_H
+#define SD_RENDER_NULLRENDERCONTEXT_H
+
+#include "system/Config.hpp"
+#include "render/common/RenderContext.hpp"
+
+namespace stardazed {
+namespace render {
+
+
+// RenderContext for headless builds. There is no window and no GPU, swap
+// only counts frames, so the RunLoop and scene code work unchanged. GPU
+// resources cannot be created, code that needs them is not built headless.
+
+class RenderContext {
+public:
+	RenderContext(const RenderContextDescriptor&);
+	~RenderContext();
+	
+	void swap();
+	
+	bool isFullscreen() const { return false; }
+	// never blocks on a display, RunLoop limits the frame rate instead
+	bool usesVerticalSync() const { return false; }
+	
+	uint32 renderPixelWidth() const { return renderWidth_; }
+	uint32 renderPixelHeight() const { return renderHeight_; }
+
+	uint32 framePixelWidth() const { return renderWidth_; }
+	uint32 framePixelHeight() const { return renderHeight_; }
+
+	uint64 frameCount() const { return frameCount_; }
+
+private:
+	uint32 renderWidth_, renderHeight_;
+	uint64 frameCount_ = 0;
+};
+
+
+} // ns render
+} // ns stardazed
+
+#endif
@@ -0,0 +1,272 @@
+// ------------------------------------------------------------------
+// runtime::Jobs.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "runtime/Jobs.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace stardazed {
+namespace jobs {
+
+
+namespace {
+
+	constexpr uint32 cacheLineSize = 64;
+
+
+	// Chase-Lev work-stealing deque of fixed capacity, using the memory
+	// orderings of Le, Pop, Cohen and Zappa Nardelli (PPoPP 2013).
+	// push and pop may only be called by the owning worker, steal by anyone.
+	class WorkStealingDeque {
+		static constexpr int64 capacity = 4096;
+		static constexpr int64 indexMask = capacity - 1;
+
+		// top and bottom are written by different threads, keep them on separate lines
+		std::atomic<int64> top_ { 0 };
+		char padTop_[cacheLineSize - sizeof(std::atomic<int64>)];
+		std::atomic<int64> bottom_ { 0 };
+		char padBottom_[cacheLineSize - sizeof(std::atomic<int64>)];
+		std::atomic<Job*> buffer_[capacity];
+
+	public:
+		// returns false if the deque is full
+		bool push(Job* job) {
+			auto bottom = bottom_.load(std::memory_order_relaxed);
+			auto top = top_.load(std::memory_order_acquire);
+			if (bottom - top >= capacity)
+				return false;
+
+			buffer_[bottom & indexMask].store(job, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			bottom_.store(bottom + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+
+		Job* pop() {
+			auto bottom = bottom_.load(std::memory_order_relaxed) - 1;
+			bottom_.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			auto top = top_.load(std::memory_order_relaxed);
+
+			if (top > bottom) {
+				// empty
+				bottom_.store(bottom + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			auto job = buffer_[bottom & indexMask].load(std::memory_order_relaxed);
+			if (top == bottom) {
+				// last job, race the thieves for it
+				if (! top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+					job = nullptr;
+				}
+				bottom_.store(bottom + 1, std::memory_order_relaxed);
+			}
+			return job;
+		}
+
+
+		// returns nullptr if the deque is empty or another thread won the job
+		Job* steal() {
+			auto top = top_.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			auto bottom = bottom_.load(std::memory_order_acquire);
+
+			if (top >= bottom)
+				return nullptr;
+
+			auto job = buffer_[top & indexMask].load(std::memory_order_relaxed);
+			if (! top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return nullptr;
+			return job;
+		}
+	};
+
+
+	// set by the background workers only, each belongs to a single system
+	struct CurrentWorker {
+		const JobSystem* system;
+		uint32 index;
+	};
+
+	thread_local CurrentWorker currentWorker_s { nullptr, 0 };
+
+	constexpr uint32 noWorker = 0xffffffffu;
+
+
+	// idle workers retry this many times before going to sleep
+	constexpr uint32 idleSpinCount = 64;
+
+} // anonymous namespace
+
+
+struct JobSystem::Worker {
+	WorkStealingDeque deque;
+	std::thread thread;
+};
+
+
+struct JobSystem::Shared {
+	std::mutex sleepMutex;
+	std::condition_variable wakeCondition;
+	std::atomic<uint32> queuedJobs { 0 };
+	std::atomic<uint32> sleepingWorkers { 0 };
+	bool quit = false; // guarded by sleepMutex
+	std::thread::id creatorThread = std::this_thread::get_id(); // worker 0
+};
+
+
+JobSystem::JobSystem(uint32 workerCount)
+: workerCount_(workerCount > 0 ? workerCount : std::max(1u, std::thread::hardware_concurrency()))
+, workers_(new Worker[workerCount_])
+, shared_(new Shared())
+{
+	for (uint32 index = 1; index < workerCount_; ++index) {
+		workers_[index].thread = std::thread([this, index] { workerMain(index); });
+	}
+}
+
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(shared_->sleepMutex);
+		shared_->quit = true;
+	}
+	shared_->wakeCondition.notify_all();
+
+	for (uint32 index = 1; index < workerCount_; ++index) {
+		workers_[index].thread.join();
+	}
+}
+
+
+// The creating thread can be worker 0 of several systems at once, so unlike
+// the background workers it is recognized by its thread id.
+uint32 JobSystem::currentWorkerIndex() const {
+	if (currentWorker_s.system == this) {
+		return currentWorker_s.index;
+	}
+	if (std::this_thread::get_id() == shared_->creatorThread) {
+		return 0;
+	}
+	return noWorker;
+}
+
+
+Job* JobSystem::findJob(uint32 workerIndex) {
+	auto job = workers_[workerIndex].deque.pop();
+
+	for (uint32 offset = 1; job == nullptr && offset < workerCount_; ++offset) {
+		job = workers_[(workerIndex + offset) % workerCount_].deque.steal();
+	}
+
+	if (job) {
+		shared_->queuedJobs.fetch_sub(1);
+	}
+	return job;
+}
+
+
+void JobSystem::execute(const Job& job) {
+	// the job may be gone once the counter is decremented
+	auto counter = job.counter;
+	job.entry(job.context, job.first, job.last);
+	counter->pending.fetch_sub(1, std::memory_order_release);
+}
+
+
+void JobSystem::workerMain(uint32 workerIndex) {
+	currentWorker_s = { this, workerIndex };
+	auto& shared = *shared_;
+
+	for (;;) {
+		auto job = findJob(workerIndex);
+		for (uint32 spin = 0; job == nullptr && spin < idleSpinCount; ++spin) {
+			std::this_thread::yield();
+			job = findJob(workerIndex);
+		}
+
+		if (job) {
+			execute(*job);
+			continue;
+		}
+
+		// run() checks sleepingWorkers after queueing, we check queuedJobs after
+		// registering as a sleeper, so one of us sees the other
+		std::unique_lock<std::mutex> lock(shared.sleepMutex);
+		shared.sleepingWorkers.fetch_add(1);
+		shared.wakeCondition.wait(lock, [&shared] {
+			return shared.quit || shared.queuedJobs.load() > 0;
+		});
+		shared.sleepingWorkers.fetch_sub(1);
+
+		if (shared.quit)
+			break;
+	}
+}
+
+
+void JobSystem::run(Job* jobs, uint32 count, Counter& counter) {
+	counter.pending.fetch_add(count, std::memory_order_relaxed);
+	for (uint32 index = 0; index < count; ++index) {
+		jobs[index].counter = &counter;
+	}
+
+	auto workerIndex = currentWorkerIndex();
+	if (workerIndex == noWorker) {
+		for (uint32 index = 0; index < count; ++index) {
+			execute(jobs[index]);
+		}
+		return;
+	}
+
+	auto& shared = *shared_;
+	auto& deque = workers_[workerIndex].deque;
+	shared.queuedJobs.fetch_add(count);
+
+	for (uint32 index = 0; index < count; ++index) {
+		if (__builtin_expect(! deque.push(jobs + index), 0)) {
+			shared.queuedJobs.fetch_sub(1);
+			execute(jobs[index]);
+		}
+	}
+
+	if (shared.sleepingWorkers.load() > 0) {
+		{
+			std::lock_guard<std::mutex> lock(shared.sleepMutex);
+		}
+		shared.wakeCondition.notify_all();
+	}
+}
+
+
+void JobSystem::wait(const Counter& counter) {
+	auto workerIndex = currentWorkerIndex();
+
+	while (! counter.done()) {
+		if (workerIndex != noWorker) {
+			auto job = findJob(workerIndex);
+			if (job) {
+				execute(*job);
+				continue;
+			}
+		}
+		std::this_thread::yield();
+	}
+}
+
+
+JobSystem& defaultJobSystem() {
+	static JobSystem jobSystem_s;
+	return jobSystem_s;
+}
+
+
+} // ns jobs
+} // ns stardazed
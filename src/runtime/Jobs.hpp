@@ -0,0 +1,130 @@
+// ------------------------------------------------------------------
+// runtime::Jobs - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_RUNTIME_JOBS_H
+#define SD_RUNTIME_JOBS_H
+
+#include "system/Config.hpp"
+#include "util/ConceptTraits.hpp"
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+namespace stardazed {
+namespace jobs {
+
+
+// A job runs entry(context, first, last), usually over an index range of
+// some SoA arrays. Jobs do not own their context, the submitter keeps both
+// the jobs and their contexts alive until the job counter reaches zero.
+
+struct Counter {
+	std::atomic<uint32> pending { 0 };
+
+	bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+
+struct Job {
+	void (*entry)(void* context, uint32 first, uint32 last);
+	void* context;
+	uint32 first, last;
+	Counter* counter;
+};
+
+
+// Runs jobs on one worker per hardware thread. The thread that creates the
+// JobSystem is worker 0, the others are background threads. A thread can be
+// worker 0 of several systems. Every worker owns a Chase-Lev deque: it pushes
+// and pops jobs at the bottom, idle workers steal from the top of the other
+// deques.
+//
+// Dependencies are expressed with counters: run() adds the job count to the
+// counter, every finished job decrements it and wait() returns when it hits
+// zero. Waiting workers run other jobs in the meantime, so jobs can submit
+// and wait for jobs of their own. Threads that are not workers of the system
+// run their jobs inline in run().
+
+class JobSystem {
+	struct Worker;
+	struct Shared;
+
+	uint32 workerCount_;
+	std::unique_ptr<Worker[]> workers_;
+	std::unique_ptr<Shared> shared_;
+
+	uint32 currentWorkerIndex() const;
+	Job* findJob(uint32 workerIndex);
+	void execute(const Job&);
+	void workerMain(uint32 workerIndex);
+
+public:
+	// workerCount 0 uses one worker per hardware thread
+	explicit JobSystem(uint32 workerCount = 0);
+	~JobSystem();
+	SD_NOCOPYORMOVE_CLASS(JobSystem)
+
+	uint32 workerCount() const { return workerCount_; }
+
+	void run(Job* jobs, uint32 count, Counter& counter);
+	void wait(const Counter& counter);
+};
+
+
+// shared system for the engine, created on first use, which should be on
+// the main thread as the calling thread becomes worker 0
+JobSystem& defaultJobSystem();
+
+
+// Calls fn(first, last) for consecutive chunks of [begin, end) in parallel and
+// returns when all chunks are done. Chunk sizes are a multiple of grainSize,
+// the range is split in at most a few chunks per worker. With a null system
+// fn is called once for the whole range on the calling thread.
+
+constexpr uint32 maxParallelForJobs = 256;
+
+template <typename Fn>
+void parallelFor(JobSystem* system, uint32 begin, uint32 end, uint32 grainSize, Fn&& fn) {
+	assert(grainSize > 0);
+	if (begin >= end)
+		return;
+
+	auto count = end - begin;
+	if (system == nullptr || system->workerCount() == 1 || count <= grainSize) {
+		fn(begin, end);
+		return;
+	}
+
+	auto grains = (count + grainSize - 1) / grainSize;
+	auto maxJobs = system->workerCount() * 4;
+	if (maxJobs > maxParallelForJobs) {
+		maxJobs = maxParallelForJobs;
+	}
+	auto chunkSize = ((grains + maxJobs - 1) / maxJobs) * grainSize;
+
+	using FnType = std::remove_reference_t<Fn>;
+	auto entry = [](void* context, uint32 first, uint32 last) {
+		(*static_cast<FnType*>(context))(first, last);
+	};
+	auto context = const_cast<void*>(static_cast<const void*>(&fn));
+
+	Job jobs[maxParallelForJobs];
+	uint32 jobCount = 0;
+	Counter counter;
+	for (auto first = begin; first < end; first += chunkSize) {
+		auto last = (end - first > chunkSize) ? first + chunkSize : end;
+		jobs[jobCount++] = { entry, context, first, last, &counter };
+	}
+
+	system->run(jobs, jobCount, counter);
+	system->wait(counter);
+}
+
+
+} // ns jobs
+} // ns stardazed
+
+#endif
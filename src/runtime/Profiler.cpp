@@ -0,0 +1,222 @@
+// ------------------------------------------------------------------
+// runtime::Profiler.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "runtime/Profiler.hpp"
+#include "system/Logging.hpp"
+#include "math/Algorithm.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace stardazed {
+namespace profile {
+
+
+namespace {
+
+	thread_local void* threadEvents_s = nullptr;
+
+
+	bool sameName(const char* a, const char* b) {
+		return a == b || std::strcmp(a, b) == 0;
+	}
+
+
+	void appendJSONString(std::string& json, const char* str) {
+		json += '"';
+		for (; *str; ++str) {
+			auto c = *str;
+			if (c == '"' || c == '\\') {
+				json += '\\';
+				json += c;
+			}
+			else if (static_cast<uint8>(c) < 0x20) {
+				json += ' ';
+			}
+			else {
+				json += c;
+			}
+		}
+		json += '"';
+	}
+
+} // anonymous namespace
+
+
+constexpr uint32 Profiler::maxEventsPerThread;
+constexpr uint32 Profiler::maxReportRecords;
+constexpr uint32 Profiler::maxTraceEvents;
+
+
+Profiler::ThreadEvents::ThreadEvents(memory::Allocator& allocator, uint32 capacity, uint32 threadIndex)
+: events(allocator, capacity)
+, threadIndex(threadIndex)
+, pendingBegins(allocator, 32)
+{}
+
+
+Profiler::Profiler()
+: frameScopes_(memory::SystemAllocator::sharedInstance(), 64)
+, report_(memory::SystemAllocator::sharedInstance(), maxReportRecords)
+, trace_(memory::SystemAllocator::sharedInstance(), maxTraceEvents)
+{}
+
+
+Profiler& Profiler::sharedInstance() {
+	static Profiler profiler_s;
+	return profiler_s;
+}
+
+
+Profiler::ThreadEvents& Profiler::threadEvents() {
+	if (__builtin_expect(threadEvents_s == nullptr, 0)) {
+		std::lock_guard<std::mutex> lock(threadsMutex_);
+		auto index = static_cast<uint32>(threads_.size());
+		threads_.push_back(std::make_unique<ThreadEvents>(memory::SystemAllocator::sharedInstance(), maxEventsPerThread, index));
+		threadEvents_s = threads_.back().get();
+	}
+	return *static_cast<ThreadEvents*>(threadEvents_s);
+}
+
+
+void Profiler::beginScope(const char* name) {
+	auto& te = threadEvents();
+
+	// only record a begin if its end and the ends of all open scopes still fit,
+	// otherwise drop the whole scope so begins and ends stay paired
+	if (__builtin_expect(te.droppedScopes > 0 || te.events.count() + te.openScopes + 2 > te.events.capacity(), 0)) {
+		++te.droppedScopes;
+		return;
+	}
+
+	++te.openScopes;
+	te.events.append({ name, time::now(), EventType::Begin });
+}
+
+
+void Profiler::endScope(const char* name) {
+	auto& te = threadEvents();
+
+	if (__builtin_expect(te.droppedScopes > 0, 0)) {
+		--te.droppedScopes;
+		return;
+	}
+
+	assert(te.openScopes > 0);
+	--te.openScopes;
+	te.events.append({ name, time::now(), EventType::End });
+}
+
+
+void Profiler::accumulate(const char* name, Time duration) {
+	for (auto& scope : frameScopes_) {
+		if (sameName(scope.name, name)) {
+			++scope.calls;
+			scope.minTime = math::min(scope.minTime, duration);
+			scope.maxTime = math::max(scope.maxTime, duration);
+			scope.totalTime += duration;
+			return;
+		}
+	}
+
+	frameScopes_.append({ name, 1, duration, duration, duration });
+}
+
+
+void Profiler::endFrame() {
+	std::lock_guard<std::mutex> lock(threadsMutex_);
+
+	for (auto& thread : threads_) {
+		auto& te = *thread;
+
+		for (uint e = 0; e < te.events.count(); ++e) {
+			const auto& event = te.events[e];
+
+			// scopes that are still open at the end of a frame are timed in the frame they end
+			if (event.type == EventType::Begin) {
+				te.pendingBegins.append(event);
+			}
+			else if (te.pendingBegins.count() > 0) {
+				accumulate(event.name, event.time - te.pendingBegins.back().time);
+				te.pendingBegins.popBack();
+			}
+
+			if (trace_.full()) {
+				trace_.popFront();
+			}
+			trace_.append({ event.name, event.time, te.threadIndex, event.type });
+		}
+
+		te.events.clear();
+	}
+
+	for (const auto& scope : frameScopes_) {
+		if (report_.full()) {
+			report_.popFront();
+		}
+		report_.append({ frame_, scope.name, scope.calls, scope.minTime, scope.totalTime / scope.calls, scope.maxTime, scope.totalTime });
+	}
+	frameScopes_.clear();
+
+	++frame_;
+}
+
+
+void Profiler::clear() {
+	std::lock_guard<std::mutex> lock(threadsMutex_);
+
+	// open and dropped scope counts describe scopes that are still running, keep them
+	for (auto& thread : threads_) {
+		thread->events.clear();
+		thread->pendingBegins.clear();
+	}
+	frameScopes_.clear();
+	report_.clear();
+	trace_.clear();
+}
+
+
+std::string Profiler::traceJSON() const {
+	std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	// timestamps are in microseconds, relative to the oldest event
+	auto baseTime = trace_.empty() ? time::zero() : trace_.front().time;
+	char buf[96];
+
+	for (uint e = 0; e < trace_.count(); ++e) {
+		const auto& event = trace_[e];
+		if (e > 0) {
+			json += ',';
+		}
+		json += "\n{\"name\":";
+		appendJSONString(json, event.name);
+		snprintf(buf, sizeof(buf), ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}",
+				 event.type == EventType::Begin ? 'B' : 'E',
+				 time::asMicroseconds(event.time - baseTime),
+				 event.threadIndex);
+		json += buf;
+	}
+
+	json += "\n]}\n";
+	return json;
+}
+
+
+bool Profiler::writeTrace(const std::string& filePath) const {
+	auto file = fopen(filePath.c_str(), "w");
+	if (! file) {
+		log("Could not open ", filePath, " to write profiler trace");
+		return false;
+	}
+
+	auto json = traceJSON();
+	auto written = fwrite(json.data(), 1, json.size(), file);
+	fclose(file);
+	return written == json.size();
+}
+
+
+} // ns profile
+} // ns stardazed
@@ -0,0 +1,164 @@
+// ------------------------------------------------------------------
+// runtime::Profiler - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_RUNTIME_PROFILER_H
+#define SD_RUNTIME_PROFILER_H
+
+#include "system/Config.hpp"
+#include "system/Time.hpp"
+#include "container/Array.hpp"
+#include "container/RingBuffer.hpp"
+#include "util/ConceptTraits.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace stardazed {
+namespace profile {
+
+
+enum class EventType : uint8 {
+	Begin,
+	End
+};
+
+
+struct ProfileEvent {
+	const char* name;
+	Time time;
+	EventType type;
+};
+
+
+struct TraceEvent {
+	const char* name;
+	Time time;
+	uint32 threadIndex;
+	EventType type;
+};
+
+
+// timings of all scopes with the same name that ended in a frame, on any thread
+struct ScopeFrameRecord {
+	uint32 frame;
+	const char* name;
+	uint32 calls;
+	Time minTime, avgTime, maxTime, totalTime;
+};
+
+
+// Records named CPU scopes as begin/end events. Every thread writes to its own
+// ring buffer without taking locks, only the first scope on a thread takes a
+// lock to register its buffer. endFrame() collects the events of all threads
+// into per-frame min/avg/max timings per scope name and into the trace that
+// is exported as Chrome trace_event JSON (load it in chrome://tracing).
+//
+// endFrame() and the report functions are to be called from the main thread
+// while no other thread is recording, such as between RunLoop frames when
+// the job system has no work. Scope names must be string literals or
+// otherwise outlive the profiler. Recording is off until setEnabled(true).
+
+class Profiler {
+	struct ThreadEvents {
+		container::RingBuffer<ProfileEvent> events;
+		uint32 threadIndex;
+		uint32 openScopes = 0;    // recorded begins that await their end
+		uint32 droppedScopes = 0; // nesting depth of begins dropped on overflow
+		container::Array<ProfileEvent> pendingBegins; // used by endFrame()
+
+		ThreadEvents(memory::Allocator&, uint32 capacity, uint32 threadIndex);
+	};
+
+	struct ScopeAccumulator {
+		const char* name;
+		uint32 calls;
+		Time minTime, maxTime, totalTime;
+	};
+
+	std::atomic<bool> enabled_ { false };
+	std::mutex threadsMutex_;
+	std::vector<std::unique_ptr<ThreadEvents>> threads_;
+
+	container::Array<ScopeAccumulator> frameScopes_;
+	container::RingBuffer<ScopeFrameRecord> report_;
+	container::RingBuffer<TraceEvent> trace_;
+	uint32 frame_ = 0;
+
+	Profiler();
+
+	ThreadEvents& threadEvents();
+	void accumulate(const char* name, Time duration);
+
+public:
+	static constexpr uint32 maxEventsPerThread = 16384;
+	static constexpr uint32 maxReportRecords = 600 * 32;
+	static constexpr uint32 maxTraceEvents = 1 << 17;
+
+	static Profiler& sharedInstance();
+	SD_NOCOPYORMOVE_CLASS(Profiler)
+
+	bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+	void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+
+	// -- recording, use SD_PROFILE_SCOPE instead of calling these directly
+	void beginScope(const char* name);
+	void endScope(const char* name);
+
+	// -- collection and reports, main thread only
+	void endFrame();
+	uint32 frame() const { return frame_; }
+	// drops all recorded events, the report and the trace
+	void clear();
+
+	const container::RingBuffer<ScopeFrameRecord>& report() const { return report_; }
+	std::string traceJSON() const;
+	bool writeTrace(const std::string& filePath) const;
+};
+
+
+class ProfileScope {
+	const char* name_;
+	bool active_;
+
+public:
+	explicit ProfileScope(const char* name)
+	: name_(name)
+	, active_(Profiler::sharedInstance().enabled())
+	{
+		if (__builtin_expect(active_, 0)) {
+			Profiler::sharedInstance().beginScope(name_);
+		}
+	}
+
+	~ProfileScope() {
+		if (__builtin_expect(active_, 0)) {
+			Profiler::sharedInstance().endScope(name_);
+		}
+	}
+
+	SD_NOCOPYORMOVE_CLASS(ProfileScope)
+};
+
+
+} // ns profile
+} // ns stardazed
+
+
+// Times the rest of the enclosing block under name. Compiles to nothing
+// when SD_PROFILER is 0.
+
+#define SD_PROFILE_CONCAT_IMPL(a, b) a##b
+#define SD_PROFILE_CONCAT(a, b) SD_PROFILE_CONCAT_IMPL(a, b)
+
+#if SD_PROFILER
+#	define SD_PROFILE_SCOPE(name) ::stardazed::profile::ProfileScope SD_PROFILE_CONCAT(sdProfileScope_, __LINE__) { name }
+#else
+#	define SD_PROFILE_SCOPE(name)
+#endif
+
+#endif
@@ -6,7 +6,14 @@
 #include "runtime/RunLoop.hpp"
 #include "system/Application.hpp"
 #include "system/Logging.hpp"
+#include "memory/TrackingAllocator.hpp"
 #include "io/input.hpp"
+#include "scene/Transform.hpp"
+#include "scene/RenderSnapshot.hpp"
+#include "runtime/Jobs.hpp"
+#include "runtime/Profiler.hpp"
+
+#include <cmath>
 
 #include <thread>
 
@@ -14,9 +21,13 @@ namespace stardazed {
 
 
 RunLoop::RunLoop()
+: frameAlloc_(&memory::defaultFrameAllocator())
 {}
 
 
+RunLoop::~RunLoop() = default;
+
+
 void RunLoop::setSceneController(SceneController& ctl) {
 	controller_ = &ctl;
 }
@@ -27,9 +38,130 @@ void RunLoop::setRenderContext(render::RenderContext& rc) {
 }
 
 
+void RunLoop::setFrameAllocator(memory::FrameAllocator& fa) {
+	frameAlloc_ = &fa;
+}
+
+
+void RunLoop::setMinFrameTime(Time minFrameTime) {
+	assert(minFrameTime >= 0);
+	minFrameTime_ = minFrameTime;
+}
+
+
+void RunLoop::setVariableTimestep() {
+	timestepMode_ = TimestepMode::Variable;
+	interpolationAlpha_ = 1;
+}
+
+
+void RunLoop::setFixedTimestep(double tickRate, uint32 maxSubsteps) {
+	assert(tickRate > 0);
+	assert(maxSubsteps > 0);
+
+	timestepMode_ = TimestepMode::Fixed;
+	tickDuration_ = time::hertz(tickRate);
+	maxSubsteps_ = maxSubsteps;
+	accumulator_ = time::zero();
+}
+
+
+void RunLoop::setInterpolatedTransforms(scene::TransformManager* transforms) {
+	interpolatedTransforms_ = transforms;
+	if (interpolatedTransforms_) {
+		// start out with a valid current state
+		interpolatedTransforms_->captureTickState();
+	}
+}
+
+
+void RunLoop::setPipelined(bool pipelined, jobs::JobSystem* jobSystem) {
+	pipelined_ = pipelined;
+	jobSystem_ = jobSystem;
+	renderSnapshotValid_ = false;
+
+	if (pipelined && ! snapshots_[0]) {
+		auto& allocator = memory::SystemAllocator::sharedInstance();
+		snapshots_[0] = std::make_unique<scene::RenderSnapshot>(allocator);
+		snapshots_[1] = std::make_unique<scene::RenderSnapshot>(allocator);
+	}
+}
+
+
+void RunLoop::simulateFrame(Time frameTime) {
+	SD_PROFILE_SCOPE("RunLoop::simulate");
+
+	if (timestepMode_ == TimestepMode::Fixed) {
+		accumulator_ += frameTime;
+
+		uint32 substeps = 0;
+		while (accumulator_ >= tickDuration_ && substeps < maxSubsteps_) {
+			controller_->simulationStep(tickDuration_);
+			if (interpolatedTransforms_) {
+				interpolatedTransforms_->captureTickState();
+			}
+			accumulator_ -= tickDuration_;
+			++substeps;
+		}
+
+		// too far behind, drop the whole ticks we had no time for
+		if (accumulator_ >= tickDuration_) {
+			accumulator_ = std::fmod(accumulator_, tickDuration_);
+		}
+		interpolationAlpha_ = static_cast<float>(accumulator_ / tickDuration_);
+	}
+	else {
+		controller_->simulationStep(frameTime);
+	}
+}
+
+
+void RunLoop::simulateAndCapture(Time frameTime) {
+	simulateFrame(frameTime);
+
+	auto& snapshot = *snapshots_[renderSnapshotIndex_ ^ 1];
+	snapshot.clear();
+	snapshot.setFrameTiming(frameTime, interpolationAlpha_);
+
+	SD_PROFILE_SCOPE("RunLoop::captureRenderState");
+	controller_->captureRenderState(snapshot);
+}
+
+
+void RunLoop::runPipelinedFrame(Time frameTime) {
+	jobs::Counter simulated;
+	jobs::Job simulation {
+		[](void* context, uint32, uint32) {
+			auto self = static_cast<RunLoop*>(context);
+			self->simulateAndCapture(self->pipelinedFrameTime_);
+		},
+		this, 0, 0, nullptr
+	};
+	pipelinedFrameTime_ = frameTime;
+
+	if (jobSystem_) {
+		jobSystem_->run(&simulation, 1, simulated);
+	}
+	else {
+		simulateAndCapture(frameTime);
+	}
+
+	if (renderSnapshotValid_) {
+		SD_PROFILE_SCOPE("RunLoop::render");
+		controller_->renderSnapshot(*snapshots_[renderSnapshotIndex_]);
+	}
+
+	if (jobSystem_) {
+		SD_PROFILE_SCOPE("RunLoop::waitForSimulation");
+		jobSystem_->wait(simulated);
+	}
+
+	renderSnapshotIndex_ ^= 1;
+	renderSnapshotValid_ = true;
+}
+
+
 void RunLoop::mainLoop() {
-	assert(renderCtx_);
-	
 	if (runState_ != RunLoopState::Idle)
 		return;
 	runState_ = RunLoopState::Running;
@@ -37,12 +169,15 @@ void RunLoop::mainLoop() {
 	// -- set time base
 	lastFrameTime_ = time::now();
 	globalTime_ = 0;
+	accumulator_ = time::zero();
+	renderSnapshotValid_ = false;
 	
 	while (! Application::shouldQuit()) {
 		auto frameStartTime = time::now();
 		auto timeSinceLastFrameStart = frameStartTime - lastFrameTime_;
 		lastFrameTime_ = frameStartTime;
 
+		frameAlloc_->nextFrame();
 		io::update();
 		
 		if (Application::isActive()) {
@@ -53,16 +188,32 @@ void RunLoop::mainLoop() {
 			}
 			globalTime_ += timeSinceLastFrameStart;
 			
-			if (controller_) {
-				controller_->simulationStep(timeSinceLastFrameStart);
-				controller_->renderFrame(timeSinceLastFrameStart);
-			}
+			{
+				SD_PROFILE_SCOPE("RunLoop::frame");
+
+				if (controller_) {
+					if (pipelined_) {
+						runPipelinedFrame(timeSinceLastFrameStart);
+					}
+					else {
+						simulateFrame(timeSinceLastFrameStart);
+
+						SD_PROFILE_SCOPE("RunLoop::render");
+						controller_->renderFrame(timeSinceLastFrameStart, interpolationAlpha_);
+					}
+				}
 
-			renderCtx_->swap();
+				if (renderCtx_) {
+					SD_PROFILE_SCOPE("RunLoop::swap");
+					renderCtx_->swap();
+				}
+			}
+			memory::MemoryTracker::sharedInstance().endFrame();
+			profile::Profiler::sharedInstance().endFrame();
 			
 			auto totalFrameTime = time::now() - frameStartTime;
 			
-			if (! renderCtx_->usesVerticalSync()) {
+			if (! renderCtx_ || ! renderCtx_->usesVerticalSync()) {
 				auto sleepDuration = minFrameTime_ - totalFrameTime;
 				
 				if (sleepDuration > 0) {
@@ -80,6 +231,30 @@ void RunLoop::mainLoop() {
 }
 
 
+Time RunLoop::runTicks(uint32 tickCount) {
+	assert(controller_);
+	auto startTime = time::now();
+
+	for (uint32 tick = 0; tick < tickCount; ++tick) {
+		frameAlloc_->nextFrame();
+
+		{
+			SD_PROFILE_SCOPE("RunLoop::tick");
+			controller_->simulationStep(tickDuration_);
+			if (interpolatedTransforms_) {
+				interpolatedTransforms_->captureTickState();
+			}
+		}
+		globalTime_ += tickDuration_;
+
+		memory::MemoryTracker::sharedInstance().endFrame();
+		profile::Profiler::sharedInstance().endFrame();
+	}
+
+	return time::now() - startTime;
+}
+
+
 void RunLoop::start() {
 	if (runState_ != RunLoopState::Idle)
 		return;
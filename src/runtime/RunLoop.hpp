@@ -9,9 +9,15 @@
 #include "system/Config.hpp"
 #include "system/Time.hpp"
 #include "render/RenderContext.hpp"
+#include "memory/FrameAllocator.hpp"
+
+#include <memory>
 
 namespace stardazed {
 
+namespace scene { class TransformManager; class RenderSnapshot; }
+namespace jobs { class JobSystem; }
+
 
 enum class RunLoopState {
 	Idle,
@@ -19,12 +25,27 @@ enum class RunLoopState {
 };
 
 
+enum class TimestepMode {
+	Variable, // one simulation step per frame with the frame's duration
+	Fixed     // zero or more simulation steps of a fixed duration per frame
+};
+
+
 struct SceneController {
 	virtual ~SceneController() {}
 
-	virtual void renderFrame(Time) = 0;
+	// alpha is the fraction of a tick that has passed since the last
+	// simulation step in Fixed timestep mode and 1 in Variable mode
+	virtual void renderFrame(Time dt, float /*alpha*/) { renderFrame(dt); }
+	virtual void renderFrame(Time) {}
 	virtual void simulationStep(Time) = 0;
 
+	// -- pipelined mode, replaces renderFrame
+	// called after the simulation steps of a frame, on the simulation side
+	virtual void captureRenderState(scene::RenderSnapshot&) {}
+	// called on the main thread with the snapshot of the previous frame
+	virtual void renderSnapshot(const scene::RenderSnapshot&) {}
+
 	virtual void resume() {}
 	virtual void suspend() {}
 	
@@ -36,23 +57,83 @@ struct SceneController {
 class RunLoop {
 	SceneController* controller_ = nullptr;
 	render::RenderContext* renderCtx_ = nullptr;
+	memory::FrameAllocator* frameAlloc_;
 	
 	Time maxFrameTime_ = time::hertz(4);
-	Time minFrameTime_ = time::hertz(120); // only relevant in non-vsync context
+	Time minFrameTime_ = time::hertz(120); // only relevant in non-vsync or headless context
 	Time lastFrameTime_ = time::zero();
 	Time globalTime_ = time::zero();
 	
 	RunLoopState runState_ = RunLoopState::Idle;
+
+	TimestepMode timestepMode_ = TimestepMode::Variable;
+	Time tickDuration_ = time::hertz(60);
+	uint32 maxSubsteps_ = 8;
+	Time accumulator_ = time::zero();
+	float interpolationAlpha_ = 1;
+	scene::TransformManager* interpolatedTransforms_ = nullptr;
+
+	bool pipelined_ = false;
+	jobs::JobSystem* jobSystem_ = nullptr;
+	std::unique_ptr<scene::RenderSnapshot> snapshots_[2];
+	uint32 renderSnapshotIndex_ = 0;
+	bool renderSnapshotValid_ = false;
+	Time pipelinedFrameTime_ = time::zero();
+
+	void simulateFrame(Time frameTime);
+	void simulateAndCapture(Time frameTime);
+	void runPipelinedFrame(Time frameTime);
 	
 public:
 	RunLoop();
+	~RunLoop();
 	
 	SceneController* sceneController() { return controller_; }
 	void setSceneController(SceneController&);
 	
+	// the render context is optional, without one frames are not presented
 	void setRenderContext(render::RenderContext&);
 	
+	// the frame allocator is advanced at the start of every frame
+	memory::FrameAllocator& frameAllocator() { return *frameAlloc_; }
+	void setFrameAllocator(memory::FrameAllocator&);
+	
 	void mainLoop();
+
+	// Runs tickCount simulation steps of tickDuration back to back on the
+	// calling thread, without input, rendering or frame rate limiting, and
+	// returns the wall clock time it took. Meant for batch simulation and
+	// throughput tests.
+	Time runTicks(uint32 tickCount);
+
+	// frames shorter than this are padded with sleep if the render context
+	// does not use vsync or there is none, 0 does not limit the frame rate
+	Time minFrameTime() const { return minFrameTime_; }
+	void setMinFrameTime(Time minFrameTime);
+
+	// -- simulation timing
+	// In Fixed mode simulationStep is called with tickDuration for every whole
+	// tick of accumulated frame time, at most maxSubsteps times per frame. Time
+	// beyond that is dropped, the simulation then runs slower than real time.
+	TimestepMode timestepMode() const { return timestepMode_; }
+	void setVariableTimestep();
+	void setFixedTimestep(double tickRate, uint32 maxSubsteps = 8);
+
+	Time tickDuration() const { return tickDuration_; }
+	float interpolationAlpha() const { return interpolationAlpha_; }
+
+	// In Fixed mode the transforms' tick state is captured after every simulation
+	// step, renderFrame can then use their interpolated getters with alpha.
+	void setInterpolatedTransforms(scene::TransformManager*);
+
+	// -- pipelined frames
+	// The simulation of frame N+1 runs as a job on the job system and fills a
+	// render snapshot, while the main thread renders frame N from the other
+	// snapshot. This adds a frame of latency. Simulation code must not touch
+	// render resources and render code may only read the snapshot. Without a
+	// job system the simulation runs first, then the previous frame is rendered.
+	bool pipelined() const { return pipelined_; }
+	void setPipelined(bool pipelined, jobs::JobSystem* jobSystem);
 	
 	// start/stop is called by Application when the app
 	// becomes or ceases to be the frontmost app in the system, resp.
@@ -11,7 +11,7 @@ namespace scene {
 
 
 PluggableBehaviour::PluggableBehaviour() {
-	static auto noAction = [](Entity, Scene&, Time dt){};
+	static auto noAction = [](Entity, Scene&, Time){};
 	updateFunc_ = noAction;
 }
 
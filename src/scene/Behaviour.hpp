@@ -9,9 +9,11 @@
 #include "system/Config.hpp"
 #include "system/Time.hpp"
 #include "container/Array.hpp"
-#include "container/HashMap.hpp"
 #include "memory/Arena.hpp"
+#include "memory/TrackingAllocator.hpp"
+#include "runtime/Profiler.hpp"
 #include "scene/Entity.hpp"
+#include "scene/EntityMap.hpp"
 
 #include <functional>
 
@@ -49,27 +51,33 @@ public:
 	using Instance = scene::Instance<Behaviour>;
 
 private:
+	memory::TrackingAllocator allocator_;
 	memory::ArenaAllocator arena_;
 	Array<BehaviourConcept*> items_;
-	HashMap<Entity, BehaviourConcept*> entityMap_;
+	EntityMap<BehaviourConcept*> entityMap_;
 	uint32 count_;
 
+	void destructAll() {
+		for (auto b = 0u; b < count_; ++b)
+			items_[b]->~BehaviourConcept();
+	}
+
 public:
 	Behaviour(memory::Allocator& allocator)
-	: arena_(allocator)
-	, items_(allocator, 128)
-	, entityMap_(allocator)
+	: allocator_(allocator, memory::MemoryTag::Behaviour)
+	, arena_(allocator_)
+	, items_(allocator_, 128)
+	, entityMap_(allocator_)
 	, count_(0)
 	{}
 	
 	~Behaviour() {
-		for (auto b = 0u; b < count_; ++b)
-			items_[b]->~BehaviourConcept();
+		destructAll();
 	}
 	
 	template <typename B, typename... Args>
 	Instance append(const B& beh) {
-		auto space = static_cast<B*>(arena_.alloc(sizeof(B)));
+		auto space = static_cast<B*>(arena_.alloc(sizeof(B), alignof(B)));
 		new (space) B(beh);
 		items_.emplaceBack(space);
 		return { count_++ };
@@ -77,7 +85,7 @@ public:
 
 	template <typename B, typename... Args>
 	Instance emplace(Args&&... args) {
-		auto space = static_cast<B*>(arena_.alloc(sizeof(B)));
+		auto space = static_cast<B*>(arena_.alloc(sizeof(B), alignof(B)));
 		new (space) B(std::forward<Args>(args)...);
 		items_.emplaceBack(space);
 		return { count_++ };
@@ -91,7 +99,19 @@ public:
 	}
 	
 	
+	// destroy all behaviours and links, the arena keeps its blocks for reuse
+	void clear() {
+		destructAll();
+		entityMap_.clear();
+		items_.clear();
+		count_ = 0;
+		arena_.reset();
+	}
+
+
 	void updateAll(Scene& scene, Time dt) {
+		SD_PROFILE_SCOPE("Behaviour::updateAll");
+
 		auto allLinkedBehaviours = entityMap_.all();
 		while (allLinkedBehaviours.next()) {
 			auto entBeh = allLinkedBehaviours.current();
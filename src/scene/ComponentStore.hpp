@@ -0,0 +1,183 @@
+// ------------------------------------------------------------------
+// scene::ComponentStore - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_SCENE_COMPONENTSTORE_H
+#define SD_SCENE_COMPONENTSTORE_H
+
+#include "system/Config.hpp"
+#include "memory/Allocator.hpp"
+#include "container/Array.hpp"
+#include "container/Deque.hpp"
+#include "container/MultiArrayBuffer.hpp"
+#include "util/ConceptTraits.hpp"
+#include "scene/Entity.hpp"
+
+namespace stardazed {
+namespace scene {
+
+
+// Dense SoA instance data for a component manager. Instances are handed out as
+// generational handles that refer to a slot, the slot maps to the instance's
+// current index in the dense arrays. Destroying an instance moves the last
+// instance into its place so the dense arrays never have holes and per-frame
+// loops only visit live instances.
+//
+// Index 0 of the dense arrays is a zeroed null-instance, loops over all
+// instances start at index 1. The null handle (ref 0) maps to index 0.
+
+template <typename Component, typename Layout, typename... Ts>
+class BasicComponentStore {
+public:
+	using Instance = scene::Instance<Component>;
+
+	static constexpr uint32 slotBits = 24;
+	static constexpr uint32 generationBits = 8;
+	static constexpr uint32 slotMask = (1 << slotBits) - 1;
+	static constexpr uint32 generationMask = (1 << generationBits) - 1;
+
+private:
+	container::BasicMultiArrayBuffer<Layout, Ts...> instanceData_;
+	Array<uint32> denseToSlot_;
+	Array<uint32> slotToDense_;
+	Array<uint8> generation_;
+	Deque<uint32> freedSlots_;
+
+	// delay reuse of slots so that generations wrap around less often
+	static constexpr uint32 minFreedBuildup = 256;
+
+	static uint32 slotOf(Instance h) { return h.ref & slotMask; }
+	static uint32 generationOf(Instance h) { return (h.ref >> slotBits) & generationMask; }
+
+	Instance makeInstance(uint32 slot) const {
+		return { slot | (uint32(generation_[slot]) << slotBits) };
+	}
+
+public:
+	BasicComponentStore(memory::Allocator& allocator, uint32 initialCapacity)
+	: instanceData_(allocator, initialCapacity)
+	, denseToSlot_(allocator, initialCapacity)
+	, slotToDense_(allocator, initialCapacity)
+	, generation_(allocator, initialCapacity)
+	, freedSlots_(allocator)
+	{
+		// index and slot 0 are the null-instance
+		instanceData_.extend();
+		denseToSlot_.append(0);
+		slotToDense_.append(0);
+		generation_.append(0);
+	}
+	SD_NOCOPYORMOVE_CLASS(BasicComponentStore)
+
+
+	// -- dense arrays, count() includes the null-instance at index 0
+	uint32 count() const { return instanceData_.count(); }
+	uint32 liveCount() const { return instanceData_.count() - 1; }
+
+	template <uint32 Index>
+	auto elementsBasePtr() const {
+		return instanceData_.template elementsBasePtr<Index>();
+	}
+
+	memory::Allocator& allocator() const { return instanceData_.allocator(); }
+
+
+	// -- instance lifetime
+
+	// Appends a zeroed instance at the back of the dense arrays.
+	container::InvalidatePointers create(Instance& outInstance) {
+		uint32 slot;
+
+		if (freedSlots_.count() >= minFreedBuildup) {
+			slot = freedSlots_.front();
+			freedSlots_.popFront();
+		}
+		else {
+			slot = slotToDense_.count();
+			assert(slot <= slotMask);
+			slotToDense_.append(0);
+			generation_.append(0);
+		}
+
+		auto index = instanceData_.count();
+		auto invalidation = instanceData_.extend();
+		denseToSlot_.append(slot);
+		slotToDense_[slot] = index;
+
+		outInstance = makeInstance(slot);
+		return invalidation;
+	}
+
+
+	// Removes the instance, the last instance in the dense arrays moves into its place.
+	void destroy(Instance h) {
+		assert(valid(h));
+		auto slot = slotOf(h);
+		auto index = slotToDense_[slot];
+		auto lastIndex = instanceData_.backIndex();
+
+		instanceData_.swapRemove(index);
+
+		auto movedSlot = denseToSlot_[lastIndex];
+		denseToSlot_[index] = movedSlot;
+		slotToDense_[movedSlot] = index;
+		denseToSlot_.popBack();
+
+		// a stale handle that gets past the assert in indexOf() maps to the null-instance
+		slotToDense_[slot] = 0;
+		generation_[slot]++;
+		freedSlots_.append(slot);
+	}
+
+
+	// Exchanges the dense positions of two instances, handles stay valid.
+	void swapIndexes(uint32 indexA, uint32 indexB) {
+		assert(indexA != 0 && indexB != 0);
+		instanceData_.swapElements(indexA, indexB);
+
+		auto slotA = denseToSlot_[indexA];
+		auto slotB = denseToSlot_[indexB];
+		denseToSlot_[indexA] = slotB;
+		denseToSlot_[indexB] = slotA;
+		slotToDense_[slotA] = indexB;
+		slotToDense_[slotB] = indexA;
+	}
+
+
+	bool valid(Instance h) const {
+		auto slot = slotOf(h);
+		return slot != 0 && slot < generation_.count() && generationOf(h) == generation_[slot];
+	}
+
+
+	// -- handle <-> dense index mapping, valid until the next destroy() or swapIndexes()
+	uint32 indexOf(Instance h) const {
+		assert(h.ref == 0 || valid(h));
+		return slotToDense_[slotOf(h)];
+	}
+
+	Instance instanceAt(uint32 index) const {
+		assert(index < instanceData_.count());
+		return makeInstance(denseToSlot_[index]);
+	}
+
+
+	// -- slots do not move, use them to keep per-instance data outside the store.
+	// Slots are reused by later instances, compare handles to tell them apart.
+	static uint32 slotIndex(Instance h) { return slotOf(h); }
+	uint32 slotCount() const { return slotToDense_.count(); }
+};
+
+
+template <typename Component, typename... Ts>
+using ComponentStore = BasicComponentStore<Component, container::PackedColumnLayout, Ts...>;
+
+template <typename Component, typename... Ts>
+using AlignedComponentStore = BasicComponentStore<Component, container::AlignedColumnLayout<64>, Ts...>;
+
+
+} // ns scene
+} // ns stardazed
+
+#endif
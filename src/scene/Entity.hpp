@@ -12,6 +12,7 @@
 #include "system/Config.hpp"
 #include "container/Array.hpp"
 #include "container/Deque.hpp"
+#include "container/SparseSet.hpp"
 #include "util/Hash.hpp"
 
 namespace stardazed {
@@ -119,6 +120,19 @@ struct Hash<scene::Entity> {
 };
 
 
+// -- SparseSet key specialization for Entity, the generation is checked on lookup
+namespace container {
+
+template <>
+struct SparseKeyTraits<scene::Entity> {
+	static uint32 index(scene::Entity ent) {
+		return ent.index();
+	}
+};
+
+} // ns container
+
+
 } // ns stardazed
 
 #endif
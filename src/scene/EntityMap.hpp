@@ -0,0 +1,52 @@
+// ------------------------------------------------------------------
+// scene::EntityMap - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_SCENE_ENTITYMAP_H
+#define SD_SCENE_ENTITYMAP_H
+
+#include "system/Config.hpp"
+#include "scene/Entity.hpp"
+
+// Component managers map entities to their instances with an EntityMap.
+// SD_ENTITYMAP_IMPL selects the container, define it to one of the values
+// below in the build settings to override the default.
+#define SD_ENTITYMAP_HASHMAP     1
+#define SD_ENTITYMAP_FLATHASHMAP 2
+#define SD_ENTITYMAP_SPARSESET   3
+
+#ifndef SD_ENTITYMAP_IMPL
+#	define SD_ENTITYMAP_IMPL SD_ENTITYMAP_SPARSESET
+#endif
+
+#if SD_ENTITYMAP_IMPL == SD_ENTITYMAP_HASHMAP
+#	include "container/HashMap.hpp"
+#elif SD_ENTITYMAP_IMPL == SD_ENTITYMAP_FLATHASHMAP
+#	include "container/FlatHashMap.hpp"
+#elif SD_ENTITYMAP_IMPL == SD_ENTITYMAP_SPARSESET
+#	include "container/SparseSet.hpp"
+#else
+#	error "Unknown SD_ENTITYMAP_IMPL"
+#endif
+
+namespace stardazed {
+namespace scene {
+
+
+#if SD_ENTITYMAP_IMPL == SD_ENTITYMAP_HASHMAP
+template <typename Value>
+using EntityMap = HashMap<Entity, Value>;
+#elif SD_ENTITYMAP_IMPL == SD_ENTITYMAP_FLATHASHMAP
+template <typename Value>
+using EntityMap = FlatHashMap<Entity, Value>;
+#else
+template <typename Value>
+using EntityMap = SparseSet<Entity, Value>;
+#endif
+
+
+} // ns scene
+} // ns stardazed
+
+#endif
@@ -27,11 +27,11 @@ void Light::rebase() {
 
 
 Light::Handle Light::append(const LightDescriptor& desc) {
-	if (__builtin_expect(instanceData_.extend() == container::InvalidatePointers::Yes, 0)) {
+	Handle h;
+	if (__builtin_expect(instanceData_.create(h) == container::InvalidatePointers::Yes, 0)) {
 		rebase();
 	}
 
-	Handle h { nextRef_++ };
 	setType(h, desc.type);
 	setEnabled(h, true);
 	setColour(h, desc.colour);
@@ -47,5 +47,10 @@ Light::Handle Light::append(const LightDescriptor& desc) {
 }
 
 
+void Light::remove(Handle h) {
+	instanceData_.destroy(h);
+}
+
+
 } // ns scene
 } // ns stardazed
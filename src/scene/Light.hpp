@@ -9,7 +9,7 @@
 #include "system/Config.hpp"
 #include "math/Angle.hpp"
 #include "math/Vector.hpp"
-#include "container/MultiArrayBuffer.hpp"
+#include "scene/ComponentStore.hpp"
 
 namespace stardazed {
 namespace scene {
@@ -37,7 +37,11 @@ LightDescriptor makeSpotLightDesc(const math::Vec3& colour, float intensity, flo
 
 
 class Light {
-	container::MultiArrayBuffer<
+public:
+	using Handle = scene::Instance<Light>;
+
+private:
+	ComponentStore<Light,
 		LightType,  // type
 		bool8,      // enabled
 		math::Vec3, // colour
@@ -54,32 +58,33 @@ class Light {
 	math::Angle* cutoffBase_ = nullptr;
 	
 	void rebase();
-	
-	uint32 nextRef_ = 1;
+	uint32 indexOf(Handle h) const { return instanceData_.indexOf(h); }
 
 public:
 	Light();
 
 	// -- shared Component `interface`
-	struct Handle { uint32 ref; };
-	
-	uint32 count() const { return instanceData_.count(); }
+	uint32 count() const { return instanceData_.liveCount(); }
 	Handle append(const LightDescriptor&);
+	void remove(Handle);
+	bool valid(Handle h) const { return instanceData_.valid(h); }
+	// handles of all lights are at indexes 1 through count(), until the next append or remove
+	Handle instanceAt(uint32 index) const { return instanceData_.instanceAt(index); }
 
 	// -- single instance data access
-	LightType type(Handle h) const { return typeBase_[h.ref]; }
-	bool8 enabled(Handle h) const { return enabledBase_[h.ref]; }
-	const math::Vec3& colour(Handle h) const { return colourBase_[h.ref]; }
-	float intensity(Handle h) const { return intensityBase_[h.ref]; }
-	float range(Handle h) const { return rangeBase_[h.ref]; }
-	math::Angle cutoff(Handle h) const { return cutoffBase_[h.ref]; }
-
-	void setType(Handle h, LightType newType) const { typeBase_[h.ref] = newType; }
-	void setEnabled(Handle h, bool8 newEnabled) const { enabledBase_[h.ref] = newEnabled; }
-	void setColour(Handle h, const math::Vec3& newColour) const { colourBase_[h.ref] = newColour; }
-	void setIntensity(Handle h, float newIntensity) const { intensityBase_[h.ref] = newIntensity; }
-	void setRange(Handle h, float newRange) const { rangeBase_[h.ref] = newRange; }
-	void setCutoff(Handle h, math::Angle newCutoff) { cutoffBase_[h.ref] = newCutoff; }
+	LightType type(Handle h) const { return typeBase_[indexOf(h)]; }
+	bool8 enabled(Handle h) const { return enabledBase_[indexOf(h)]; }
+	const math::Vec3& colour(Handle h) const { return colourBase_[indexOf(h)]; }
+	float intensity(Handle h) const { return intensityBase_[indexOf(h)]; }
+	float range(Handle h) const { return rangeBase_[indexOf(h)]; }
+	math::Angle cutoff(Handle h) const { return cutoffBase_[indexOf(h)]; }
+
+	void setType(Handle h, LightType newType) const { typeBase_[indexOf(h)] = newType; }
+	void setEnabled(Handle h, bool8 newEnabled) const { enabledBase_[indexOf(h)] = newEnabled; }
+	void setColour(Handle h, const math::Vec3& newColour) const { colourBase_[indexOf(h)] = newColour; }
+	void setIntensity(Handle h, float newIntensity) const { intensityBase_[indexOf(h)] = newIntensity; }
+	void setRange(Handle h, float newRange) const { rangeBase_[indexOf(h)] = newRange; }
+	void setCutoff(Handle h, math::Angle newCutoff) { cutoffBase_[indexOf(h)] = newCutoff; }
 };
 
 
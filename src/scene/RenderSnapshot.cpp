@@ -0,0 +1,116 @@
+// ------------------------------------------------------------------
+// scene::RenderSnapshot.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "scene/RenderSnapshot.hpp"
+
+namespace stardazed {
+namespace scene {
+
+
+RenderSnapshot::RenderSnapshot(memory::Allocator& allocator)
+: transformRefs_(allocator, 512)
+, modelMatrices_(allocator, 512)
+, models_(allocator, 512)
+, lights_(allocator, 16)
+, cameras_(allocator, 4)
+{}
+
+
+void RenderSnapshot::clear() {
+	transformRefs_.clear();
+	models_.clear();
+	lights_.clear();
+	cameras_.clear();
+}
+
+
+void RenderSnapshot::setFrameTiming(Time frameTime, float interpolationAlpha) {
+	frameTime_ = frameTime;
+	interpolationAlpha_ = interpolationAlpha;
+}
+
+
+void RenderSnapshot::prepareTransforms(const TransformManager& transforms) {
+	auto slotCount = transforms.slotCount();
+	transformRefs_.clear();
+	transformRefs_.resize(slotCount);
+	if (modelMatrices_.count() < slotCount) {
+		modelMatrices_.resize(slotCount);
+	}
+}
+
+
+void RenderSnapshot::captureTransforms(const TransformManager& transforms) {
+	prepareTransforms(transforms);
+
+	auto worldMatrices = transforms.worldMatrices();
+	for (uint32 index = 1, count = transforms.count(); index <= count; ++index) {
+		auto h = transforms.instanceAt(index);
+		auto slot = TransformManager::slotIndex(h);
+		transformRefs_[slot] = h.ref;
+		modelMatrices_[slot] = worldMatrices[index];
+	}
+}
+
+
+void RenderSnapshot::captureInterpolatedTransforms(const TransformManager& transforms, float alpha) {
+	prepareTransforms(transforms);
+
+	for (uint32 index = 1, count = transforms.count(); index <= count; ++index) {
+		auto h = transforms.instanceAt(index);
+		auto slot = TransformManager::slotIndex(h);
+		transformRefs_[slot] = h.ref;
+		modelMatrices_[slot] = transforms.interpolatedModelMatrix(h, alpha);
+	}
+}
+
+
+void RenderSnapshot::captureModel(const ModelState& model) {
+	models_.append(model);
+}
+
+
+void RenderSnapshot::captureLights(const Light& lights) {
+	lights_.clear();
+
+	for (uint32 index = 1, count = lights.count(); index <= count; ++index) {
+		auto h = lights.instanceAt(index);
+		lights_.append({
+			lights.type(h),
+			lights.enabled(h),
+			lights.colour(h),
+			lights.intensity(h),
+			lights.range(h),
+			lights.cutoff(h)
+		});
+	}
+}
+
+
+uint32 RenderSnapshot::captureCamera(const Camera& camera) {
+	cameras_.append({
+		camera.projectionMatrix(),
+		camera.viewMatrix(),
+		camera.viewPortWidth(),
+		camera.viewPortHeight()
+	});
+	return cameras_.count() - 1;
+}
+
+
+bool RenderSnapshot::hasTransform(TransformManager::Instance h) const {
+	auto slot = TransformManager::slotIndex(h);
+	return h.ref != 0 && slot < transformRefs_.count() && transformRefs_[slot] == h.ref;
+}
+
+
+const math::Mat4& RenderSnapshot::modelMatrix(TransformManager::Instance h) const {
+	assert(hasTransform(h));
+	return modelMatrices_[TransformManager::slotIndex(h)];
+}
+
+
+} // ns scene
+} // ns stardazed
@@ -0,0 +1,110 @@
+// ------------------------------------------------------------------
+// scene::RenderSnapshot - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_SCENE_RENDERSNAPSHOT_H
+#define SD_SCENE_RENDERSNAPSHOT_H
+
+#include "system/Config.hpp"
+#include "system/Time.hpp"
+#include "math/Matrix.hpp"
+#include "memory/Allocator.hpp"
+#include "container/Array.hpp"
+#include "util/ConceptTraits.hpp"
+#include "scene/Transform.hpp"
+#include "scene/Light.hpp"
+#include "scene/Camera.hpp"
+#include "scene/RendererShared.hpp"
+#include "scene/Entity.hpp"
+
+namespace stardazed {
+namespace render { class Mesh; }
+namespace scene {
+
+
+struct LightState {
+	LightType type;
+	bool8 enabled;
+	math::Vec3 colour;
+	float intensity;
+	float range;
+	math::Angle cutoff;
+};
+
+
+struct CameraState {
+	math::Mat4 projection, view;
+	uint32 viewportWidth, viewportHeight;
+};
+
+
+struct ModelState {
+	Entity entity;
+	TransformManager::Instance transform;
+	render::Mesh* mesh;
+	uint32 model; // model instance of the manager that captured it, selects its materials
+};
+
+
+// Copy of the component data that render code reads: model matrices, the
+// models to draw, lights and cameras. The simulation fills a snapshot and
+// rendering only reads it, which lets RunLoop's pipelined mode simulate the
+// next frame while the previous one is rendered. Model matrices are stored
+// by transform slot, so looking one up does not touch the TransformManager.
+
+class RenderSnapshot {
+	Array<uint32> transformRefs_; // handle of the transform in each slot, 0 if none
+	Array<math::Mat4> modelMatrices_;
+	Array<ModelState> models_;
+	Array<LightState> lights_;
+	Array<CameraState> cameras_;
+
+	Time frameTime_ = 0;
+	float interpolationAlpha_ = 1;
+
+	void prepareTransforms(const TransformManager&);
+
+public:
+	explicit RenderSnapshot(memory::Allocator&);
+	SD_NOCOPYORMOVE_CLASS(RenderSnapshot)
+
+	void clear();
+
+	// -- frame timing, set by RunLoop before the snapshot is captured
+	Time frameTime() const { return frameTime_; }
+	float interpolationAlpha() const { return interpolationAlpha_; }
+	void setFrameTiming(Time frameTime, float interpolationAlpha);
+
+	// -- capture, simulation side
+	void captureTransforms(const TransformManager&);
+	// model matrices blended between the last two captured ticks
+	void captureInterpolatedTransforms(const TransformManager&, float alpha);
+	// model managers add the models they will render, see StandardModelManager::capture
+	void captureModel(const ModelState&);
+	void captureLights(const Light&);
+	// returns the index of the camera in this snapshot
+	uint32 captureCamera(const Camera&);
+
+	// -- access, render side
+	bool hasTransform(TransformManager::Instance) const;
+	const math::Mat4& modelMatrix(TransformManager::Instance) const;
+
+	uint32 modelCount() const { return models_.count(); }
+	const ModelState& model(uint32 index) const { return models_[index]; }
+
+	uint32 lightCount() const { return lights_.count(); }
+	const LightState& light(uint32 index) const { return lights_[index]; }
+
+	uint32 cameraCount() const { return cameras_.count(); }
+	const CameraState& camera(uint32 index) const { return cameras_[index]; }
+	ProjectionSetup projectionSetup(uint32 cameraIndex) const {
+		return { cameras_[cameraIndex].projection, cameras_[cameraIndex].view };
+	}
+};
+
+
+} // ns scene
+} // ns stardazed
+
+#endif
@@ -36,6 +36,13 @@ Entity Scene::makeEntity(const math::Vec3& pos, const math::Quat& rot, const mat
 }
 
 
+// components in managers outside of the scene must be destroyed by their owners first
+void Scene::destroyEntity(Entity ent) {
+	transform_.destroy(ent);
+	entities_.destroy(ent);
+}
+
+
 /*
 Scene::Scene() {
 	// FIXME: make this settable by client
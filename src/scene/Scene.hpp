@@ -24,6 +24,7 @@ public:
 	Entity makeEntity();
 	Entity makeEntity(const TransformDescriptor&);
 	Entity makeEntity(const math::Vec3& pos, const math::Quat& rot = math::Quat::identity(), const math::Vec3& scale = math::Vec3::one());
+	void destroyEntity(Entity);
 	
 	TransformManager& transform() { return transform_; }
 };
@@ -4,7 +4,10 @@
 // ------------------------------------------------------------------
 
 #include "scene/Transform.hpp"
+#include "math/TransformKernels.hpp"
+#include "memory/TrackingAllocator.hpp"
 #include <cmath>
+#include <utility>
 
 namespace stardazed {
 namespace scene {
@@ -19,7 +22,7 @@ static math::Quat lookAtImpl(math::Vec3 localForward, const math::Vec3& worldUp)
 	orthoNormalize(localForward, localUp);
 	auto localRight = cross(localUp, localForward);
 	
-	auto w = std::sqrtf(1.0f + localRight.x + localUp.y	+ localForward.z) * 0.5f;
+	auto w = std::sqrt(1.0f + localRight.x + localUp.y	+ localForward.z) * 0.5f;
 	if (nearEqual(w, 0.f)) // FIXME: this doesn't work
 		return Quat::fromAxisAngle({ 0,1,0 }, Pi);
 
@@ -34,13 +37,18 @@ static math::Quat lookAtImpl(math::Vec3 localForward, const math::Vec3& worldUp)
 }
 
 
-inline void recalcModelMatrix(const math::Vec3& pos, const math::Quat& rot, const math::Vec3& scale, math::Mat4& modelMat) {
-	modelMat = math::translationMatrix(pos) * rot.toMatrix4() * math::scaleMatrix(scale);
-}
+TransformManager::TickState::TickState(memory::Allocator& allocator)
+: refs(allocator, 512)
+, positions(allocator, 512)
+, rotations(allocator, 512)
+{}
 
 
 TransformManager::TransformManager()
-: instanceData_{ memory::SystemAllocator::sharedInstance(), 512 }
+: instanceData_{ memory::trackedAllocator(memory::MemoryTag::TransformManager), 512 }
+, entityMap_{ memory::trackedAllocator(memory::MemoryTag::TransformManager), 512 }
+, tickStateA_{ memory::trackedAllocator(memory::MemoryTag::TransformManager) }
+, tickStateB_{ memory::trackedAllocator(memory::MemoryTag::TransformManager) }
 {
 	rebase();
 }
@@ -51,94 +59,153 @@ void TransformManager::rebase() {
 	positionBase_ = instanceData_.elementsBasePtr<1>();
 	rotationBase_ = instanceData_.elementsBasePtr<2>();
 	scaleBase_ = instanceData_.elementsBasePtr<3>();
-	modelMatrixBase_ = instanceData_.elementsBasePtr<4>();
+	localMatrixBase_ = instanceData_.elementsBasePtr<4>();
+	worldMatrixBase_ = instanceData_.elementsBasePtr<5>();
+	flagsBase_ = instanceData_.elementsBasePtr<6>();
+	changeCountBase_ = instanceData_.elementsBasePtr<7>();
+}
+
+
+void TransformManager::setMatrixUpdateMode(MatrixUpdateMode mode) {
+	updateMode_ = mode;
+}
+
+
+void TransformManager::localChanged(uint32 index) {
+	flagsBase_[index] |= localChangedFlag;
+	changeCountBase_[index]++;
+
+	// unparented transforms are kept up to date immediately
+	if (updateMode_ == MatrixUpdateMode::Immediate && parentBase_[index].ref == 0 && (flagsBase_[index] & trsChangedFlag) == 0) {
+		worldMatrixBase_[index] = localMatrixBase_[index];
+	}
+}
+
+
+void TransformManager::trsChanged(uint32 index) {
+	if (updateMode_ == MatrixUpdateMode::Deferred) {
+		flagsBase_[index] |= trsChangedFlag | localChangedFlag;
+		changeCountBase_[index]++;
+		return;
+	}
+
+	math::composeTRS(positionBase_[index], rotationBase_[index], scaleBase_[index], localMatrixBase_[index]);
+	flagsBase_[index] &= uint8(~trsChangedFlag);
+	localChanged(index);
 }
 
 
 TransformManager::Instance TransformManager::assign(Entity linkedEntity, const Instance parent) {
-	auto entIndex = linkedEntity.index();
+	return assign(linkedEntity, TransformDescriptor{}, parent);
+}
 
-	if (instanceData_.count() < entIndex) {
-		auto newCount = math::roundUpPowerOf2(entIndex);
-		if (instanceData_.resize(newCount) == container::InvalidatePointers::Yes) {
-			rebase();
-		}
+
+TransformManager::Instance TransformManager::assign(Entity linkedEntity, const TransformDescriptor& desc, const Instance parent) {
+	assert(! forEntity(linkedEntity));
+	assert(parent.ref == 0 || valid(parent));
+
+	// appended instances always come after their parent
+	Instance h;
+	if (instanceData_.create(h) == container::InvalidatePointers::Yes) {
+		rebase();
 	}
+	auto index = indexOf(h);
 	
-	Instance h { entIndex };
+	parentBase_[index] = parent;
+	positionBase_[index] = desc.position;
+	rotationBase_[index] = desc.rotation;
+	scaleBase_[index] = desc.scale;
+	trsChanged(index);
 
-	parentBase_[h.ref] = parent;
-	rotationBase_[h.ref] = math::Quat::identity();
-	scaleBase_[h.ref] = math::Vec3::one();
-	modelMatrixBase_[h.ref] = math::Mat4::identity();
-	
+	entityMap_.insert(linkedEntity, h);
 	return h;
 }
 
 
-TransformManager::Instance TransformManager::assign(Entity linkedEntity, const TransformDescriptor& desc, const Instance parent) {
-	auto entIndex = linkedEntity.index();
-	
-	if (instanceData_.count() < entIndex) {
-		auto newCount = math::roundUpPowerOf2(entIndex);
-		if (instanceData_.resize(newCount) == container::InvalidatePointers::Yes) {
-			rebase();
+void TransformManager::destroy(Entity linkedEntity) {
+	auto h = forEntity(linkedEntity);
+	if (! h)
+		return;
+
+	entityMap_.remove(linkedEntity);
+
+	auto index = indexOf(h);
+	instanceData_.destroy(h);
+
+	// the last instance was moved into the hole, possibly in front of its parent
+	if (index < instanceData_.count()) {
+		auto movedParent = parentBase_[index];
+		if (valid(movedParent) && indexOf(movedParent) > index) {
+			hierarchyOrderValid_ = false;
 		}
 	}
-	
-	Instance h { entIndex };
-	
-	parentBase_[h.ref] = parent;
-	positionBase_[h.ref] = desc.position;
-	rotationBase_[h.ref] = desc.rotation;
-	scaleBase_[h.ref] = desc.scale;
-	recalcModelMatrix(desc.position, desc.rotation, desc.scale, modelMatrixBase_[h.ref]);
-	
-	return h;
 }
 
 
 TransformManager::Instance TransformManager::forEntity(Entity ent) const {
-	return { ent.index() };
+	auto result = entityMap_.find(ent);
+	return result ? *result : root();
 }
 
 
 void TransformManager::setParent(const Instance h, const Instance newParent) {
 	assert(h.ref != 0);
-	parentBase_[h.ref] = newParent;
+	assert(h != newParent);
+	auto index = indexOf(h);
+
+	parentBase_[index] = newParent;
+	if (newParent.ref != 0 && indexOf(newParent) > index) {
+		hierarchyOrderValid_ = false;
+	}
+	localChanged(index);
 }
 
 
 void TransformManager::setPosition(const Instance h, const math::Vec3& newPosition) {
 	assert(h.ref != 0);
+	auto index = indexOf(h);
 
-	positionBase_[h.ref] = newPosition;
-	recalcModelMatrix(newPosition, rotation(h), scale(h), modelMatrixBase_[h.ref]);
+	positionBase_[index] = newPosition;
+	trsChanged(index);
 }
 
 
 void TransformManager::setRotation(const Instance h, const math::Quat& newRotation) {
 	assert(h.ref != 0);
+	auto index = indexOf(h);
 
-	rotationBase_[h.ref] = newRotation;
-	recalcModelMatrix(position(h), newRotation, scale(h), modelMatrixBase_[h.ref]);
+	rotationBase_[index] = newRotation;
+	trsChanged(index);
 }
 
 
 void TransformManager::setPositionAndRotation(const Instance h, const math::Vec3& newPosition, const math::Quat& newRotation) {
 	assert(h.ref != 0);
+	auto index = indexOf(h);
 
-	positionBase_[h.ref] = newPosition;
-	rotationBase_[h.ref] = newRotation;
-	recalcModelMatrix(newPosition, newRotation, scale(h), modelMatrixBase_[h.ref]);
+	positionBase_[index] = newPosition;
+	rotationBase_[index] = newRotation;
+	trsChanged(index);
 }
 
 
 void TransformManager::setScale(const Instance h, const math::Vec3& newScale) {
 	assert(h.ref != 0);
+	auto index = indexOf(h);
 
-	scaleBase_[h.ref] = newScale;
-	recalcModelMatrix(position(h), rotation(h), newScale, modelMatrixBase_[h.ref]);
+	scaleBase_[index] = newScale;
+	trsChanged(index);
+}
+
+
+void TransformManager::setPositions(const uint32* denseIndexes, const math::Vec3* newPositions, uint32 count) {
+	for (uint32 i = 0; i < count; ++i) {
+		auto index = denseIndexes[i];
+		assert(index != 0);
+
+		positionBase_[index] = newPositions[i];
+		trsChanged(index);
+	}
 }
 
 
@@ -147,5 +214,189 @@ void TransformManager::lookAt(const Instance h, const math::Vec3& target, const
 }
 
 
+// Restores parent-before-child order by stable sorting the instances on their
+// depth in the hierarchy. Only needed after a reparent or destroy broke the order.
+void TransformManager::sortHierarchy() {
+	auto& allocator = instanceData_.allocator();
+	auto count = instanceData_.count();
+
+	Array<uint32> depth(allocator, count);
+	depth.resize(count);
+	uint32 maxDepth = 0;
+
+	for (uint32 index = 1; index < count; ++index) {
+		uint32 d = 0;
+		auto parent = parentBase_[index];
+		while (valid(parent)) {
+			++d;
+			assert(d < count); // cycle in hierarchy
+			parent = parentBase_[indexOf(parent)];
+		}
+		depth[index] = d;
+		maxDepth = math::max(maxDepth, d);
+	}
+
+	// counting sort of the dense indexes by depth
+	Array<uint32> depthStart(allocator, maxDepth + 2);
+	depthStart.resize(maxDepth + 2);
+	for (uint32 index = 1; index < count; ++index) {
+		depthStart[depth[index] + 1]++;
+	}
+	depthStart[0] = 1;
+	for (uint32 d = 1; d <= maxDepth + 1; ++d) {
+		depthStart[d] += depthStart[d - 1];
+	}
+
+	Array<uint32> order(allocator, count); // order[newIndex] = oldIndex
+	order.resize(count);
+	for (uint32 index = 1; index < count; ++index) {
+		order[depthStart[depth[index]]++] = index;
+	}
+
+	// apply the permutation with swaps, tracking where each original element went
+	Array<uint32> positionOf(allocator, count);
+	Array<uint32> originalAt(allocator, count);
+	positionOf.resize(count);
+	originalAt.resize(count);
+	for (uint32 index = 0; index < count; ++index) {
+		positionOf[index] = index;
+		originalAt[index] = index;
+	}
+
+	for (uint32 index = 1; index < count; ++index) {
+		auto from = positionOf[order[index]];
+		if (from != index) {
+			instanceData_.swapIndexes(index, from);
+			auto displaced = originalAt[index];
+			positionOf[displaced] = from;
+			originalAt[from] = displaced;
+			positionOf[order[index]] = index;
+			originalAt[index] = order[index];
+		}
+	}
+
+	hierarchyOrderValid_ = true;
+}
+
+
+void TransformManager::updateMatrices() {
+	if (! hierarchyOrderValid_) {
+		sortHierarchy();
+	}
+
+	auto count = instanceData_.count();
+
+	// rebuild stale local matrices, consecutive instances go through the batch kernel
+	jobs::parallelFor(jobSystem_, 1, count, 1024, [this](uint32 first, uint32 last) {
+		uint32 runStart = 0;
+		for (uint32 index = first; index <= last; ++index) {
+			bool stale = index < last && (flagsBase_[index] & trsChangedFlag);
+			if (stale) {
+				if (runStart == 0) {
+					runStart = index;
+				}
+			}
+			else if (runStart) {
+				math::composeTRS(positionBase_ + runStart, rotationBase_ + runStart, scaleBase_ + runStart, localMatrixBase_ + runStart, index - runStart);
+				runStart = 0;
+			}
+		}
+	});
+
+	for (uint32 index = 1; index < count; ++index) {
+		auto flags = flagsBase_[index];
+		auto parent = parentBase_[index];
+		uint32 parentIndex = 0;
+
+		if (parent.ref != 0) {
+			if (valid(parent)) {
+				parentIndex = indexOf(parent);
+				// parents come first so their flags are already those of this update
+				if (flagsBase_[parentIndex] & worldChangedFlag) {
+					flags |= localChangedFlag;
+				}
+			}
+			else {
+				// parent was destroyed, the instance becomes a root
+				parentBase_[index] = root();
+				flags |= localChangedFlag;
+			}
+		}
+
+		if (flags & localChangedFlag) {
+			if (parentIndex) {
+				worldMatrixBase_[index] = worldMatrixBase_[parentIndex] * localMatrixBase_[index];
+			}
+			else {
+				worldMatrixBase_[index] = localMatrixBase_[index];
+			}
+			flagsBase_[index] = worldChangedFlag;
+			changeCountBase_[index]++;
+		}
+		else {
+			flagsBase_[index] = 0;
+		}
+	}
+}
+
+
+void TransformManager::captureTickState() {
+	std::swap(previousTick_, currentTick_);
+
+	auto& state = *currentTick_;
+	auto slotCount = instanceData_.slotCount();
+	state.refs.clear();
+	state.refs.resize(slotCount);
+	state.positions.resize(slotCount);
+	state.rotations.resize(slotCount);
+
+	for (uint32 index = 1, count = instanceData_.count(); index < count; ++index) {
+		auto h = instanceData_.instanceAt(index);
+		auto slot = instanceData_.slotIndex(h);
+		state.refs[slot] = h.ref;
+		state.positions[slot] = positionBase_[index];
+		state.rotations[slot] = rotationBase_[index];
+	}
+}
+
+
+math::Vec3 TransformManager::interpolatedPosition(Instance h, float alpha) const {
+	auto slot = instanceData_.slotIndex(h);
+	const auto& current = *currentTick_;
+	const auto& previous = *previousTick_;
+
+	if (slot >= current.refs.count() || current.refs[slot] != h.ref)
+		return position(h);
+	if (slot >= previous.refs.count() || previous.refs[slot] != h.ref)
+		return current.positions[slot];
+	return math::lerp(previous.positions[slot], current.positions[slot], alpha);
+}
+
+
+math::Quat TransformManager::interpolatedRotation(Instance h, float alpha) const {
+	auto slot = instanceData_.slotIndex(h);
+	const auto& current = *currentTick_;
+	const auto& previous = *previousTick_;
+
+	if (slot >= current.refs.count() || current.refs[slot] != h.ref)
+		return rotation(h);
+	if (slot >= previous.refs.count() || previous.refs[slot] != h.ref)
+		return current.rotations[slot];
+	return math::nlerp(previous.rotations[slot], current.rotations[slot], alpha);
+}
+
+
+math::Mat4 TransformManager::interpolatedModelMatrix(Instance h, float alpha) const {
+	math::Mat4 local;
+	math::composeTRS(interpolatedPosition(h, alpha), interpolatedRotation(h, alpha), scale(h), local);
+
+	auto parentInstance = parent(h);
+	if (parentInstance.ref != 0 && valid(parentInstance)) {
+		return interpolatedModelMatrix(parentInstance, alpha) * local;
+	}
+	return local;
+}
+
+
 } // ns scene
 } // ns stardazed
@@ -11,13 +11,21 @@
 #include "math/Vector.hpp"
 #include "math/Matrix.hpp"
 #include "math/Quaternion.hpp"
-#include "container/MultiArrayBuffer.hpp"
+#include "scene/ComponentStore.hpp"
+#include "scene/EntityMap.hpp"
 #include "scene/Entity.hpp"
+#include "runtime/Jobs.hpp"
 
 namespace stardazed {
 namespace scene {
 
 
+enum class MatrixUpdateMode {
+	Immediate, // setters recompute the local matrix right away
+	Deferred   // setters only flag the instance, updateMatrices() recomputes it
+};
+
+
 struct TransformDescriptor {
 	math::Vec3 position = math::Vec3::zero();
 	math::Quat rotation = math::Quat::identity();
@@ -25,26 +33,67 @@ struct TransformDescriptor {
 };
 
 
+// Transforms are stored parent-before-child so that world matrices can be
+// computed in a single forward sweep in updateMatrices(). Setters update
+// the local matrix and flag the instance, the sweep recomputes the world matrix
+// of flagged instances and of all instances below them in the hierarchy.
+// Unparented instances also get their world matrix updated by the setters.
+// In Deferred mode the setters only flag the instance and updateMatrices()
+// first rebuilds all stale local matrices with the batch TRS kernel, so each
+// matrix is built at most once per update.
+
 class TransformManager {
 public:
 	using Instance = scene::Instance<TransformManager>;
 	
 private:
-	container::MultiArrayBuffer<
+	AlignedComponentStore<TransformManager,
 		Instance,   // parentHandle
 		math::Vec3, // position
 		math::Quat, // rotation
 		math::Vec3, // scale
-		math::Mat4  // modelMatrix
+		math::Mat4, // localMatrix
+		math::Mat4, // worldMatrix
+		uint8,      // flags
+		uint32      // changeCount
 	> instanceData_;
 
 	Instance* parentBase_;
 	math::Vec3* positionBase_;
 	math::Quat* rotationBase_;
 	math::Vec3* scaleBase_;
-	math::Mat4* modelMatrixBase_;
+	math::Mat4* localMatrixBase_;
+	math::Mat4* worldMatrixBase_;
+	uint8* flagsBase_;
+	uint32* changeCountBase_;
+
+	static constexpr uint8 localChangedFlag = 1; // set by setters, cleared by updateMatrices
+	static constexpr uint8 worldChangedFlag = 2; // set by updateMatrices for recomputed world matrices
+	static constexpr uint8 trsChangedFlag = 4;   // local matrix is stale, Deferred mode only
+
+	EntityMap<Instance> entityMap_;
+
+	// positions and rotations per slot after the last two simulation ticks
+	struct TickState {
+		Array<uint32> refs; // handle of the instance in each slot, 0 if none
+		Array<math::Vec3> positions;
+		Array<math::Quat> rotations;
+
+		explicit TickState(memory::Allocator&);
+	};
+	TickState tickStateA_, tickStateB_;
+	TickState* previousTick_ = &tickStateA_;
+	TickState* currentTick_ = &tickStateB_;
+
+	bool hierarchyOrderValid_ = true;
+	MatrixUpdateMode updateMode_ = MatrixUpdateMode::Immediate;
+	jobs::JobSystem* jobSystem_ = nullptr;
 	
 	void rebase();
+	uint32 indexOf(Instance h) const { return instanceData_.indexOf(h); }
+	void localChanged(uint32 index);
+	void trsChanged(uint32 index);
+	void sortHierarchy();
 
 public:
 	TransformManager();
@@ -52,16 +101,25 @@ public:
 	static const Instance root() { return {0}; }
 
 	// -- array access
-	uint32 count() const { return instanceData_.count(); }
+	uint32 count() const { return instanceData_.liveCount(); }
 	Instance assign(Entity linkedEntity, const Instance parent = root());
 	Instance assign(Entity linkedEntity, const TransformDescriptor&, const Instance parent = root());
 
+	// children of a destroyed transform become roots in the next updateMatrices()
+	void destroy(Entity linkedEntity);
+	bool valid(Instance h) const { return instanceData_.valid(h); }
+
 	// -- single instance data access
-	Instance parent(Instance h) const { return parentBase_[h.ref]; }
-	const math::Vec3& position(Instance h) const { return positionBase_[h.ref]; }
-	const math::Quat& rotation(Instance h) const { return rotationBase_[h.ref]; }
-	const math::Vec3& scale(Instance h) const { return scaleBase_[h.ref]; }
-	const math::Mat4& modelMatrix(Instance h) const { return modelMatrixBase_[h.ref]; }
+	Instance parent(Instance h) const { return parentBase_[indexOf(h)]; }
+	const math::Vec3& position(Instance h) const { return positionBase_[indexOf(h)]; }
+	const math::Quat& rotation(Instance h) const { return rotationBase_[indexOf(h)]; }
+	const math::Vec3& scale(Instance h) const { return scaleBase_[indexOf(h)]; }
+	// in Deferred mode the matrices are those of the last updateMatrices() call
+	const math::Mat4& localMatrix(Instance h) const { return localMatrixBase_[indexOf(h)]; }
+
+	// world matrix as of the last updateMatrices() call
+	const math::Mat4& modelMatrix(Instance h) const { return worldMatrixBase_[indexOf(h)]; }
+	bool worldChanged(Instance h) const { return (flagsBase_[indexOf(h)] & worldChangedFlag) != 0; }
 
 	void setParent(const Instance, const Instance newParent);
 	void setPosition(const Instance, const math::Vec3&);
@@ -69,6 +127,10 @@ public:
 	void setPositionAndRotation(const Instance, const math::Vec3&, const math::Quat&);
 	void setScale(const Instance h, const math::Vec3& newScale);
 
+	// same as setPosition() for count instances given by denseIndex(), may be
+	// called from several threads at once for disjoint sets of instances
+	void setPositions(const uint32* denseIndexes, const math::Vec3* newPositions, uint32 count);
+
 	// -- single instance state modifiers
 	Instance forEntity(Entity) const;
 	
@@ -103,6 +165,45 @@ public:
 	}
 
 	void lookAt(const Instance h, const math::Vec3& target, const math::Vec3& up);
+
+	// -- dense SoA access for batch passes over many instances, an index from
+	// denseIndex() is valid until the next assign, destroy or updateMatrices call.
+	// Handles kept by other managers can outlive their transform, check valid() first.
+	uint32 denseIndex(Instance h) const { return indexOf(h); }
+	Instance instanceAt(uint32 index) const { return instanceData_.instanceAt(index); }
+	const math::Vec3* positions() const { return positionBase_; }
+	const math::Quat* rotations() const { return rotationBase_; }
+	const math::Vec3* scales() const { return scaleBase_; }
+	const math::Mat4* worldMatrices() const { return worldMatrixBase_; }
+
+	// incremented by every setter call on the instance and every time updateMatrices()
+	// recomputes its world matrix, compare it to a value kept from an earlier
+	// frame to see if the instance moved since then
+	uint32 changeCountAtIndex(uint32 index) const { return changeCountBase_[index]; }
+
+	// stable per-instance slots, see ComponentStore
+	static uint32 slotIndex(Instance h) { return decltype(instanceData_)::slotIndex(h); }
+	uint32 slotCount() const { return instanceData_.slotCount(); }
+
+	// -- matrix updates, call updateMatrices() once per frame after all transforms have been updated
+	MatrixUpdateMode matrixUpdateMode() const { return updateMode_; }
+	void setMatrixUpdateMode(MatrixUpdateMode);
+	void updateMatrices();
+
+	// with a job system set, updateMatrices() rebuilds the stale local matrices
+	// in parallel, the world matrix sweep stays serial (parents come first)
+	jobs::JobSystem* jobSystem() const { return jobSystem_; }
+	void setJobSystem(jobs::JobSystem* jobSystem) { jobSystem_ = jobSystem; }
+
+	// -- interpolation between fixed simulation ticks
+	// captureTickState() stores the positions and rotations after a tick and
+	// keeps those of the tick before it. The interpolated getters blend from the
+	// previous to the current tick by alpha, instances that were not present in
+	// both ticks use their most recent state. Scales are not interpolated.
+	void captureTickState();
+	math::Vec3 interpolatedPosition(Instance, float alpha) const;
+	math::Quat interpolatedRotation(Instance, float alpha) const;
+	math::Mat4 interpolatedModelMatrix(Instance, float alpha) const;
 };
 
 
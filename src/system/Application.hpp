@@ -8,7 +8,9 @@
 
 #include "system/Config.hpp"
 
-#if SD_PLATFORM_OSX
+#if SD_HEADLESS
+#	include "system/posix_Application.hpp"
+#elif SD_PLATFORM_OSX
 #	include "mac_Application.hpp"
 #endif
 
@@ -0,0 +1,38 @@
+// ------------------------------------------------------------------
+// system::CPU.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "system/CPU.hpp"
+
+namespace stardazed {
+namespace cpu {
+
+
+static Features detectFeatures() {
+	Features f {};
+
+#if SD_ARCH_X86_64
+	// also checks that the OS saves the AVX register state
+	__builtin_cpu_init();
+	f.sse41 = __builtin_cpu_supports("sse4.1") != 0;
+	f.avx = __builtin_cpu_supports("avx") != 0;
+	f.avx2 = __builtin_cpu_supports("avx2") != 0;
+	f.fma = __builtin_cpu_supports("fma") != 0;
+#elif SD_ARCH_ARM64
+	// NEON is mandatory in AArch64
+	f.neon = true;
+#endif
+
+	return f;
+}
+
+
+const Features& features() {
+	static const Features features_s = detectFeatures();
+	return features_s;
+}
+
+
+} // ns cpu
+} // ns stardazed
@@ -0,0 +1,34 @@
+// ------------------------------------------------------------------
+// system::CPU - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_SYSTEM_CPU_H
+#define SD_SYSTEM_CPU_H
+
+#include "system/Config.hpp"
+
+namespace stardazed {
+namespace cpu {
+
+
+// Instruction set extensions usable at runtime, i.e. supported by both
+// the processor and the OS. Kernels compiled for an extension that is not
+// enabled for the whole build must only be called if the flag is set.
+
+struct Features {
+	bool8 sse41;
+	bool8 avx;
+	bool8 avx2;
+	bool8 fma;
+	bool8 neon;
+};
+
+
+const Features& features();
+
+
+} // ns cpu
+} // ns stardazed
+
+#endif
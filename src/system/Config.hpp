@@ -12,6 +12,7 @@
 #ifdef _WIN64
 #	define SD_PLATFORM_WINDOWS 1
 #	define SD_PLATFORM_OSX     0
+#	define SD_PLATFORM_LINUX   0
 #elif _WIN32
 #	error "32-bit Windows is not supported"
 #elif __APPLE__
@@ -23,19 +24,63 @@
 #	else
 #		define SD_PLATFORM_WINDOWS 0
 #		define SD_PLATFORM_OSX     1
+#		define SD_PLATFORM_LINUX   0
 #	endif
+#elif __linux__
+#	define SD_PLATFORM_WINDOWS 0
+#	define SD_PLATFORM_OSX     0
+#	define SD_PLATFORM_LINUX   1
 #else
 #	error "This platform is not supported"
 #endif
 
 
+// -- cpu architecture
+
+#if defined(__x86_64__) || defined(_M_X64)
+#	define SD_ARCH_X86_64 1
+#	define SD_ARCH_ARM64  0
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#	define SD_ARCH_X86_64 0
+#	define SD_ARCH_ARM64  1
+#else
+#	define SD_ARCH_X86_64 0
+#	define SD_ARCH_ARM64  0
+#endif
+
+
 // -- render engine
+// Headless builds use the null render context and no windowing, so they can
+// run on machines without a GPU. Platforms without a native backend are
+// headless by default, define SD_HEADLESS to 1 to force it elsewhere.
+
+#ifndef SD_HEADLESS
+#	define SD_HEADLESS (! SD_PLATFORM_OSX)
+#endif
 
-#define SD_RENDER_ENGINE_OPENGL 1
+#if SD_HEADLESS
+#	define SD_RENDER_ENGINE_OPENGL 0
+#	define SD_RENDER_ENGINE_NULL   1
+#else
+#	define SD_RENDER_ENGINE_OPENGL 1
+#	define SD_RENDER_ENGINE_NULL   0
+#endif
+
+
+// -- profiling
+// SD_PROFILE_SCOPE compiles to nothing if SD_PROFILER is defined as 0
+
+#ifndef SD_PROFILER
+#	define SD_PROFILER 1
+#endif
 
 
 // -- compiler features
 
+#ifndef __has_feature
+#	define __has_feature(x) 0
+#endif
+
 #if __has_feature(nullability) || (__apple_build_version__ >= 6020053)
 #	define NON_NULL __nonnull
 #	define NULLABLE __nullable
@@ -20,9 +20,21 @@ inline void log(const std::string& msg) {
 	log(msg.c_str());
 }
 
+namespace detail {
+	// Per-thread buffer the message is built in, it keeps its capacity between
+	// calls. log() is called from worker threads, so the main thread's
+	// FrameAllocator cannot be used for this.
+	inline std::string& logScratch() {
+		thread_local std::string scratch_s;
+		return scratch_s;
+	}
+}
+
 template <typename... Ts>
 inline void log(Ts&&... ts) {
-	auto str = concatAsString(std::forward<Ts>(ts)...);
+	auto& str = detail::logScratch();
+	str.clear();
+	detail::concatAsString(str, std::forward<Ts>(ts)...);
 	log(str.c_str());
 }
 
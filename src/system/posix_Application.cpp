@@ -0,0 +1,45 @@
+// ------------------------------------------------------------------
+// posix_Application - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "system/posix_Application.hpp"
+#include "runtime/RunLoop.hpp"
+
+namespace stardazed {
+
+
+volatile std::sig_atomic_t Application::quit_ = 0;
+bool Application::active_ = true;
+
+
+void Application::setActive(bool active) {
+	active_ = active;
+	if (active_)
+		defaultRunLoop().start();
+	else
+		defaultRunLoop().stop();
+}
+
+
+const fs::Path& Application::dataPath() {
+	static fs::Path dataPath_s { "data/" };
+	return dataPath_s;
+}
+
+
+static void quitSignalHandler(int) {
+	Application::quitNow();
+}
+
+
+void Application::init() {
+	// -- let the main loop exit gracefully on Ctrl-C or a kill
+	std::signal(SIGINT, quitSignalHandler);
+	std::signal(SIGTERM, quitSignalHandler);
+
+	active_ = true;
+}
+
+
+} // ns stardazed
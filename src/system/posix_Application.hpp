@@ -0,0 +1,45 @@
+// ------------------------------------------------------------------
+// posix_Application - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#ifndef SD_SYSTEM_POSIX_APPLICATION_H
+#define SD_SYSTEM_POSIX_APPLICATION_H
+
+#include "system/Config.hpp"
+#include "filesystem/FileSystem.hpp"
+
+#include <csignal>
+
+namespace stardazed {
+
+
+// Windowless application for headless builds. There is no system event loop,
+// the quit flag is set by SIGINT and SIGTERM or by calling quitNow().
+
+class Application {
+	Application() = delete;
+
+	static volatile std::sig_atomic_t quit_;
+	static bool active_;
+
+public:
+	static void init();
+	
+	// -- resources
+	static const fs::Path& dataPath();
+
+	// -- a headless app is always active unless told otherwise
+	static void setActive(bool active);
+	static bool isActive() { return active_; }
+	
+	// -- handling of Quit signal from system or user
+	static bool shouldQuit() { return quit_ != 0; }
+	static void quitNow() { quit_ = 1; }
+	static void resetShouldQuitFlag() { quit_ = 0; }
+};
+
+
+} // ns stardazed
+
+#endif
@@ -0,0 +1,17 @@
+// ------------------------------------------------------------------
+// posix_Logging - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "system/Logging.hpp"
+#include <cstdio>
+
+namespace stardazed {
+
+
+void log(const char* msg) {
+	std::fprintf(stderr, "%s\n", msg);
+}
+
+
+} // ns stardazed
@@ -0,0 +1,21 @@
+// ------------------------------------------------------------------
+// system::posix_Time.cpp - stardazed
+// (c) 2016 by Arthur Langereis
+// ------------------------------------------------------------------
+
+#include "system/Time.hpp"
+#include <time.h>
+
+namespace stardazed {
+namespace time {
+
+
+Time now() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return Time(ts.tv_sec) + Time(ts.tv_nsec) / 1e9;
+}
+
+
+} // ns time
+} // ns stardazed
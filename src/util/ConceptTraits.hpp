@@ -55,9 +55,8 @@ Class(Class&&) noexcept = default;            \
 Class& operator=(Class&&) noexcept = default;
 
 
-// Explicitly unused parameter
-#define SD_UNUSED_PARAM_HELPER(p) #p
-#define SD_UNUSED_PARAM(param) _Pragma(SD_UNUSED_PARAM_HELPER(unused(param)))
+// Explicitly unused parameter, also for parameters only used in asserts
+#define SD_UNUSED_PARAM(param) static_cast<void>(param);
 
 
 } // ns stardazed
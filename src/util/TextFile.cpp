@@ -4,11 +4,13 @@
 // ------------------------------------------------------------------
 
 #include "util/TextFile.hpp"
+#include "runtime/Profiler.hpp"
 
 namespace stardazed {
 
 
 std::string readTextFile(fs::Path path) {
+	SD_PROFILE_SCOPE("readTextFile");
 	fs::FileReadStream file { path };
 	auto fileSize = path.fileSize();
 	